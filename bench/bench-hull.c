@@ -0,0 +1,294 @@
+// native benchmark for hull.c, writes one JSON object per line to stdout
+// usage: bench-hull [--algos legacy,quick,parallel] [--dists sphere,cube,...] [--sizes 100,1000,...]
+//   [--threads N] [--max-seconds S] [--min-seconds S] [--phases]
+// --phases times the phases of the legacy and quick builders
+#include <stdio.h>
+#include <stdbool.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static double now() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+typedef struct {
+  double calcExtremes;
+  double calcFacingPlanes;
+  double calcOutsideEdges;
+} PhaseTimes;
+
+static bool timePhases = false;
+static PhaseTimes phaseTimes;
+
+#define HULL_PHASE_BEGIN(phase) const double phase##Start = timePhases ? now() : 0.
+#define HULL_PHASE_END(phase) if (timePhases) { phaseTimes.phase += now() - phase##Start; }
+
+#include "../src/hull.c"
+
+#define MAX_LIST (16)
+
+typedef enum { SPHERE, CUBE, GAUSSIAN, CLUSTERED, NEAR_COPLANAR, DUPLICATES, NUM_DISTRIBUTIONS } Distribution;
+static const char* DISTRIBUTION_NAMES[] = { "sphere", "cube", "gaussian", "clustered", "near-coplanar", "duplicates" };
+
+typedef enum { LEGACY, QUICK, PARALLEL, NUM_ALGOS } Algo;
+static const char* ALGO_NAMES[] = { "legacy", "quick", "parallel" };
+
+// xorshift32, the same generator is used by bench/bench-hull.js so both see the same distributions
+static unsigned randomState = 1;
+
+static float randomFloat() {
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return (randomState >> 8)*(1.f/16777216.f);
+}
+
+static float randomRange(const float lo, const float hi) {
+  return lo + (hi - lo)*randomFloat();
+}
+
+static float randomGaussian() {
+  const float u = randomFloat() + 1e-7f;
+  const float v = randomFloat();
+  return sqrtf(-2.f*logf(u))*cosf(2.f*(float)M_PI*v);
+}
+
+static void generatePoints(float* vertices, const int numPoints, const Distribution dist) {
+  const int NUM_CLUSTERS = 16;
+  const int numUnique = numPoints/100 > 8 ? numPoints/100 : 8;
+  float clusters[16*3];
+
+  randomState = 1;
+
+  for (int i = 0; i < NUM_CLUSTERS*3; i++) {
+    clusters[i] = randomRange(-1.f, 1.f);
+  }
+
+  for (int i = 0; i < numPoints; i++) {
+    float* v = vertices + i*3;
+
+    switch (dist) {
+      case SPHERE: {
+        do {
+          v[0] = randomGaussian(), v[1] = randomGaussian(), v[2] = randomGaussian();
+        } while (dot(v, v) < 1e-6f);
+        multiplyScalar(v, v, 1.f/sqrtf(dot(v, v)));
+        break;
+      }
+      case CUBE:
+        v[0] = randomRange(-1.f, 1.f), v[1] = randomRange(-1.f, 1.f), v[2] = randomRange(-1.f, 1.f);
+        break;
+      case GAUSSIAN:
+        v[0] = randomGaussian(), v[1] = randomGaussian(), v[2] = randomGaussian();
+        break;
+      case CLUSTERED: {
+        const float* center = clusters + (int)(randomFloat()*NUM_CLUSTERS)*3;
+        v[0] = center[0] + 0.05f*randomGaussian(), v[1] = center[1] + 0.05f*randomGaussian(), v[2] = center[2] + 0.05f*randomGaussian();
+        break;
+      }
+      case NEAR_COPLANAR:
+        v[0] = randomRange(-1.f, 1.f), v[1] = randomRange(-1.f, 1.f), v[2] = randomRange(-1e-4f, 1e-4f);
+        break;
+      case DUPLICATES:
+        // copies of the first numUnique points
+        if (i < numUnique) {
+          v[0] = randomRange(-1.f, 1.f), v[1] = randomRange(-1.f, 1.f), v[2] = randomRange(-1.f, 1.f);
+        } else {
+          memcpy(v, vertices + (int)(randomFloat()*numUnique)*3, 3*sizeof(float));
+        }
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+static long peakRSSKiB() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return usage.ru_maxrss/1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+static int parseList(int* outValues, const char* arg, const char** names, const int numNames) {
+  int count = 0;
+  char buffer[256];
+  strncpy(buffer, arg, sizeof(buffer) - 1);
+  buffer[sizeof(buffer) - 1] = '\0';
+
+  for (char* token = strtok(buffer, ","); token && count < MAX_LIST; token = strtok(NULL, ",")) {
+    if (names == NULL) {
+      outValues[count++] = (int)atof(token);
+      continue;
+    }
+
+    for (int i = 0; i < numNames; i++) {
+      if (strcmp(token, names[i]) == 0) {
+        outValues[count++] = i;
+      }
+    }
+  }
+
+  return count;
+}
+
+typedef struct {
+  double seconds; // per build
+  int result; // of the last build, -3 if out of memory
+} RowResult;
+
+// builds the hull of numPoints points of the distribution until minSeconds have passed, and prints one JSON line
+static RowResult benchRow(const Algo algo, const Distribution dist, const int numPoints, const int numThreads, const double minSeconds) {
+  RowResult row = { 0., -3 };
+  const int numOutIndices = calcMaxHullIndices(numPoints*3, 3);
+  float* vertices = malloc((size_t)numPoints*3*sizeof(float));
+  int* outIndices = malloc((size_t)numOutIndices*sizeof(int));
+  HullContext* ctx = hullContextCreate(0, 0);
+  HullThreadPool* pool = hullThreadPoolCreate(numThreads);
+  if (vertices == NULL || outIndices == NULL || ctx == NULL || pool == NULL) {
+    fprintf(stderr, "out of memory for %d points\n", numPoints);
+    free(vertices);
+    free(outIndices);
+    hullContextDestroy(ctx);
+    hullThreadPoolDestroy(pool);
+    return row;
+  }
+
+  generatePoints(vertices, numPoints, dist);
+  hullContextSetFlags(ctx, timePhases ? HULL_COLLECT_STATS : 0);
+  memset(&phaseTimes, 0, sizeof(phaseTimes));
+
+  int numRuns = 0;
+  int result = 0;
+  const double start = now();
+  double elapsed = 0.;
+
+  do {
+    switch (algo) {
+      case LEGACY: result = generateHullTrianglesLegacy(outIndices, vertices, numPoints*3, 3); break;
+      case QUICK: result = generateHullTrianglesWithContext(ctx, outIndices, vertices, numPoints*3, 3); break;
+      case PARALLEL: result = generateHullTrianglesParallel(pool, ctx, outIndices, vertices, numPoints*3, 3); break;
+      default: break;
+    }
+    numRuns++;
+    elapsed = now() - start;
+  } while (elapsed < minSeconds);
+
+  const double seconds = elapsed/numRuns;
+  printf("{\"impl\":\"c\",\"algo\":\"%s\",\"dist\":\"%s\",\"points\":%d,\"runs\":%d,\"seconds\":%.9f,\"pointsPerSec\":%.1f,\"result\":%d,\"contextBytes\":%d,\"peakRSSKiB\":%ld",
+    ALGO_NAMES[algo], DISTRIBUTION_NAMES[dist], numPoints, numRuns, seconds, numPoints/seconds, result,
+    algo == LEGACY ? 0 : hullContextHighWaterBytes(ctx), peakRSSKiB());
+
+  if (timePhases && algo == LEGACY) {
+    printf(",\"phases\":{\"calcExtremes\":%.9f,\"calcFacingPlanes\":%.9f,\"calcOutsideEdges\":%.9f}",
+      phaseTimes.calcExtremes/numRuns, phaseTimes.calcFacingPlanes/numRuns, phaseTimes.calcOutsideEdges/numRuns);
+  } else if (timePhases && algo == QUICK) {
+    // from the last run
+    const HullStats* stats = hullContextGetStats(ctx);
+    printf(",\"phases\":{\"extremes\":%.9f,\"seed\":%.9f,\"visibility\":%.9f,\"horizon\":%.9f,\"rebuild\":%.9f}",
+      stats->extremesSeconds, stats->seedSeconds, stats->visibilitySeconds, stats->horizonSeconds, stats->rebuildSeconds);
+    printf(",\"stats\":{\"expansions\":%.0f,\"droppedPoints\":%.0f,\"facesCreated\":%.0f,\"peakLiveFaces\":%.0f,\"horizonEdges\":%.0f,\"maxHorizonEdges\":%.0f}",
+      stats->numExpansions, stats->numDroppedPoints, stats->numFacesCreated, stats->peakLiveFaces, stats->numHorizonEdges, stats->maxHorizonEdges);
+  }
+
+  printf("}\n");
+  fflush(stdout);
+
+  free(vertices);
+  free(outIndices);
+  hullThreadPoolDestroy(pool);
+  hullContextDestroy(ctx);
+
+  row.seconds = seconds;
+  row.result = result;
+  return row;
+}
+
+// runs benchRow() in a child process, so peakRSSKiB is the peak of that row alone rather than of every row so far
+static RowResult benchRowInChild(const Algo algo, const Distribution dist, const int numPoints, const int numThreads, const double minSeconds) {
+  RowResult row = { 0., -3 };
+  int fds[2];
+  if (pipe(fds) != 0) {
+    return row;
+  }
+
+  const pid_t pid = fork();
+  if (pid == 0) {
+    close(fds[0]);
+    row = benchRow(algo, dist, numPoints, numThreads, minSeconds);
+    const bool isWritten = write(fds[1], &row, sizeof(row)) == sizeof(row);
+    _exit(isWritten ? 0 : 1);
+  }
+
+  close(fds[1]);
+  if (pid < 0 || read(fds[0], &row, sizeof(row)) != sizeof(row)) {
+    row = (RowResult){ 0., -3 };
+  }
+  close(fds[0]);
+
+  if (pid > 0) {
+    waitpid(pid, NULL, 0);
+  }
+
+  return row;
+}
+
+int main(int argc, char** argv) {
+  int algos[MAX_LIST] = { LEGACY, QUICK, PARALLEL };
+  int dists[MAX_LIST] = { SPHERE, CUBE, GAUSSIAN, CLUSTERED, NEAR_COPLANAR, DUPLICATES };
+  int sizes[MAX_LIST] = { 100, 1000, 10000, 100000, 1000000, 10000000 };
+  int numAlgos = 3, numDists = NUM_DISTRIBUTIONS, numSizes = 6;
+  int numThreads = 4;
+  double maxSeconds = 10.; // skip larger sizes once a build is predicted to take longer than this
+  double minSeconds = 0.2; // repeat small builds until they take at least this long
+
+  for (int i = 1; i < argc; i++) {
+    const char* value = i + 1 < argc ? argv[i + 1] : "";
+    if (strcmp(argv[i], "--algos") == 0) numAlgos = parseList(algos, value, ALGO_NAMES, NUM_ALGOS), i++;
+    else if (strcmp(argv[i], "--dists") == 0) numDists = parseList(dists, value, DISTRIBUTION_NAMES, NUM_DISTRIBUTIONS), i++;
+    else if (strcmp(argv[i], "--sizes") == 0) numSizes = parseList(sizes, value, NULL, 0), i++;
+    else if (strcmp(argv[i], "--threads") == 0) numThreads = atoi(value), i++;
+    else if (strcmp(argv[i], "--max-seconds") == 0) maxSeconds = atof(value), i++;
+    else if (strcmp(argv[i], "--min-seconds") == 0) minSeconds = atof(value), i++;
+    else if (strcmp(argv[i], "--phases") == 0) timePhases = true;
+    else {
+      fprintf(stderr, "unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+
+  for (int d = 0; d < numDists; d++) {
+    for (int a = 0; a < numAlgos; a++) {
+      double previousSeconds = 0.;
+      int previousSize = 0;
+
+      for (int s = 0; s < numSizes; s++) {
+        const int numPoints = sizes[s];
+
+        // assume linear growth, the legacy builder is worse than that
+        if (previousSize > 0 && previousSeconds*numPoints/previousSize > maxSeconds) {
+          break;
+        }
+
+        const RowResult row = benchRowInChild(algos[a], dists[d], numPoints, numThreads, minSeconds);
+
+        // out of memory, or the legacy builder stopped at MAX_FACES
+        if (row.result == -3) {
+          break;
+        }
+
+        previousSeconds = row.seconds;
+        previousSize = numPoints;
+      }
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,127 @@
+// benchmark for src/hull.js, writes one JSON object per line in the same format as bench/bench-hull.c
+// usage: node build/bench-bundle.js [--dists sphere,cube,...] [--sizes 100,1000,...] [--max-seconds S] [--min-seconds S]
+import * as hull from "../src/hull.js"
+
+const DISTRIBUTIONS = ["sphere", "cube", "gaussian", "clustered", "near-coplanar", "duplicates"]
+
+// xorshift32, the same generator as bench/bench-hull.c
+let randomState = 1
+
+function randomFloat() {
+  randomState ^= randomState << 13
+  randomState ^= randomState >>> 17
+  randomState ^= randomState << 5
+  randomState >>>= 0
+  return (randomState >>> 8)/16777216
+}
+
+function randomRange(lo, hi) {
+  return lo + (hi - lo)*randomFloat()
+}
+
+function randomGaussian() {
+  const u = randomFloat() + 1e-7
+  const v = randomFloat()
+  return Math.sqrt(-2*Math.log(u))*Math.cos(2*Math.PI*v)
+}
+
+/** @type {(numPoints: number, dist: string) => Float32Array} */
+function generatePoints(numPoints, dist) {
+  const NUM_CLUSTERS = 16
+  const numUnique = Math.max(8, Math.floor(numPoints/100))
+  const vertices = new Float32Array(numPoints*3)
+
+  randomState = 1
+  const clusters = Array.from({length: NUM_CLUSTERS*3}, () => randomRange(-1, 1))
+
+  for (let i = 0; i < numPoints*3; i += 3) {
+    switch (dist) {
+      case "sphere": {
+        let x, y, z, length
+        do {
+          x = randomGaussian(), y = randomGaussian(), z = randomGaussian()
+          length = Math.sqrt(x*x + y*y + z*z)
+        } while (length < 1e-3)
+        vertices.set([x/length, y/length, z/length], i)
+        break
+      }
+      case "cube":
+        vertices.set([randomRange(-1, 1), randomRange(-1, 1), randomRange(-1, 1)], i)
+        break
+      case "gaussian":
+        vertices.set([randomGaussian(), randomGaussian(), randomGaussian()], i)
+        break
+      case "clustered": {
+        const c = Math.floor(randomFloat()*NUM_CLUSTERS)*3
+        vertices.set([clusters[c] + 0.05*randomGaussian(), clusters[c+1] + 0.05*randomGaussian(), clusters[c+2] + 0.05*randomGaussian()], i)
+        break
+      }
+      case "near-coplanar":
+        vertices.set([randomRange(-1, 1), randomRange(-1, 1), randomRange(-1e-4, 1e-4)], i)
+        break
+      case "duplicates":
+        // copies of the first numUnique points
+        if (i < numUnique*3) {
+          vertices.set([randomRange(-1, 1), randomRange(-1, 1), randomRange(-1, 1)], i)
+        } else {
+          const j = Math.floor(randomFloat()*numUnique)*3
+          vertices.copyWithin(i, j, j + 3)
+        }
+        break
+    }
+  }
+
+  return vertices
+}
+
+function parseArgs(argv) {
+  const options = { dists: DISTRIBUTIONS, sizes: [100, 1000, 10000, 100000, 1000000, 10000000], maxSeconds: 10, minSeconds: 0.2 }
+
+  for (let i = 0; i < argv.length; i++) {
+    const value = argv[i + 1] || ""
+    switch (argv[i]) {
+      case "--dists": options.dists = value.split(","); i++; break
+      case "--sizes": options.sizes = value.split(",").map(Number); i++; break
+      case "--max-seconds": options.maxSeconds = Number(value); i++; break
+      case "--min-seconds": options.minSeconds = Number(value); i++; break
+      default: throw Error(`unknown option ${argv[i]}`)
+    }
+  }
+
+  return options
+}
+
+const options = parseArgs(process.argv.slice(2))
+
+for (let dist of options.dists) {
+  let previousSeconds = 0
+  let previousSize = 0
+
+  for (let numPoints of options.sizes) {
+    // assume linear growth, the hull is worse than that
+    if (previousSize > 0 && previousSeconds*numPoints/previousSize > options.maxSeconds) {
+      break
+    }
+
+    const vertices = generatePoints(numPoints, dist)
+    const start = performance.now()
+    let elapsed = 0
+    let numRuns = 0
+    let indices
+
+    do {
+      indices = hull.generateHullTriangles(vertices)
+      numRuns++
+      elapsed = (performance.now() - start)/1000
+    } while (elapsed < options.minSeconds)
+
+    const seconds = elapsed/numRuns
+    console.log(JSON.stringify({
+      impl: "js", algo: "legacy", dist, points: numPoints, runs: numRuns, seconds, pointsPerSec: numPoints/seconds,
+      result: indices ? indices.length : -2, contextBytes: 0, peakRSSKiB: process.resourceUsage().maxRSS,
+    }))
+
+    previousSeconds = seconds
+    previousSize = numPoints
+  }
+}
@@ -0,0 +1,21 @@
+// joins the JSON lines of two benchmark runs (e.g. bench-hull.c and bench-hull.js) on algo, dist and points,
+// and writes one JSON object per line with the speedup of the first over the second
+// usage: node bench/compare-hull.js first.jsonl second.jsonl
+const fs = require("fs")
+
+function readLines(filename) {
+  return fs.readFileSync(filename, "utf8").split("\n").filter(line => line.startsWith("{")).map(line => JSON.parse(line))
+}
+
+const [firstFile, secondFile] = process.argv.slice(2)
+const second = readLines(secondFile)
+
+for (let a of readLines(firstFile)) {
+  for (let b of second.filter(b => b.dist === a.dist && b.points === a.points)) {
+    console.log(JSON.stringify({
+      dist: a.dist, points: a.points, first: `${a.impl}-${a.algo}`, second: `${b.impl}-${b.algo}`,
+      firstSeconds: a.seconds, secondSeconds: b.seconds, speedup: b.seconds/a.seconds,
+      firstPeakRSSKiB: a.peakRSSKiB, secondPeakRSSKiB: b.peakRSSKiB,
+    }))
+  }
+}
@@ -0,0 +1,656 @@
+// Broadphase over many bodies, compile this file instead of collision.c to get hull.c, collision.c and this
+#include "collision.c"
+
+// Broadphase
+// Finds the pairs of bodies whose axis aligned bounds overlap, as candidates for the queries in collision.c.
+// Bodies are numbered by their position in the bounds given to broadphaseSetBounds() (6 floats per body, min
+// x,y,z then max x,y,z), or in the shapes given to broadphaseSetShapes().
+//
+// BROADPHASE_BVH keeps a bounding volume hierarchy, built top down with a binned surface area heuristic. The
+// nodes are a flat depth first array, so the left child of a node is the next node and only the right child
+// is stored, and a leaf's bodies are consecutive in a copy of the bounds kept in leaf order. When the same
+// number of bodies is set again the tree is refit bottom up (children always follow their parent, so a
+// reverse pass over the nodes does it), and only rebuilt once the refit tree has become REBUILD_COST_RATIO
+// times worse than it was when built. Pairs come from one traversal of the tree against itself.
+//
+// BROADPHASE_SAP keeps the bodies sorted by their minimum along the axis where the body centers are most
+// spread. Bodies that move a little between updates keep nearly the same order, so an insertion sort from
+// the last order is close to linear. Pairs come from a sweep along the sorted bodies, testing HULL_SIMD_WIDTH
+// bodies at once. For bodies of similar sizes this is usually the quicker of the two, but a body that is long
+// on the axis is tested against every body it spans, where the tree copes with mixed sizes.
+
+#define BROADPHASE_BVH (0)
+#define BROADPHASE_SAP (1)
+#define FLOATS_PER_BOUNDS (6)
+#define MAX_LEAF_BODIES (4)
+#define NUM_SAH_BINS (16)
+#define REBUILD_COST_RATIO (1.5f) // rebuild when the normalized SAH cost of a refit tree grows by this much
+#define MAX_SORT_MOVES (8) // moves per body before an insertion sort gives up and sorts from scratch
+
+typedef struct {
+  float min[3];
+  int index; // right child of an internal node (the left child is the next node), or a leaf's first body
+  float max[3];
+  int count; // bodies in a leaf, 0 for an internal node
+} BvhNode;
+
+typedef struct {
+  float key;
+  int body;
+} SortKey;
+
+typedef struct Broadphase {
+  int mode;
+  int numBodies;
+  int capacity; // bodies
+  bool needsBuild;
+  int* order; // bodies in leaf order, or sorted along axis
+  float* sortedBounds; // FLOATS_PER_BOUNDS per body in leaf order
+  float* sweepBounds; // FLOATS_PER_BOUNDS rows of capacity + HULL_SIMD_WIDTH, each one coordinate of the sorted bounds
+  float* bounds; // world bounds from broadphaseSetShapes()
+  float* centers; // build scratch, 3 per body
+  SortKey* sortKeys; // sort scratch
+  BvhNode* nodes;
+  int numNodes;
+  float builtCost;
+  int numBuilds;
+  int axis;
+  int* stack; // pairs of nodes still to traverse
+  int stackCapacity; // ints
+} Broadphase;
+
+EMSCRIPTEN_KEEPALIVE
+void broadphaseDestroy(Broadphase* bp) {
+  if (bp == NULL) {
+    return;
+  }
+
+  free(bp->order);
+  free(bp->sortedBounds);
+  free(bp->sweepBounds);
+  free(bp->bounds);
+  free(bp->centers);
+  free(bp->sortKeys);
+  free(bp->nodes);
+  free(bp->stack);
+  free(bp);
+}
+
+// mode is BROADPHASE_BVH or BROADPHASE_SAP. Returns NULL if the mode is unknown or out of memory
+EMSCRIPTEN_KEEPALIVE
+Broadphase* broadphaseCreate(const int mode) {
+  if (mode != BROADPHASE_BVH && mode != BROADPHASE_SAP) {
+    return NULL;
+  }
+
+  Broadphase* bp = calloc(1, sizeof(Broadphase));
+  if (bp == NULL) {
+    return NULL;
+  }
+
+  bp->mode = mode;
+  bp->needsBuild = true;
+  bp->stackCapacity = 256;
+  bp->stack = malloc(bp->stackCapacity*sizeof(int));
+  if (bp->stack == NULL) {
+    broadphaseDestroy(bp);
+    return NULL;
+  }
+
+  return bp;
+}
+
+bool reserveBodies(Broadphase* bp, const int numBodies) {
+  if (numBodies <= bp->capacity) {
+    return true;
+  }
+
+  const int capacity = numBodies > bp->capacity*2 ? numBodies : bp->capacity*2;
+  free(bp->order);
+  free(bp->sortedBounds);
+  free(bp->sweepBounds);
+  free(bp->bounds);
+  free(bp->centers);
+  free(bp->sortKeys);
+  free(bp->nodes);
+  bp->order = malloc(capacity*sizeof(int));
+  bp->sortedBounds = malloc(capacity*FLOATS_PER_BOUNDS*sizeof(float));
+  bp->sweepBounds = malloc((capacity + HULL_SIMD_WIDTH)*FLOATS_PER_BOUNDS*sizeof(float));
+  bp->bounds = malloc(capacity*FLOATS_PER_BOUNDS*sizeof(float));
+  bp->centers = malloc(capacity*3*sizeof(float));
+  bp->sortKeys = malloc(capacity*sizeof(SortKey));
+  bp->nodes = malloc((2*capacity - 1)*sizeof(BvhNode));
+
+  if (!bp->order || !bp->sortedBounds || !bp->sweepBounds || !bp->bounds || !bp->centers || !bp->sortKeys || !bp->nodes) {
+    bp->capacity = 0;
+    return false;
+  }
+
+  bp->capacity = capacity;
+  return true;
+}
+
+// half the surface area
+float calcHalfArea(const float* min, const float* max) {
+  const float dx = max[0] - min[0];
+  const float dy = max[1] - min[1];
+  const float dz = max[2] - min[2];
+  return dx*dy + dy*dz + dz*dx;
+}
+
+void setEmptyBounds(float* min, float* max) {
+  min[0] = min[1] = min[2] = FLT_MAX;
+  max[0] = max[1] = max[2] = -FLT_MAX;
+}
+
+void growBounds(float* min, float* max, const float* otherMin, const float* otherMax) {
+  for (int i = 0; i < 3; i++) {
+    min[i] = fminf(min[i], otherMin[i]);
+    max[i] = fmaxf(max[i], otherMax[i]);
+  }
+}
+
+bool isBoundsOverlapping(const float* a, const float* b) {
+  return (a[0] <= b[3]) & (a[1] <= b[4]) & (a[2] <= b[5]) & (b[0] <= a[3]) & (b[1] <= a[4]) & (b[2] <= a[5]);
+}
+
+
+// BVH
+
+// NaN offsets (from infinite bounds) go in the first bin
+int calcBin(const float offset, const float binScale) {
+  const float bin = offset*binScale;
+  return bin > 0.f ? (int)fminf(bin, NUM_SAH_BINS - 1) : 0;
+}
+
+// reorders order[first] to order[first + count - 1] so the body at first + count/2 has the median center along
+// axis, with no larger centers before it and no smaller ones after it
+void partitionAtMedian(int* order, const float* centers, const int axis, const int first, const int count) {
+  const int median = first + count/2;
+  int lo = first;
+  int hi = first + count - 1;
+
+  while (lo < hi) {
+    const float pivot = centers[order[lo + (hi - lo)/2]*3 + axis];
+    int i = lo;
+    int j = hi;
+
+    while (i <= j) {
+      while (centers[order[i]*3 + axis] < pivot) i++;
+      while (centers[order[j]*3 + axis] > pivot) j--;
+      if (i <= j) {
+        const int body = order[i];
+        order[i++] = order[j];
+        order[j--] = body;
+      }
+    }
+
+    if (median <= j) {
+      hi = j;
+    } else if (median >= i) {
+      lo = i;
+    } else {
+      break;
+    }
+  }
+}
+
+// builds the subtree of the bodies order[first] to order[first + count - 1], using twice the body centers.
+// Only the structure is built, the bounds are filled in by refitBvh()
+int buildBvhNode(Broadphase* bp, const float* bounds, const int first, const int count) {
+  const int nodeIndex = bp->numNodes++;
+  int* order = bp->order;
+  const float* centers = bp->centers;
+  BvhNode* node = bp->nodes + nodeIndex;
+
+  node->index = first;
+  node->count = count;
+  if (count <= MAX_LEAF_BODIES) {
+    return nodeIndex;
+  }
+
+  float centerMin[3], centerMax[3];
+  setEmptyBounds(centerMin, centerMax);
+  for (int i = first; i < first + count; i++) {
+    growBounds(centerMin, centerMax, centers + order[i]*3, centers + order[i]*3);
+  }
+
+  int axis = 0;
+  for (int i = 1; i < 3; i++) {
+    if (centerMax[i] - centerMin[i] > centerMax[axis] - centerMin[axis]) {
+      axis = i;
+    }
+  }
+
+  int numLeft = count/2;
+  const float extent = centerMax[axis] - centerMin[axis];
+
+  // with every center in about the same place there is nothing to choose, so split the bodies in half
+  if (extent > FLT_EPSILON*fmaxf(fabsf(centerMin[axis]), fabsf(centerMax[axis]))) {
+    const float binScale = NUM_SAH_BINS/extent;
+    int binCounts[NUM_SAH_BINS] = {0};
+    float binMin[NUM_SAH_BINS][3], binMax[NUM_SAH_BINS][3];
+
+    for (int i = 0; i < NUM_SAH_BINS; i++) {
+      setEmptyBounds(binMin[i], binMax[i]);
+    }
+
+    for (int i = first; i < first + count; i++) {
+      const float* body = bounds + order[i]*FLOATS_PER_BOUNDS;
+      const int bin = calcBin(centers[order[i]*3 + axis] - centerMin[axis], binScale);
+      binCounts[bin]++;
+      growBounds(binMin[bin], binMax[bin], body, body + 3);
+    }
+
+    // the cost of the bins right of each split, then sweep from the left for the cheapest split
+    float rightCosts[NUM_SAH_BINS];
+    float min[3], max[3];
+    int numRight = 0;
+    setEmptyBounds(min, max);
+
+    for (int i = NUM_SAH_BINS - 1; i > 0; i--) {
+      numRight += binCounts[i];
+      growBounds(min, max, binMin[i], binMax[i]);
+      rightCosts[i] = numRight > 0 ? calcHalfArea(min, max)*numRight : 0.f;
+    }
+
+    int bestSplit = 0;
+    float bestCost = FLT_MAX;
+    int numLeftOfSplit = 0;
+    setEmptyBounds(min, max);
+
+    for (int i = 1; i < NUM_SAH_BINS; i++) {
+      numLeftOfSplit += binCounts[i - 1];
+      growBounds(min, max, binMin[i - 1], binMax[i - 1]);
+
+      const float cost = calcHalfArea(min, max)*numLeftOfSplit + rightCosts[i];
+      if (numLeftOfSplit > 0 && numLeftOfSplit < count && cost < bestCost) {
+        bestCost = cost;
+        bestSplit = i;
+      }
+    }
+
+    // the first and last bins are never empty, so there is a split unless the bounds are so large (or not
+    // finite) that every cost is infinite. Then the bodies are split at the median center instead
+    numLeft = 0;
+    if (bestSplit > 0) {
+      int i = first;
+      int j = first + count - 1;
+      while (i <= j) {
+        if (calcBin(centers[order[i]*3 + axis] - centerMin[axis], binScale) < bestSplit) {
+          i++;
+        } else {
+          const int body = order[i];
+          order[i] = order[j];
+          order[j--] = body;
+        }
+      }
+
+      numLeft = i - first;
+    }
+
+    if (numLeft == 0 || numLeft == count) {
+      partitionAtMedian(order, centers, axis, first, count);
+      numLeft = count/2;
+    }
+  }
+
+  buildBvhNode(bp, bounds, first, numLeft);
+  const int right = buildBvhNode(bp, bounds, first + numLeft, count - numLeft);
+
+  bp->nodes[nodeIndex].index = right;
+  bp->nodes[nodeIndex].count = 0;
+  return nodeIndex;
+}
+
+// copies the bounds into leaf order, then grows each node around its children. Returns the SAH cost of the
+// tree relative to the area of the root
+float refitBvh(Broadphase* bp, const float* bounds) {
+  const int* order = bp->order;
+  float* sortedBounds = bp->sortedBounds;
+  float cost = 0.f;
+
+  for (int i = 0; i < bp->numBodies; i++) {
+    memcpy(sortedBounds + i*FLOATS_PER_BOUNDS, bounds + order[i]*FLOATS_PER_BOUNDS, FLOATS_PER_BOUNDS*sizeof(float));
+  }
+
+  for (int i = bp->numNodes - 1; i >= 0; i--) {
+    BvhNode* node = bp->nodes + i;
+
+    if (node->count > 0) {
+      setEmptyBounds(node->min, node->max);
+      for (int j = node->index; j < node->index + node->count; j++) {
+        growBounds(node->min, node->max, sortedBounds + j*FLOATS_PER_BOUNDS, sortedBounds + j*FLOATS_PER_BOUNDS + 3);
+      }
+      cost += calcHalfArea(node->min, node->max)*node->count;
+    } else {
+      const BvhNode* left = node + 1;
+      const BvhNode* right = bp->nodes + node->index;
+      for (int j = 0; j < 3; j++) {
+        node->min[j] = fminf(left->min[j], right->min[j]);
+        node->max[j] = fmaxf(left->max[j], right->max[j]);
+      }
+      cost += calcHalfArea(node->min, node->max);
+    }
+  }
+
+  const float rootArea = calcHalfArea(bp->nodes[0].min, bp->nodes[0].max);
+  return rootArea > 0.f ? cost/rootArea : 0.f;
+}
+
+void buildBvh(Broadphase* bp, const float* bounds) {
+  for (int i = 0; i < bp->numBodies; i++) {
+    const float* body = bounds + i*FLOATS_PER_BOUNDS;
+    bp->centers[i*3] = body[0] + body[3];
+    bp->centers[i*3 + 1] = body[1] + body[4];
+    bp->centers[i*3 + 2] = body[2] + body[5];
+    bp->order[i] = i;
+  }
+
+  bp->numNodes = 0;
+  buildBvhNode(bp, bounds, 0, bp->numBodies);
+  bp->builtCost = refitBvh(bp, bounds);
+  bp->numBuilds++;
+}
+
+bool isNodeOverlapping(const BvhNode* a, const BvhNode* b) {
+  return (a->min[0] <= b->max[0]) & (a->min[1] <= b->max[1]) & (a->min[2] <= b->max[2]) &
+    (b->min[0] <= a->max[0]) & (b->min[1] <= a->max[1]) & (b->min[2] <= a->max[2]);
+}
+
+void addPair(int* outPairs, const int maxPairs, int* numPairs, const int a, const int b) {
+  if (*numPairs < maxPairs) {
+    outPairs[*numPairs*2] = a < b ? a : b;
+    outPairs[*numPairs*2 + 1] = a < b ? b : a;
+  }
+  (*numPairs)++;
+}
+
+// traverses the tree against itself. A node pair (n, n) on the stack stands for the pairs within node n, other
+// node pairs are only pushed if they overlap
+int findBvhPairs(Broadphase* bp, int* outPairs, const int maxPairs) {
+  const BvhNode* nodes = bp->nodes;
+  const int* order = bp->order;
+  const float* sortedBounds = bp->sortedBounds;
+  int* stack = bp->stack;
+  int numPairs = 0;
+  int stackSize = 0;
+
+  if (bp->numBodies < 2) {
+    return 0;
+  }
+
+  stack[stackSize++] = 0;
+  stack[stackSize++] = 0;
+
+  while (stackSize > 0) {
+    // room for the four pairs an iteration can push
+    if (stackSize + 8 > bp->stackCapacity) {
+      stack = realloc(bp->stack, bp->stackCapacity*2*sizeof(int));
+      if (stack == NULL) {
+        return -3;
+      }
+      bp->stack = stack;
+      bp->stackCapacity *= 2;
+    }
+
+    const int b = stack[--stackSize];
+    const int a = stack[--stackSize];
+    const BvhNode* nodeA = nodes + a;
+    const BvhNode* nodeB = nodes + b;
+
+    if (a == b && nodeA->count > 0) {
+      for (int i = nodeA->index; i < nodeA->index + nodeA->count; i++) {
+        for (int j = i + 1; j < nodeA->index + nodeA->count; j++) {
+          if (isBoundsOverlapping(sortedBounds + i*FLOATS_PER_BOUNDS, sortedBounds + j*FLOATS_PER_BOUNDS)) {
+            addPair(outPairs, maxPairs, &numPairs, order[i], order[j]);
+          }
+        }
+      }
+    } else if (a == b) {
+      const int left = a + 1;
+      const int right = nodeA->index;
+      stack[stackSize++] = left, stack[stackSize++] = left;
+      stack[stackSize++] = right, stack[stackSize++] = right;
+      if (isNodeOverlapping(nodes + left, nodes + right)) {
+        stack[stackSize++] = left, stack[stackSize++] = right;
+      }
+    } else if (nodeA->count > 0 && nodeB->count > 0) {
+      for (int i = nodeA->index; i < nodeA->index + nodeA->count; i++) {
+        for (int j = nodeB->index; j < nodeB->index + nodeB->count; j++) {
+          if (isBoundsOverlapping(sortedBounds + i*FLOATS_PER_BOUNDS, sortedBounds + j*FLOATS_PER_BOUNDS)) {
+            addPair(outPairs, maxPairs, &numPairs, order[i], order[j]);
+          }
+        }
+      }
+    } else {
+      // descend both internal nodes, or the internal one of a leaf and an internal node
+      const int childrenA[2] = { nodeA->count > 0 ? a : a + 1, nodeA->count > 0 ? a : nodeA->index };
+      const int childrenB[2] = { nodeB->count > 0 ? b : b + 1, nodeB->count > 0 ? b : nodeB->index };
+      const int numChildrenA = nodeA->count > 0 ? 1 : 2;
+      const int numChildrenB = nodeB->count > 0 ? 1 : 2;
+
+      for (int i = 0; i < numChildrenA; i++) {
+        for (int j = 0; j < numChildrenB; j++) {
+          if (isNodeOverlapping(nodes + childrenA[i], nodes + childrenB[j])) {
+            stack[stackSize++] = childrenA[i], stack[stackSize++] = childrenB[j];
+          }
+        }
+      }
+    }
+  }
+
+  return numPairs;
+}
+
+
+// Sweep and prune
+
+int compareSortKeys(const void* a, const void* b) {
+  const float keyA = ((const SortKey*)a)->key;
+  const float keyB = ((const SortKey*)b)->key;
+  return (keyA > keyB) - (keyA < keyB);
+}
+
+// the axis where the body centers have the most variance
+int chooseSweepAxis(const float* bounds, const int numBodies) {
+  double sum[3] = {0}, sumSquared[3] = {0};
+  for (int i = 0; i < numBodies; i++) {
+    for (int j = 0; j < 3; j++) {
+      const double center = bounds[i*FLOATS_PER_BOUNDS + j] + bounds[i*FLOATS_PER_BOUNDS + j + 3];
+      sum[j] += center;
+      sumSquared[j] += center*center;
+    }
+  }
+
+  int axis = 0;
+  double bestVariance = -1.;
+  for (int j = 0; j < 3; j++) {
+    const double variance = sumSquared[j] - sum[j]*sum[j]/(numBodies > 0 ? numBodies : 1);
+    if (variance > bestVariance) {
+      bestVariance = variance;
+      axis = j;
+    }
+  }
+
+  return axis;
+}
+
+void sortSweep(Broadphase* bp, const float* bounds) {
+  int* order = bp->order;
+  const int axis = bp->axis;
+  const int n = bp->numBodies;
+  bool isSorted = !bp->needsBuild;
+
+  // insertion sort from the last order, unless the bodies have moved so much that it would be slow
+  if (isSorted) {
+    int numMoves = 0;
+    for (int i = 1; i < n && isSorted; i++) {
+      const int body = order[i];
+      const float key = bounds[body*FLOATS_PER_BOUNDS + axis];
+      int j = i - 1;
+      while (j >= 0 && bounds[order[j]*FLOATS_PER_BOUNDS + axis] > key) {
+        order[j + 1] = order[j];
+        j--;
+      }
+      order[j + 1] = body;
+      numMoves += i - 1 - j;
+      isSorted = numMoves <= MAX_SORT_MOVES*n;
+    }
+  }
+
+  if (!isSorted) {
+    for (int i = 0; i < n; i++) {
+      const int body = bp->needsBuild ? i : order[i];
+      bp->sortKeys[i].key = bounds[body*FLOATS_PER_BOUNDS + axis];
+      bp->sortKeys[i].body = body;
+    }
+    qsort(bp->sortKeys, n, sizeof(SortKey), compareSortKeys);
+    for (int i = 0; i < n; i++) {
+      order[i] = bp->sortKeys[i].body;
+    }
+    bp->numBuilds++;
+  }
+
+  // padded so the sweep can read HULL_SIMD_WIDTH bodies past the last
+  const int rowSize = bp->capacity + HULL_SIMD_WIDTH;
+  for (int row = 0; row < FLOATS_PER_BOUNDS; row++) {
+    float* coordinates = bp->sweepBounds + row*rowSize;
+    for (int i = 0; i < n; i++) {
+      coordinates[i] = bounds[order[i]*FLOATS_PER_BOUNDS + row];
+    }
+    memset(coordinates + n, 0, HULL_SIMD_WIDTH*sizeof(float));
+  }
+}
+
+// sweeps along the bodies sorted by their minimum on axis, testing each against the following bodies that start
+// before it ends
+int findSweepPairs(const Broadphase* bp, int* outPairs, const int maxPairs) {
+  const int n = bp->numBodies;
+  const int rowSize = bp->capacity + HULL_SIMD_WIDTH;
+  const int axis = bp->axis;
+  const int u = (axis + 1) % 3;
+  const int v = (axis + 2) % 3;
+  const float* minAxis = bp->sweepBounds + axis*rowSize;
+  const float* maxAxis = bp->sweepBounds + (axis + 3)*rowSize;
+  const float* minU = bp->sweepBounds + u*rowSize;
+  const float* maxU = bp->sweepBounds + (u + 3)*rowSize;
+  const float* minV = bp->sweepBounds + v*rowSize;
+  const float* maxV = bp->sweepBounds + (v + 3)*rowSize;
+  int numPairs = 0;
+
+  for (int i = 0; i < n; i++) {
+#if HULL_SIMD_WIDTH > 1
+    const simdFloat endA = simdSplat(maxAxis[i]);
+    const simdFloat minUA = simdSplat(minU[i]);
+    const simdFloat maxUA = simdSplat(maxU[i]);
+    const simdFloat minVA = simdSplat(minV[i]);
+    const simdFloat maxVA = simdSplat(maxV[i]);
+
+    for (int j = i + 1; j < n; j += HULL_SIMD_WIDTH) {
+      // the bodies are sorted, so once one starts beyond the end of body i so do all the rest
+      const int beyond = simdGreaterMask(simdLoad(minAxis + j), endA);
+      const int separate = beyond | simdGreaterMask(simdLoad(minU + j), maxUA) | simdGreaterMask(minUA, simdLoad(maxU + j)) |
+        simdGreaterMask(simdLoad(minV + j), maxVA) | simdGreaterMask(minVA, simdLoad(maxV + j));
+      int mask = ~separate & ((1 << HULL_SIMD_WIDTH) - 1);
+      if (j + HULL_SIMD_WIDTH > n) {
+        mask &= (1 << (n - j)) - 1;
+      }
+
+      for (; mask; mask &= mask - 1) {
+        addPair(outPairs, maxPairs, &numPairs, bp->order[i], bp->order[j + __builtin_ctz(mask)]);
+      }
+
+      if (beyond) {
+        break;
+      }
+    }
+#else
+    for (int j = i + 1; j < n && minAxis[j] <= maxAxis[i]; j++) {
+      if ((minU[j] <= maxU[i]) & (minU[i] <= maxU[j]) & (minV[j] <= maxV[i]) & (minV[i] <= maxV[j])) {
+        addPair(outPairs, maxPairs, &numPairs, bp->order[i], bp->order[j]);
+      }
+    }
+#endif
+  }
+
+  return numPairs;
+}
+
+
+// Broadphase API
+
+// sets the world bounds of numBodies bodies, FLOATS_PER_BOUNDS floats each (min x,y,z then max x,y,z). Setting a
+// different number of bodies than last time starts again, otherwise the last tree or order is updated. Returns 0,
+// or -3 if out of memory
+EMSCRIPTEN_KEEPALIVE
+int broadphaseSetBounds(Broadphase* bp, const float* bounds, const int numBodies) {
+  if (!reserveBodies(bp, numBodies)) {
+    bp->numBodies = 0;
+    bp->needsBuild = true;
+    return -3;
+  }
+
+  bp->needsBuild = bp->needsBuild || numBodies != bp->numBodies;
+  bp->numBodies = numBodies;
+
+  if (numBodies == 0) {
+    return 0;
+  }
+
+  if (bp->mode == BROADPHASE_BVH) {
+    if (bp->needsBuild || refitBvh(bp, bounds) > bp->builtCost*REBUILD_COST_RATIO) {
+      buildBvh(bp, bounds);
+    }
+  } else {
+    if (bp->needsBuild) {
+      bp->axis = chooseSweepAxis(bounds, numBodies);
+    }
+    sortSweep(bp, bounds);
+  }
+
+  bp->needsBuild = false;
+  return 0;
+}
+
+// world bounds of each shape under its column-major 4x4 transform (16 floats each), from the transformed local
+// bounds of the shape. These can be looser than the bounds of the transformed hull when rotated
+EMSCRIPTEN_KEEPALIVE
+int broadphaseSetShapes(Broadphase* bp, const ConvexShape* const* shapes, const float* transforms, const int numBodies) {
+  if (!reserveBodies(bp, numBodies)) {
+    bp->numBodies = 0;
+    bp->needsBuild = true;
+    return -3;
+  }
+
+  for (int i = 0; i < numBodies; i++) {
+    const float* local = shapes[i]->bounds;
+    const float* transform = transforms + i*16;
+    float* world = bp->bounds + i*FLOATS_PER_BOUNDS;
+    const float center[3] = { (local[0] + local[3])*.5f, (local[1] + local[4])*.5f, (local[2] + local[5])*.5f };
+    const float extent[3] = { (local[3] - local[0])*.5f, (local[4] - local[1])*.5f, (local[5] - local[2])*.5f };
+    float worldCenter[3];
+
+    transformPoint(worldCenter, transform, center);
+    for (int j = 0; j < 3; j++) {
+      const float worldExtent = fabsf(transform[j])*extent[0] + fabsf(transform[j + 4])*extent[1] + fabsf(transform[j + 8])*extent[2];
+      world[j] = worldCenter[j] - worldExtent;
+      world[j + 3] = worldCenter[j] + worldExtent;
+    }
+  }
+
+  return broadphaseSetBounds(bp, bp->bounds, numBodies);
+}
+
+// the next update builds a new tree or sorts from scratch, e.g. after many bodies have been teleported
+EMSCRIPTEN_KEEPALIVE
+void broadphaseRebuild(Broadphase* bp) {
+  bp->needsBuild = true;
+}
+
+// writes up to maxPairs pairs of overlapping bodies to outPairs, 2 ints each with the lower body first. Returns the
+// number of overlapping pairs, which may be more than maxPairs, or -3 if out of memory
+EMSCRIPTEN_KEEPALIVE
+int broadphaseFindPairs(Broadphase* bp, int* outPairs, const int maxPairs) {
+  return bp->mode == BROADPHASE_BVH ? findBvhPairs(bp, outPairs, maxPairs) : findSweepPairs(bp, outPairs, maxPairs);
+}
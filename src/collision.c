@@ -0,0 +1,691 @@
+// Convex collision queries between hulls built by hull.c, compile this file instead of hull.c to get both
+#include "hull.c"
+
+// Convex shapes
+// A ConvexShape is the compact hull of some points, with the neighbours of each hull vertex. The support
+// vertex in a direction (the vertex farthest along it) is found by hill climbing from the last support vertex
+// of the same pair, moving to a better neighbour until there is none. On a convex polytope a vertex with no
+// better neighbour is the best of all the vertices, as long as every vertex is a corner. A point inside a flat
+// side ties with its neighbours there and would stop the climb, but the hull only keeps its corners (see
+// simplifyHull()). Each step moves across the hull, so a query visits about sqrt(numVertices) vertices from a
+// cold start, and only a few once the cache follows a slowly moving pair. Small hulls are scanned instead,
+// which is quicker than walking.
+//
+// Queries take a column-major 4x4 affine transform per shape (e.g. a three.js matrixWorld.elements), which
+// may include scale and shear. The support of the transformed shape in direction d is the transform of the
+// support of the shape in direction transpose(M)*d, where M is the linear part.
+
+#define MAX_SCAN_VERTICES (32) // hulls with up to this many vertices are scanned rather than climbed
+
+typedef struct ConvexShape {
+  float* positions; // FLOATS_PER_VERTEX per hull vertex
+  int numVertices;
+  int* neighbourStarts; // the neighbours of vertex i are neighbours[neighbourStarts[i]] to neighbours[neighbourStarts[i+1]]
+  int* neighbours;
+  float bounds[6]; // local min x,y,z then max x,y,z of the hull vertices
+} ConvexShape;
+
+// per pair state, which makes the next query of the same pair quicker. Zero is a valid cache
+typedef struct {
+  int supportA; // last support vertex of each shape
+  int supportB;
+  float axis[3]; // last separating axis, or penetration normal, from a to b
+} ConvexCache;
+
+// the result of a query, from shape a to shape b. Every field is a float so the wasm binding can read the
+// struct as a Float32Array
+typedef struct {
+  float distance; // between the closest points, or minus the penetration depth if they overlap
+  float normal[3]; // unit direction to move b away from a
+  float pointA[3]; // closest point (or deepest point) of a
+  float pointB[3]; // closest point (or deepest point) of b
+} ConvexContact;
+
+EMSCRIPTEN_KEEPALIVE
+void convexShapeDestroy(ConvexShape* shape) {
+  if (shape == NULL) {
+    return;
+  }
+
+  free(shape->positions);
+  free(shape->neighbourStarts);
+  free(shape->neighbours);
+  free(shape);
+}
+
+// builds the hull of the vertices with ctx, and the neighbours of each hull vertex. Returns NULL if there are
+// too few vertices, they are collinear, or if out of memory
+EMSCRIPTEN_KEEPALIVE
+ConvexShape* convexShapeCreate(HullContext* ctx, const float* vertices, const int numVertices, const int stride) {
+  const int numPoints = numVertices/stride;
+  if (numPoints < 4) {
+    return NULL;
+  }
+
+  const int maxIndices = POINTS_PER_FACE*(2*numPoints - 4);
+  ConvexShape* shape = calloc(1, sizeof(ConvexShape));
+  float* positions = malloc(numPoints*FLOATS_PER_VERTEX*sizeof(float));
+  int* indices = malloc(maxIndices*sizeof(int));
+  int numHullVertices = 0;
+
+  const int numIndices = shape && positions && indices ? buildQuickHull(ctx, vertices, numVertices, stride) : -3;
+  if (numIndices < 0) {
+    free(positions);
+    free(indices);
+    convexShapeDestroy(shape);
+    return NULL;
+  }
+
+  // always int indices, so write the triangles and remap them here rather than through writeCompactHull()
+  const int numTriangleIndices = writeHullTriangles(ctx, indices);
+  for (int i = 0; i < numTriangleIndices; i++) {
+    ctx->pointNext[indices[i]/stride] = NO_INDEX;
+  }
+  for (int i = 0; i < numTriangleIndices; i++) {
+    const int point = indices[i]/stride;
+    if (ctx->pointNext[point] == NO_INDEX) {
+      memcpy(positions + numHullVertices*FLOATS_PER_VERTEX, vertices + indices[i], FLOATS_PER_VERTEX*sizeof(float));
+      ctx->pointNext[point] = numHullVertices++;
+    }
+    indices[i] = ctx->pointNext[point];
+  }
+
+  shape->positions = positions;
+  shape->numVertices = numHullVertices;
+  memcpy(shape->bounds, positions, FLOATS_PER_VERTEX*sizeof(float));
+  memcpy(shape->bounds + 3, positions, FLOATS_PER_VERTEX*sizeof(float));
+  for (int i = 1; i < numHullVertices; i++) {
+    for (int j = 0; j < 3; j++) {
+      shape->bounds[j] = fminf(shape->bounds[j], positions[i*FLOATS_PER_VERTEX + j]);
+      shape->bounds[j + 3] = fmaxf(shape->bounds[j + 3], positions[i*FLOATS_PER_VERTEX + j]);
+    }
+  }
+
+  shape->neighbourStarts = calloc(numHullVertices + 1, sizeof(int));
+  shape->neighbours = malloc(numTriangleIndices*sizeof(int));
+  if (shape->neighbourStarts == NULL || shape->neighbours == NULL) {
+    free(indices);
+    convexShapeDestroy(shape);
+    return NULL;
+  }
+
+  // each half-edge a to b of the closed hull gives b as a neighbour of a, and every edge has one half-edge
+  // each way, so each neighbour is listed once
+  for (int i = 0; i < numTriangleIndices; i++) {
+    shape->neighbourStarts[indices[i] + 1]++;
+  }
+  for (int i = 0; i < numHullVertices; i++) {
+    shape->neighbourStarts[i + 1] += shape->neighbourStarts[i];
+  }
+
+  int* next = ctx->orphans; // spare once the hull is built, and there is one per point
+  memcpy(next, shape->neighbourStarts, numHullVertices*sizeof(int));
+
+  for (int i = 0; i < numTriangleIndices; i++) {
+    const int j = i - i % POINTS_PER_FACE;
+    const int a = indices[i];
+    const int b = indices[j + (i + 1) % POINTS_PER_FACE];
+    shape->neighbours[next[a]++] = b;
+  }
+
+  free(indices);
+  return shape;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int convexShapeNumVertices(const ConvexShape* shape) {
+  return shape->numVertices;
+}
+
+// FLOATS_PER_VERTEX floats per hull vertex
+EMSCRIPTEN_KEEPALIVE
+const float* convexShapeGetVertices(const ConvexShape* shape) {
+  return shape->positions;
+}
+
+// the vertex of the shape farthest along direction, climbing from vertex start
+int calcSupportVertex(const ConvexShape* shape, const float* direction, const int start) {
+  const float* positions = shape->positions;
+  int best = start >= 0 && start < shape->numVertices ? start : 0;
+  float bestDistance = dot(positions + best*FLOATS_PER_VERTEX, direction);
+
+  if (shape->numVertices <= MAX_SCAN_VERTICES) {
+    for (int i = 0; i < shape->numVertices; i++) {
+      const float distance = dot(positions + i*FLOATS_PER_VERTEX, direction);
+      if (distance > bestDistance) {
+        bestDistance = distance;
+        best = i;
+      }
+    }
+    return best;
+  }
+
+  // strictly better each step, so the climb cannot cycle on a plateau
+  for (int current = NO_INDEX; current != best;) {
+    current = best;
+    for (int i = shape->neighbourStarts[current]; i < shape->neighbourStarts[current + 1]; i++) {
+      const int neighbour = shape->neighbours[i];
+      const float distance = dot(positions + neighbour*FLOATS_PER_VERTEX, direction);
+      if (distance > bestDistance) {
+        bestDistance = distance;
+        best = neighbour;
+      }
+    }
+  }
+
+  return best;
+}
+
+// direction, a column vector, multiplied by the transpose of the linear part of the transform
+void transformDirection(float* out, const float* transform, const float* direction) {
+  out[0] = transform[0]*direction[0] + transform[1]*direction[1] + transform[2]*direction[2];
+  out[1] = transform[4]*direction[0] + transform[5]*direction[1] + transform[6]*direction[2];
+  out[2] = transform[8]*direction[0] + transform[9]*direction[1] + transform[10]*direction[2];
+}
+
+void transformPoint(float* out, const float* transform, const float* point) {
+  out[0] = transform[0]*point[0] + transform[4]*point[1] + transform[8]*point[2] + transform[12];
+  out[1] = transform[1]*point[0] + transform[5]*point[1] + transform[9]*point[2] + transform[13];
+  out[2] = transform[2]*point[0] + transform[6]*point[1] + transform[10]*point[2] + transform[14];
+}
+
+
+// GJK
+// The shapes overlap when their Minkowski difference A - B contains the origin. GJK keeps a simplex of up to
+// four points of A - B and replaces it each iteration with the sub-simplex closest to the origin, plus the
+// support point in the direction from that closest point towards the origin. It stops when the support point
+// gets no closer, the distance is then the distance from the origin to the simplex, or when the simplex
+// contains the origin. Each point remembers its two support points so the closest points of A and B are the
+// same barycentric combination as the closest point of the simplex.
+
+#define MAX_GJK_ITERATIONS (64)
+#define GJK_TOLERANCE (1e-6f) // relative, stop when a support point gets this little closer
+#define MAX_EPA_ITERATIONS (128)
+#define MAX_EPA_FACES (256)
+#define MAX_EPA_VERTICES (MAX_EPA_ITERATIONS + 4)
+#define EPA_TOLERANCE (1e-5f) // relative to the size of the difference
+
+typedef struct {
+  float w[3]; // a - b
+  float a[3];
+  float b[3];
+} SupportPoint;
+
+typedef struct {
+  const ConvexShape* shapeA;
+  const ConvexShape* shapeB;
+  const float* transformA;
+  const float* transformB;
+  ConvexCache* cache;
+  SupportPoint points[4];
+  float weights[4]; // barycentric weights of the closest point
+  int numPoints;
+  float scale; // largest squared length of any support point, for the tolerances
+} GjkState;
+
+// the support point of A - B in direction, that is A's support in direction and B's in -direction
+void calcSupportPoint(GjkState* state, SupportPoint* out, const float* direction) {
+  float localDirection[3];
+  float negative[3];
+
+  transformDirection(localDirection, state->transformA, direction);
+  state->cache->supportA = calcSupportVertex(state->shapeA, localDirection, state->cache->supportA);
+  transformPoint(out->a, state->transformA, state->shapeA->positions + state->cache->supportA*FLOATS_PER_VERTEX);
+
+  transformDirection(localDirection, state->transformB, multiplyScalar(negative, direction, -1.f));
+  state->cache->supportB = calcSupportVertex(state->shapeB, localDirection, state->cache->supportB);
+  transformPoint(out->b, state->transformB, state->shapeB->positions + state->cache->supportB*FLOATS_PER_VERTEX);
+
+  sub(out->w, out->a, out->b);
+  state->scale = fmaxf(state->scale, dot(out->w, out->w));
+}
+
+// keeps the points with a positive weight, in order
+void reduceSimplex(GjkState* state) {
+  int n = 0;
+  for (int i = 0; i < state->numPoints; i++) {
+    if (state->weights[i] > 0.f) {
+      state->points[n] = state->points[i];
+      state->weights[n++] = state->weights[i];
+    }
+  }
+  state->numPoints = n;
+}
+
+// weight of b for the point of the segment a to b closest to the origin
+float calcSegmentWeight(const float* a, const float* b) {
+  float ab[3];
+  sub(ab, b, a);
+  const float lengthSq = dot(ab, ab);
+  return lengthSq > 0.f ? fminf(fmaxf(-dot(a, ab)/lengthSq, 0.f), 1.f) : 0.f;
+}
+
+// weights of the point of the triangle closest to the origin, see Ericson, Real-Time Collision Detection 5.1.5
+void calcTriangleWeights(float* outWeights, const float* a, const float* b, const float* c) {
+  float ab[3], ac[3];
+  sub(ab, b, a);
+  sub(ac, c, a);
+
+  const float d1 = -dot(ab, a), d2 = -dot(ac, a);
+  const float d3 = -dot(ab, b), d4 = -dot(ac, b);
+  const float d5 = -dot(ab, c), d6 = -dot(ac, c);
+  const float va = d3*d6 - d5*d4, vb = d5*d2 - d1*d6, vc = d1*d4 - d3*d2;
+
+  outWeights[0] = outWeights[1] = outWeights[2] = 0.f;
+
+  if (d1 <= 0.f && d2 <= 0.f) {
+    outWeights[0] = 1.f;
+  } else if (d3 >= 0.f && d4 <= d3) {
+    outWeights[1] = 1.f;
+  } else if (d6 >= 0.f && d5 <= d6) {
+    outWeights[2] = 1.f;
+  } else if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f) {
+    const float t = calcSegmentWeight(a, b);
+    outWeights[0] = 1.f - t, outWeights[1] = t;
+  } else if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f) {
+    const float t = calcSegmentWeight(a, c);
+    outWeights[0] = 1.f - t, outWeights[2] = t;
+  } else if (va <= 0.f && d4 - d3 >= 0.f && d5 - d6 >= 0.f) {
+    const float t = calcSegmentWeight(b, c);
+    outWeights[1] = 1.f - t, outWeights[2] = t;
+  } else if (va + vb + vc > 0.f) {
+    const float sum = va + vb + vc;
+    outWeights[0] = va/sum, outWeights[1] = vb/sum, outWeights[2] = vc/sum;
+  } else {
+    // too thin to have an inside, so the closest of the edges
+    const float* points[3] = { a, b, c };
+    float bestDistanceSq = FLT_MAX;
+    for (int k = 0; k < 3; k++) {
+      const float* p0 = points[k];
+      const float* p1 = points[(k + 1) % 3];
+      const float t = calcSegmentWeight(p0, p1);
+      float closest[3];
+      scaleAndAdd(closest, multiplyScalar(closest, p0, 1.f - t), p1, t);
+      if (dot(closest, closest) < bestDistanceSq) {
+        bestDistanceSq = dot(closest, closest);
+        outWeights[0] = outWeights[1] = outWeights[2] = 0.f;
+        outWeights[k] = 1.f - t, outWeights[(k + 1) % 3] = t;
+      }
+    }
+  }
+}
+
+// replaces the simplex with the sub-simplex closest to the origin, and writes that closest point. Returns
+// false if the simplex is a tetrahedron which contains the origin
+bool reduceToClosest(GjkState* state, float* outClosest) {
+  SupportPoint* p = state->points;
+  float* weights = state->weights;
+
+  if (state->numPoints == 1) {
+    weights[0] = 1.f;
+  } else if (state->numPoints == 2) {
+    const float t = calcSegmentWeight(p[0].w, p[1].w);
+    weights[0] = 1.f - t, weights[1] = t;
+  } else if (state->numPoints == 3) {
+    calcTriangleWeights(weights, p[0].w, p[1].w, p[2].w);
+  } else {
+    // the closest point is on a face which has the origin in front of it, and the fourth point behind
+    static const int FACES[4][4] = { {0,1,2,3}, {0,2,3,1}, {0,3,1,2}, {1,3,2,0} };
+    float bestDistanceSq = FLT_MAX;
+    bool isInside = true;
+
+    for (int f = 0; f < 4; f++) {
+      const float* a = p[FACES[f][0]].w;
+      const float* b = p[FACES[f][1]].w;
+      const float* c = p[FACES[f][2]].w;
+      float ab[3], ac[3], ad[3], normal[3];
+      cross(normal, sub(ab, b, a), sub(ac, c, a));
+      const float originSide = -dot(normal, a);
+      const float otherSide = dot(normal, sub(ad, p[FACES[f][3]].w, a));
+
+      // a flat tetrahedron has no inside, so every face is tried
+      const bool isFlat = otherSide*otherSide <= GJK_TOLERANCE*GJK_TOLERANCE*dot(normal, normal)*state->scale;
+      if (originSide*otherSide < 0.f || isFlat) {
+        float faceWeights[3], closest[3] = {0.f,0.f,0.f};
+        calcTriangleWeights(faceWeights, a, b, c);
+        for (int k = 0; k < 3; k++) {
+          scaleAndAdd(closest, closest, p[FACES[f][k]].w, faceWeights[k]);
+        }
+
+        const float distanceSq = dot(closest, closest);
+        if (distanceSq < bestDistanceSq) {
+          isInside = false;
+          bestDistanceSq = distanceSq;
+          weights[0] = weights[1] = weights[2] = weights[3] = 0.f;
+          for (int k = 0; k < 3; k++) {
+            weights[FACES[f][k]] = faceWeights[k];
+          }
+        }
+      }
+    }
+
+    if (isInside) {
+      return false;
+    }
+  }
+
+  outClosest[0] = outClosest[1] = outClosest[2] = 0.f;
+  for (int i = 0; i < state->numPoints; i++) {
+    scaleAndAdd(outClosest, outClosest, p[i].w, weights[i]);
+  }
+
+  reduceSimplex(state);
+  return true;
+}
+
+void calcWitnessPoints(const GjkState* state, float* outA, float* outB) {
+  outA[0] = outA[1] = outA[2] = 0.f;
+  outB[0] = outB[1] = outB[2] = 0.f;
+
+  for (int i = 0; i < state->numPoints; i++) {
+    scaleAndAdd(outA, outA, state->points[i].a, state->weights[i]);
+    scaleAndAdd(outB, outB, state->points[i].b, state->weights[i]);
+  }
+}
+
+// runs GJK until the distance converges, or the origin is inside the simplex. With stopIfSeparated it also
+// stops as soon as there is a separating axis. Returns true if the shapes overlap, and sets outClosest to the
+// closest point of A - B to the origin otherwise
+bool runGjk(GjkState* state, float* outClosest, const bool stopIfSeparated) {
+  ConvexCache* cache = state->cache;
+  float direction[3];
+
+  // start from the last axis, from a to b, which is towards the origin from the closest point a - b
+  if (dot(cache->axis, cache->axis) > 0.f) {
+    memcpy(direction, cache->axis, sizeof(direction));
+  } else {
+    direction[0] = 1.f, direction[1] = 0.f, direction[2] = 0.f;
+  }
+
+  state->numPoints = 1;
+  state->scale = 0.f;
+  calcSupportPoint(state, state->points, direction);
+  state->weights[0] = 1.f;
+  memcpy(outClosest, state->points[0].w, sizeof(state->points[0].w));
+
+  // the last axis usually still separates a pair which has not moved far
+  if (stopIfSeparated && dot(direction, outClosest) < 0.f) {
+    memcpy(cache->axis, direction, sizeof(direction));
+    return false;
+  }
+
+  for (int iteration = 0; iteration < MAX_GJK_ITERATIONS; iteration++) {
+    const float distanceSq = dot(outClosest, outClosest);
+    if (distanceSq <= GJK_TOLERANCE*GJK_TOLERANCE*state->scale) {
+      return true; // the origin is on the simplex
+    }
+
+    SupportPoint* w = state->points + state->numPoints;
+    multiplyScalar(direction, outClosest, -1.f);
+    calcSupportPoint(state, w, direction);
+
+    const float progress = distanceSq - dot(outClosest, w->w);
+    if (stopIfSeparated && dot(outClosest, w->w) > 0.f) {
+      memcpy(cache->axis, direction, sizeof(direction));
+      return false; // direction separates the shapes
+    }
+
+    if (progress <= GJK_TOLERANCE*distanceSq) {
+      memcpy(cache->axis, direction, sizeof(direction));
+      return false; // no closer, outClosest is the closest point
+    }
+
+    state->numPoints++;
+    if (!reduceToClosest(state, outClosest)) {
+      return true; // the origin is inside the tetrahedron
+    }
+
+    // rounding in the closest point can keep the progress above the tolerance, even once it stops moving
+    if (dot(outClosest, outClosest) >= distanceSq) {
+      multiplyScalar(cache->axis, outClosest, -1.f);
+      return false;
+    }
+  }
+
+  multiplyScalar(cache->axis, outClosest, -1.f);
+  return false;
+}
+
+// true if the shapes overlap. Touching shapes may go either way. cache may be NULL
+EMSCRIPTEN_KEEPALIVE
+bool convexOverlap(const ConvexShape* a, const float* transformA, const ConvexShape* b, const float* transformB, ConvexCache* cache) {
+  ConvexCache localCache = {0};
+  GjkState state = { .shapeA = a, .shapeB = b, .transformA = transformA, .transformB = transformB, .cache = cache ? cache : &localCache };
+  float closest[3];
+
+  return runGjk(&state, closest, true);
+}
+
+// the distance between the shapes, 0 if they overlap. contact gets the closest points and the direction from a
+// to b, or is zeroed if they overlap, and may be NULL, as may cache
+EMSCRIPTEN_KEEPALIVE
+float convexDistance(const ConvexShape* a, const float* transformA, const ConvexShape* b, const float* transformB, ConvexCache* cache, ConvexContact* outContact) {
+  ConvexCache localCache = {0};
+  GjkState state = { .shapeA = a, .shapeB = b, .transformA = transformA, .transformB = transformB, .cache = cache ? cache : &localCache };
+  float closest[3];
+  ConvexContact contact = {0};
+
+  if (!runGjk(&state, closest, false)) {
+    contact.distance = sqrtf(dot(closest, closest));
+    normalize(contact.normal, multiplyScalar(contact.normal, closest, -1.f));
+    calcWitnessPoints(&state, contact.pointA, contact.pointB);
+  }
+
+  if (outContact) {
+    *outContact = contact;
+  }
+
+  return contact.distance;
+}
+
+
+// EPA
+// The expanding polytope algorithm starts from a tetrahedron of A - B around the origin, and repeatedly adds
+// the support point in the direction of the face closest to the origin, until that face is on the boundary of
+// A - B. The face's distance is then the penetration depth and its normal the direction to separate them.
+// The polytope is on the stack, so its size is capped. Deep overlaps of finely tessellated round shapes can
+// fill it first, and the depth is then a little short of the true depth (within 2% for two coincident
+// 300 vertex spheres).
+
+typedef struct {
+  int vertices[3]; // counter-clockwise from outside
+  float normal[3];
+  float distance; // from the origin
+} EpaFace;
+
+typedef struct {
+  SupportPoint vertices[MAX_EPA_VERTICES];
+  EpaFace faces[MAX_EPA_FACES];
+  int edges[MAX_EPA_FACES*3*2]; // horizon edges, two vertices each
+  int numVertices;
+  int numFaces;
+} Polytope;
+
+// returns false if the face is degenerate, or there is no room
+bool addEpaFace(Polytope* polytope, const int a, const int b, const int c) {
+  if (polytope->numFaces >= MAX_EPA_FACES) {
+    return false;
+  }
+
+  EpaFace* face = polytope->faces + polytope->numFaces;
+  const float* wa = polytope->vertices[a].w;
+  float ab[3], ac[3];
+  cross(face->normal, sub(ab, polytope->vertices[b].w, wa), sub(ac, polytope->vertices[c].w, wa));
+
+  const float length = sqrtf(dot(face->normal, face->normal));
+  if (length <= 0.f) {
+    return false;
+  }
+
+  multiplyScalar(face->normal, face->normal, 1.f/length);
+  face->vertices[0] = a, face->vertices[1] = b, face->vertices[2] = c;
+  face->distance = dot(face->normal, wa);
+  polytope->numFaces++;
+  return true;
+}
+
+// grows the GJK simplex, which contains the origin, into a tetrahedron with some volume. Returns false if the
+// difference is flat, in which case the shapes only touch
+bool buildEpaTetrahedron(GjkState* state, Polytope* polytope) {
+  static const float AXES[3][3] = { {1.f,0.f,0.f}, {0.f,1.f,0.f}, {0.f,0.f,1.f} };
+  SupportPoint* p = state->points;
+  const float tolerance = EPA_TOLERANCE*EPA_TOLERANCE*state->scale;
+  float direction[3], edge[3], normal[3], offset[3];
+
+  // a point, so try each axis for a second point
+  for (int i = 0; state->numPoints == 1 && i < 6; i++) {
+    multiplyScalar(direction, AXES[i/2], i % 2 ? -1.f : 1.f);
+    calcSupportPoint(state, p + 1, direction);
+    state->numPoints += dot(sub(edge, p[1].w, p[0].w), edge) > tolerance ? 1 : 0;
+  }
+
+  // a segment, so try directions around it for a third point
+  for (int i = 0; state->numPoints == 2 && i < 6; i++) {
+    sub(edge, p[1].w, p[0].w);
+    cross(direction, edge, AXES[i/2]);
+    multiplyScalar(direction, direction, i % 2 ? -1.f : 1.f);
+    if (dot(direction, direction) > 0.f) {
+      calcSupportPoint(state, p + 2, direction);
+      cross(normal, edge, sub(offset, p[2].w, p[0].w));
+      state->numPoints += dot(normal, normal) > tolerance*dot(edge, edge) ? 1 : 0;
+    }
+  }
+
+  // a triangle, so try each side for the fourth point
+  for (int i = 0; state->numPoints == 3 && i < 2; i++) {
+    float ab[3], ac[3];
+    cross(normal, sub(ab, p[1].w, p[0].w), sub(ac, p[2].w, p[0].w));
+    multiplyScalar(direction, normal, i ? -1.f : 1.f);
+    calcSupportPoint(state, p + 3, direction);
+    const float height = dot(normal, sub(offset, p[3].w, p[0].w));
+    state->numPoints += height*height > tolerance*dot(normal, normal) ? 1 : 0;
+  }
+
+  if (state->numPoints < 4) {
+    return false;
+  }
+
+  // wind the faces outwards, so (0,1,2) must have 3 behind it
+  float ab[3], ac[3], ad[3];
+  cross(normal, sub(ab, p[1].w, p[0].w), sub(ac, p[2].w, p[0].w));
+  if (dot(normal, sub(ad, p[3].w, p[0].w)) > 0.f) {
+    const SupportPoint swap = p[1];
+    p[1] = p[2];
+    p[2] = swap;
+  }
+
+  memcpy(polytope->vertices, p, 4*sizeof(SupportPoint));
+  polytope->numVertices = 4;
+  polytope->numFaces = 0;
+  return addEpaFace(polytope, 0, 1, 2) && addEpaFace(polytope, 0, 3, 1) && addEpaFace(polytope, 0, 2, 3) && addEpaFace(polytope, 1, 3, 2);
+}
+
+// adds the edge a to b to the horizon, or removes b to a if it is already there, as it is then between two
+// faces which are both being removed
+void addHorizonEdge(Polytope* polytope, int* ioNumEdges, const int a, const int b) {
+  for (int i = 0; i < *ioNumEdges; i++) {
+    if (polytope->edges[i*2] == b && polytope->edges[i*2 + 1] == a) {
+      (*ioNumEdges)--;
+      polytope->edges[i*2] = polytope->edges[*ioNumEdges*2];
+      polytope->edges[i*2 + 1] = polytope->edges[*ioNumEdges*2 + 1];
+      return;
+    }
+  }
+
+  polytope->edges[*ioNumEdges*2] = a;
+  polytope->edges[*ioNumEdges*2 + 1] = b;
+  (*ioNumEdges)++;
+}
+
+// expands the polytope until the closest face is on the boundary of A - B, or there is no more room, and
+// writes that face
+void expandPolytope(GjkState* state, Polytope* polytope, EpaFace* outFace) {
+  const float tolerance = EPA_TOLERANCE*sqrtf(state->scale);
+
+  for (int iteration = 0; iteration < MAX_EPA_ITERATIONS; iteration++) {
+    const EpaFace* closest = polytope->faces;
+    for (int i = 1; i < polytope->numFaces; i++) {
+      closest = polytope->faces[i].distance < closest->distance ? polytope->faces + i : closest;
+    }
+
+    // copied, as the face may be removed below
+    *outFace = *closest;
+
+    SupportPoint* w = polytope->vertices + polytope->numVertices;
+    calcSupportPoint(state, w, closest->normal);
+    if (dot(w->w, closest->normal) - closest->distance <= tolerance) {
+      return;
+    }
+
+    // remove the faces which can see the new point, leaving a hole bounded by the horizon
+    const int newVertex = polytope->numVertices++;
+    int numEdges = 0;
+    for (int i = 0; i < polytope->numFaces;) {
+      EpaFace* face = polytope->faces + i;
+      float offset[3];
+      if (dot(face->normal, sub(offset, w->w, polytope->vertices[face->vertices[0]].w)) > 0.f) {
+        for (int k = 0; k < 3; k++) {
+          addHorizonEdge(polytope, &numEdges, face->vertices[k], face->vertices[(k + 1) % 3]);
+        }
+        *face = polytope->faces[--polytope->numFaces];
+      } else {
+        i++;
+      }
+    }
+
+    // fill the hole with a fan from the new point. A face too thin to have a normal leaves the polytope open,
+    // so stop with the last closest face, which is still a lower bound on the depth
+    if (polytope->numFaces + numEdges > MAX_EPA_FACES || polytope->numVertices >= MAX_EPA_VERTICES) {
+      return;
+    }
+    for (int i = 0; i < numEdges; i++) {
+      if (!addEpaFace(polytope, polytope->edges[i*2], polytope->edges[i*2 + 1], newVertex)) {
+        return;
+      }
+    }
+  }
+}
+
+// true if the shapes overlap, and then contact gets the penetration depth (as a negative distance), the
+// direction to move b to separate them, and the deepest points. Otherwise it is the same as convexDistance().
+// cache may be NULL
+EMSCRIPTEN_KEEPALIVE
+bool convexPenetration(const ConvexShape* a, const float* transformA, const ConvexShape* b, const float* transformB, ConvexCache* cache, ConvexContact* outContact) {
+  ConvexCache localCache = {0};
+  GjkState state = { .shapeA = a, .shapeB = b, .transformA = transformA, .transformB = transformB, .cache = cache ? cache : &localCache };
+  Polytope polytope;
+  float closest[3];
+
+  memset(outContact, 0, sizeof(*outContact));
+
+  if (!runGjk(&state, closest, false)) {
+    outContact->distance = sqrtf(dot(closest, closest));
+    normalize(outContact->normal, multiplyScalar(outContact->normal, closest, -1.f));
+    calcWitnessPoints(&state, outContact->pointA, outContact->pointB);
+    return false;
+  }
+
+  if (!buildEpaTetrahedron(&state, &polytope)) {
+    // touching, or too flat to expand, so no depth
+    calcWitnessPoints(&state, outContact->pointA, outContact->pointB);
+    return true;
+  }
+
+  EpaFace face;
+  expandPolytope(&state, &polytope, &face);
+
+  // the deepest points are the support points at the projection of the origin onto the closest face
+  float projected[3][3];
+  for (int k = 0; k < 3; k++) {
+    state.points[k] = polytope.vertices[face.vertices[k]];
+    scaleAndAdd(projected[k], state.points[k].w, face.normal, -face.distance);
+  }
+  calcTriangleWeights(state.weights, projected[0], projected[1], projected[2]);
+  state.numPoints = 3;
+  calcWitnessPoints(&state, outContact->pointA, outContact->pointB);
+
+  outContact->distance = -face.distance;
+  memcpy(outContact->normal, face.normal, sizeof(outContact->normal));
+  memcpy(state.cache->axis, face.normal, sizeof(face.normal));
+  return true;
+}
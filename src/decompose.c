@@ -0,0 +1,693 @@
+// Approximate convex decomposition of triangle meshes, compile this file instead of hull.c to get both
+#include "hull.c"
+
+// Convex decomposition
+// Splits a concave mesh into a few convex parts, in the style of V-HACD. The mesh is voxelized (the voxels
+// touching a triangle, then the voxels that can't be reached from outside without crossing one), and every
+// voxel starts in one part. The concavity of a part is the volume of the hull of its voxels less the volume
+// of the voxels, relative to the volume of the whole mesh. While there are parts more concave than
+// maxConcavity, and fewer than maxParts, the most concave parts are cut in two by the axis aligned plane
+// which gives the two smallest hulls, with a small penalty for uneven sides. Finally the hull of each part is built with buildQuickHullBudget(), so
+// it has at most maxPartVertices vertices.
+//
+// The cuts of each round are independent, so every candidate cut of every part being split is a task on the
+// thread pool, as are the hulls of the new parts and the final hulls. Each task uses its thread's context.
+// Only the boundary voxels of a part (those with a face not shared with the same part) matter to its hull. The
+// volume of the hull of their corners is found exactly from the hull of their centers, which has an eighth of
+// the points, and only the final hulls are built from the corners, clamped to the bounds of the mesh so parts
+// don't grow past the mesh.
+//
+// The mesh should be closed, otherwise the inside can't be told from the outside and only the voxels of the
+// surface are used, which gives more concave parts.
+
+#define MIN_DECOMPOSE_RESOLUTION (4)
+#define MAX_DECOMPOSE_RESOLUTION (128)
+#define NUM_CUTS_PER_AXIS (8) // candidate planes along each axis of a part
+#define BALANCE_WEIGHT (.05f) // cost of each voxel of difference between the two sides of a cut, in voxels
+#define VOXEL_EMPTY (0)
+#define VOXEL_SURFACE (1)
+#define VOXEL_OUTSIDE (2)
+
+typedef struct {
+  int* voxels; // grid indices
+  int numVoxels;
+  float concavity; // -1 when no cut is possible
+} DecomposePart;
+
+typedef struct {
+  int part;
+  int axis;
+  int position; // voxels below position along axis go to one side, the rest to the other
+  float cost; // in voxels, see evaluateCut(), or -1 if out of memory
+} DecomposeCut;
+
+typedef struct {
+  HullThreadPool* pool;
+  int dims[3]; // voxels along each axis, including a layer of padding on each side
+  float origin[3]; // corner of voxel 0
+  float voxelSize;
+  float boundsMin[3]; // of the mesh
+  float boundsMax[3];
+  int* labels; // part of each voxel, or NO_INDEX
+  uint8_t* isBoundary; // per voxel, for the voxels of parts
+  float totalVolume; // in voxels
+  DecomposePart* parts;
+  int numParts;
+  DecomposeCut* cuts;
+  int* results; // per task, negative if out of memory
+  float* outPositions;
+  int* outIndices;
+  int* outParts;
+  int maxPartVertices;
+} Decomposition;
+
+void calcVoxelCoords(int* outCoords, const Decomposition* d, const int voxel) {
+  outCoords[0] = voxel % d->dims[0];
+  outCoords[1] = (voxel/d->dims[0]) % d->dims[1];
+  outCoords[2] = voxel/(d->dims[0]*d->dims[1]);
+}
+
+// Voxelizing
+
+// true if the projections of the triangle and of a cube of halfSize at the origin onto axis don't overlap
+bool isSeparatingAxis(const float* axis, const float* a, const float* b, const float* c, const float halfSize) {
+  const float pa = dot(axis, a), pb = dot(axis, b), pc = dot(axis, c);
+  const float radius = halfSize*(fabsf(axis[0]) + fabsf(axis[1]) + fabsf(axis[2]));
+  return fminf(pa, fminf(pb, pc)) > radius || fmaxf(pa, fmaxf(pb, pc)) < -radius;
+}
+
+// separating axis test of a triangle and a cube, the triangle is relative to the center of the cube
+bool isTriangleOverlappingCube(const float* a, const float* b, const float* c, const float halfSize) {
+  float edges[3][3], normal[3], axis[3];
+  sub(edges[0], b, a);
+  sub(edges[1], c, b);
+  sub(edges[2], a, c);
+  cross(normal, edges[0], edges[1]);
+
+  if (isSeparatingAxis(normal, a, b, c, halfSize)) {
+    return false;
+  }
+
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      const float unit[3] = { i == 0, i == 1, i == 2 };
+      cross(axis, unit, edges[j]);
+      if (isSeparatingAxis(axis, a, b, c, halfSize)) {
+        return false;
+      }
+    }
+  }
+
+  // the cube's own axes were tested by the caller, which only visits cubes in the bounds of the triangle
+  return true;
+}
+
+void voxelizeTriangle(Decomposition* d, uint8_t* voxels, const float* a, const float* b, const float* c) {
+  // a little larger than a voxel, so a triangle on the face between two voxels marks both
+  const float halfSize = d->voxelSize*.5f*(1.f + 1e-4f);
+  int lo[3], hi[3];
+
+  for (int i = 0; i < 3; i++) {
+    const float min = fminf(a[i], fminf(b[i], c[i])) - d->origin[i];
+    const float max = fmaxf(a[i], fmaxf(b[i], c[i])) - d->origin[i];
+    lo[i] = (int)floorf(min/d->voxelSize - 1e-4f);
+    hi[i] = (int)floorf(max/d->voxelSize + 1e-4f);
+    lo[i] = lo[i] < 1 ? 1 : lo[i];
+    hi[i] = hi[i] > d->dims[i] - 2 ? d->dims[i] - 2 : hi[i];
+  }
+
+  for (int z = lo[2]; z <= hi[2]; z++) {
+    for (int y = lo[1]; y <= hi[1]; y++) {
+      for (int x = lo[0]; x <= hi[0]; x++) {
+        const int voxel = x + d->dims[0]*(y + d->dims[1]*z);
+        if (voxels[voxel] == VOXEL_SURFACE) {
+          continue;
+        }
+
+        const float center[3] = {
+          d->origin[0] + (x + .5f)*d->voxelSize,
+          d->origin[1] + (y + .5f)*d->voxelSize,
+          d->origin[2] + (z + .5f)*d->voxelSize,
+        };
+        float relativeA[3], relativeB[3], relativeC[3];
+        sub(relativeA, a, center);
+        sub(relativeB, b, center);
+        sub(relativeC, c, center);
+
+        if (isTriangleOverlappingCube(relativeA, relativeB, relativeC, halfSize)) {
+          voxels[voxel] = VOXEL_SURFACE;
+        }
+      }
+    }
+  }
+}
+
+// marks the voxels touching triangles, then floods the outside from the padding. Everything else goes in part
+// 0. Returns false if out of memory
+bool voxelizeMesh(Decomposition* d, const float* vertices, const int* indices, const int numIndices) {
+  const int numGridVoxels = d->dims[0]*d->dims[1]*d->dims[2];
+  uint8_t* voxels = calloc(numGridVoxels, sizeof(uint8_t));
+  int* queue = malloc(numGridVoxels*sizeof(int));
+  d->labels = malloc(numGridVoxels*sizeof(int));
+  d->isBoundary = calloc(numGridVoxels, sizeof(uint8_t));
+  d->parts = calloc(1, sizeof(DecomposePart));
+
+  if (!voxels || !queue || !d->labels || !d->isBoundary || !d->parts) {
+    free(voxels);
+    free(queue);
+    return false;
+  }
+
+  for (int i = 0; i + 2 < numIndices; i += POINTS_PER_FACE) {
+    voxelizeTriangle(d, voxels, vertices + indices[i], vertices + indices[i + 1], vertices + indices[i + 2]);
+  }
+
+  // the padding is never touched by a triangle, so voxel 0 is outside
+  const int steps[6] = { 1, -1, d->dims[0], -d->dims[0], d->dims[0]*d->dims[1], -d->dims[0]*d->dims[1] };
+  int numQueued = 0;
+  queue[numQueued++] = 0;
+  voxels[0] = VOXEL_OUTSIDE;
+
+  for (int i = 0; i < numQueued; i++) {
+    int coords[3];
+    calcVoxelCoords(coords, d, queue[i]);
+
+    for (int j = 0; j < 6; j++) {
+      const int coord = coords[j/2] + (j % 2 ? -1 : 1);
+      const int neighbour = queue[i] + steps[j];
+      if (coord >= 0 && coord < d->dims[j/2] && voxels[neighbour] == VOXEL_EMPTY) {
+        voxels[neighbour] = VOXEL_OUTSIDE;
+        queue[numQueued++] = neighbour;
+      }
+    }
+  }
+
+  // the queue is spare, and has room for every voxel of the part
+  DecomposePart* part = d->parts;
+  part->voxels = queue;
+  d->numParts = 1;
+
+  for (int voxel = 0; voxel < numGridVoxels; voxel++) {
+    d->labels[voxel] = voxels[voxel] == VOXEL_OUTSIDE ? NO_INDEX : 0;
+    if (voxels[voxel] != VOXEL_OUTSIDE) {
+      part->voxels[part->numVoxels++] = voxel;
+    }
+  }
+
+  d->totalVolume = (float)part->numVoxels;
+  free(voxels);
+  return true;
+}
+
+// Cutting
+
+// the boundary voxels of the part, on side 0 (below position along axis) or 1 of a cut, or of all the part if
+// axis is -1. Adds the center of each to outPoints, or its 8 corners if isCorners. Returns the number of floats
+int gatherPartPoints(const Decomposition* d, float* outPoints, const DecomposePart* part, const int axis, const int position, const int side, const bool isCorners) {
+  int numFloats = 0;
+
+  for (int i = 0; i < part->numVoxels; i++) {
+    const int voxel = part->voxels[i];
+    int coords[3];
+    calcVoxelCoords(coords, d, voxel);
+
+    if (axis >= 0 && (coords[axis] >= position) != side) {
+      continue;
+    }
+
+    // the voxels either side of the cut become boundary voxels
+    if (!d->isBoundary[voxel] && (axis < 0 || (coords[axis] != position - 1 && coords[axis] != position))) {
+      continue;
+    }
+
+    if (!isCorners) {
+      outPoints[numFloats++] = coords[0] + .5f;
+      outPoints[numFloats++] = coords[1] + .5f;
+      outPoints[numFloats++] = coords[2] + .5f;
+      continue;
+    }
+
+    for (int corner = 0; corner < 8; corner++) {
+      outPoints[numFloats++] = (float)(coords[0] + (corner & 1));
+      outPoints[numFloats++] = (float)(coords[1] + (corner >> 1 & 1));
+      outPoints[numFloats++] = (float)(coords[2] + (corner >> 2 & 1));
+    }
+  }
+
+  return numFloats;
+}
+
+// moves points in voxels to the mesh's space, inside the bounds of the mesh
+void clampToMesh(const Decomposition* d, float* points, const int numFloats) {
+  for (int i = 0; i < numFloats; i++) {
+    const int axis = i % 3;
+    const float x = d->origin[axis] + points[i]*d->voxelSize;
+    points[i] = fminf(fmaxf(x, d->boundsMin[axis]), d->boundsMax[axis]);
+  }
+}
+
+// the volume of the hull built in ctx (0 for a planar hull), and the areas of its projections onto the planes
+// normal to each axis
+float calcHullVolume(const HullContext* ctx, float* outProjectedAreas) {
+  const float* reference = NULL;
+  float volume = 0.f;
+  outProjectedAreas[0] = outProjectedAreas[1] = outProjectedAreas[2] = 0.f;
+
+  for (int face = 0; face < ctx->numFaces; face++) {
+    const int* indices = ctx->faceIndices + face*POINTS_PER_FACE;
+    if (indices[0] == NO_INDEX) {
+      continue;
+    }
+
+    float a[3], b[3], c[3], normal[3];
+    reference = reference ? reference : ctx->vertices + indices[0];
+    sub(a, ctx->vertices + indices[0], reference);
+    sub(b, ctx->vertices + indices[1], reference);
+    sub(c, ctx->vertices + indices[2], reference);
+    sub(b, b, a);
+    sub(c, c, a);
+    cross(normal, b, c);
+    volume += dot(a, normal);
+
+    // the faces in front and behind each cover the projection once, and the area is half the cross product
+    for (int i = 0; i < 3; i++) {
+      outProjectedAreas[i] += fabsf(normal[i])*.25f;
+    }
+  }
+
+  return ctx->isPlanar ? 0.f : volume/6.f;
+}
+
+// the volume of the hull of the voxels with these centers, in voxels, or -1 if out of memory. That is the hull
+// of the centers grown by a voxel, and by Steiner's formula for a unit cube, the volume of the hull of the
+// centers, plus the areas of its projections onto the axis planes, plus its widths along the axes, plus 1
+float calcVoxelHullVolume(HullContext* ctx, const float* centers, const int numFloats) {
+  float min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+  float max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+  for (int i = 0; i < numFloats; i++) {
+    min[i % 3] = fminf(min[i % 3], centers[i]);
+    max[i % 3] = fmaxf(max[i % 3], centers[i]);
+  }
+
+  if (numFloats < 3) {
+    return 0.f;
+  }
+
+  float volume = 1.f + (max[0] - min[0]) + (max[1] - min[1]) + (max[2] - min[2]);
+  float projectedAreas[3];
+
+  // a triangle projects to its own area, and collinear points have no projected areas. The widths are exact for
+  // a line along an axis, which is the only line voxels make often
+  if (numFloats == 9) {
+    float ab[3], ac[3], normal[3];
+    sub(ab, centers + 3, centers);
+    sub(ac, centers + 6, centers);
+    cross(normal, ab, ac);
+    return volume + (fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]))*.5f;
+  }
+
+  const int result = buildQuickHull(ctx, centers, numFloats, 3);
+  if (result == -3) {
+    return -1.f;
+  } else if (result >= 0) {
+    volume += calcHullVolume(ctx, projectedAreas);
+    volume += projectedAreas[0] + projectedAreas[1] + projectedAreas[2];
+  }
+
+  return volume;
+}
+
+// the total volume of the two hulls, plus BALANCE_WEIGHT of the difference in the volumes of the two sides. The
+// first cut of a ring can't make the hulls smaller (the hull of each half has the middle), so without a reason to
+// cut in the middle the best cut would only shave a little off one end
+void evaluateCut(void* user, const int task, const int thread) {
+  Decomposition* d = user;
+  DecomposeCut* cut = d->cuts + task;
+  const DecomposePart* part = d->parts + cut->part;
+  HullContext* ctx = d->pool->contexts[thread];
+  float* points = malloc(part->numVoxels*3*sizeof(float));
+
+  cut->cost = -1.f;
+  if (points == NULL) {
+    return;
+  }
+
+  int numBelow = 0;
+  for (int i = 0; i < part->numVoxels; i++) {
+    int coords[3];
+    calcVoxelCoords(coords, d, part->voxels[i]);
+    numBelow += coords[cut->axis] < cut->position;
+  }
+
+  float cost = BALANCE_WEIGHT*abs(part->numVoxels - 2*numBelow);
+  for (int side = 0; side < 2 && cost >= 0.f; side++) {
+    const int numFloats = gatherPartPoints(d, points, part, cut->axis, cut->position, side, false);
+    const float volume = calcVoxelHullVolume(ctx, points, numFloats);
+    cost = volume < 0.f ? -1.f : cost + volume;
+  }
+
+  cut->cost = cost;
+  free(points);
+}
+
+// marks the boundary voxels of the part and measures its concavity. Sets results[task] to -3 if out of memory
+void measurePart(void* user, const int task, const int thread) {
+  Decomposition* d = user;
+  DecomposePart* part = d->parts + task;
+  HullContext* ctx = d->pool->contexts[thread];
+  const int steps[6] = { 1, -1, d->dims[0], -d->dims[0], d->dims[0]*d->dims[1], -d->dims[0]*d->dims[1] };
+
+  d->results[task] = 0;
+  if (part->concavity != 0.f) {
+    return; // measured already, or can't be cut
+  }
+
+  int numBoundary = 0;
+  for (int i = 0; i < part->numVoxels; i++) {
+    const int voxel = part->voxels[i];
+    bool isBoundary = false;
+    for (int j = 0; j < 6 && !isBoundary; j++) {
+      isBoundary = d->labels[voxel + steps[j]] != task;
+    }
+    d->isBoundary[voxel] = isBoundary;
+    numBoundary += isBoundary;
+  }
+
+  float* points = malloc(numBoundary*3*sizeof(float));
+  if (points == NULL) {
+    d->results[task] = -3;
+    return;
+  }
+
+  const int numFloats = gatherPartPoints(d, points, part, -1, 0, 0, false);
+  const float volume = calcVoxelHullVolume(ctx, points, numFloats);
+  free(points);
+
+  if (volume < 0.f) {
+    d->results[task] = -3;
+    return;
+  }
+
+  // only parts with a concavity are cut, so a convex part gets a tiny one to mark it as measured
+  part->concavity = fmaxf((volume - part->numVoxels)/d->totalVolume, FLT_MIN);
+}
+
+// moves the voxels of part on side 1 of cut into a new part. Returns false if out of memory
+bool cutPart(Decomposition* d, const int partIndex, const DecomposeCut* cut) {
+  DecomposePart* part = d->parts + partIndex;
+  DecomposePart* other = d->parts + d->numParts;
+  other->voxels = malloc(part->numVoxels*sizeof(int));
+  other->numVoxels = 0;
+  if (other->voxels == NULL) {
+    return false;
+  }
+
+  int numKept = 0;
+  for (int i = 0; i < part->numVoxels; i++) {
+    const int voxel = part->voxels[i];
+    int coords[3];
+    calcVoxelCoords(coords, d, voxel);
+
+    if (coords[cut->axis] >= cut->position) {
+      other->voxels[other->numVoxels++] = voxel;
+      d->labels[voxel] = d->numParts;
+    } else {
+      part->voxels[numKept++] = voxel;
+    }
+  }
+
+  part->numVoxels = numKept;
+  part->concavity = 0.f;
+  other->concavity = 0.f;
+  d->numParts++;
+  return true;
+}
+
+// the candidate cuts of a part, NUM_CUTS_PER_AXIS along each axis it spans more than one voxel of
+int addPartCuts(const Decomposition* d, DecomposeCut* outCuts, const int partIndex) {
+  const DecomposePart* part = d->parts + partIndex;
+  int lo[3] = { INT_MAX, INT_MAX, INT_MAX };
+  int hi[3] = { INT_MIN, INT_MIN, INT_MIN };
+  int numCuts = 0;
+
+  for (int i = 0; i < part->numVoxels; i++) {
+    int coords[3];
+    calcVoxelCoords(coords, d, part->voxels[i]);
+    for (int j = 0; j < 3; j++) {
+      lo[j] = coords[j] < lo[j] ? coords[j] : lo[j];
+      hi[j] = coords[j] > hi[j] ? coords[j] : hi[j];
+    }
+  }
+
+  for (int axis = 0; axis < 3; axis++) {
+    const int span = hi[axis] - lo[axis];
+    const int count = span < NUM_CUTS_PER_AXIS ? span : NUM_CUTS_PER_AXIS;
+    for (int i = 0; i < count; i++) {
+      DecomposeCut* cut = outCuts + numCuts++;
+      cut->part = partIndex;
+      cut->axis = axis;
+      cut->position = lo[axis] + 1 + i*span/count; // from lo + 1 to hi, so neither side is empty
+    }
+  }
+
+  return numCuts;
+}
+
+// cuts the most concave parts until none are over maxConcavity or there are maxParts. Returns false if out of
+// memory
+bool cutParts(Decomposition* d, const int maxParts, const float maxConcavity) {
+  int* toCut = malloc(maxParts*sizeof(int));
+  bool ok = toCut != NULL;
+
+  while (ok) {
+    runHullTasks(d->pool, measurePart, d, d->numParts);
+    for (int i = 0; i < d->numParts; i++) {
+      ok = ok && d->results[i] >= 0;
+    }
+
+    // the most concave parts first, as many as there is room for
+    int numToCut = 0;
+    for (int i = 0; ok && i < d->numParts; i++) {
+      if (d->parts[i].concavity > maxConcavity) {
+        toCut[numToCut++] = i;
+      }
+    }
+
+    if (!ok || numToCut == 0 || d->numParts >= maxParts) {
+      break;
+    }
+
+    for (int i = 1; i < numToCut; i++) {
+      for (int j = i; j > 0 && d->parts[toCut[j]].concavity > d->parts[toCut[j - 1]].concavity; j--) {
+        const int part = toCut[j];
+        toCut[j] = toCut[j - 1];
+        toCut[j - 1] = part;
+      }
+    }
+
+    numToCut = numToCut < maxParts - d->numParts ? numToCut : maxParts - d->numParts;
+
+    int numCuts = 0;
+    for (int i = 0; i < numToCut; i++) {
+      numCuts += addPartCuts(d, d->cuts + numCuts, toCut[i]);
+    }
+
+    runHullTasks(d->pool, evaluateCut, d, numCuts);
+
+    // the cuts of each part are consecutive
+    for (int i = 0, first = 0; ok && i < numToCut; i++) {
+      int best = NO_INDEX;
+      int end = first;
+      for (; end < numCuts && d->cuts[end].part == toCut[i]; end++) {
+        ok = ok && d->cuts[end].cost >= 0.f;
+        if (best == NO_INDEX || d->cuts[end].cost < d->cuts[best].cost) {
+          best = end;
+        }
+      }
+
+      if (best == NO_INDEX) {
+        d->parts[toCut[i]].concavity = -1.f; // a single voxel
+      } else if (ok) {
+        ok = cutPart(d, toCut[i], d->cuts + best);
+      }
+      first = end;
+    }
+  }
+
+  free(toCut);
+  return ok;
+}
+
+// Part hulls
+
+// the budgeted hull of the part's corners, written to its own region of the outputs
+void buildPartHull(void* user, const int task, const int thread) {
+  Decomposition* d = user;
+  const DecomposePart* part = d->parts + task;
+  HullContext* ctx = d->pool->contexts[thread];
+  float* positions = d->outPositions + task*d->maxPartVertices*FLOATS_PER_VERTEX;
+  int* indices = d->outIndices + task*calcMaxHullIndices(d->maxPartVertices*3, 3);
+  int* outPart = d->outParts + task*4;
+  float maxDistance = 0.f;
+  int numBoundary = 0;
+
+  for (int i = 0; i < part->numVoxels; i++) {
+    numBoundary += d->isBoundary[part->voxels[i]];
+  }
+
+  float* points = malloc(numBoundary*8*3*sizeof(float));
+  if (points == NULL) {
+    d->results[task] = -3;
+    return;
+  }
+
+  const int numFloats = gatherPartPoints(d, points, part, -1, 0, 0, true);
+  clampToMesh(d, points, numFloats);
+  int result = buildQuickHullBudget(ctx, &maxDistance, points, numFloats, 3, d->maxPartVertices);
+
+  // a part in the padding can be clamped flat, and a planar hull has no volume, so use the unclamped points
+  if (result >= 0 && ctx->isPlanar) {
+    gatherPartPoints(d, points, part, -1, 0, 0, true);
+    for (int i = 0; i < numFloats; i++) {
+      points[i] = d->origin[i % 3] + points[i]*d->voxelSize;
+    }
+    result = buildQuickHullBudget(ctx, &maxDistance, points, numFloats, 3, d->maxPartVertices);
+  }
+
+  d->results[task] = result < 0 ? result : 0;
+  if (result >= 0) {
+    // compact vertex numbers, the outside sets are not needed any more so pointNext holds them
+    int numVertices = 0;
+    int numIndices = 0;
+    for (int i = 0; i < ctx->numFaces*POINTS_PER_FACE; i++) {
+      if (ctx->faceIndices[i - i % POINTS_PER_FACE] != NO_INDEX) {
+        ctx->pointNext[ctx->faceIndices[i]/3] = NO_INDEX;
+      }
+    }
+    for (int i = 0; i < ctx->numFaces*POINTS_PER_FACE; i++) {
+      const int vertex = ctx->faceIndices[i];
+      if (ctx->faceIndices[i - i % POINTS_PER_FACE] == NO_INDEX) {
+        continue;
+      }
+      if (ctx->pointNext[vertex/3] == NO_INDEX) {
+        memcpy(positions + numVertices*FLOATS_PER_VERTEX, points + vertex, FLOATS_PER_VERTEX*sizeof(float));
+        ctx->pointNext[vertex/3] = numVertices++;
+      }
+      indices[numIndices++] = ctx->pointNext[vertex/3];
+    }
+
+    outPart[1] = numVertices;
+    outPart[3] = numIndices;
+  }
+
+  free(points);
+}
+
+// Decomposition API
+
+void freeDecomposition(Decomposition* d) {
+  for (int i = 0; d->parts && i < d->numParts; i++) {
+    free(d->parts[i].voxels);
+  }
+  free(d->parts);
+  free(d->cuts);
+  free(d->results);
+  free(d->labels);
+  free(d->isBoundary);
+}
+
+// splits the triangle mesh (numVertices floats, indices are offsets into them, 3 per triangle) into at most
+// maxParts convex parts of at most maxPartVertices vertices each (at least 4), see above. resolution is the number of
+// voxels along the longest side of the mesh bounds (from 4 to 128), and maxConcavity the largest concavity a
+// part can have without being cut (e.g. 0.01 for 1% of the volume of the mesh).
+// outPositions must have room for maxParts*maxPartVertices*FLOATS_PER_VERTEX floats, and outIndices for
+// maxParts*POINTS_PER_FACE*(2*maxPartVertices - 4) ints. The parts are packed one after the other, and outParts
+// holds (first vertex, number of vertices, first index, number of indices) per part, where the vertices are
+// numbers into outPositions and the indices are relative to the first vertex of their part.
+// Returns the number of parts, -1 if there are no triangles, -2 if the mesh is flat and -3 if out of memory
+EMSCRIPTEN_KEEPALIVE
+int generateConvexDecomposition(HullThreadPool* pool, float* outPositions, int* outIndices, int* outParts, const float* vertices, const int numVertices, const int* indices, const int numIndices, const int maxParts, const int maxPartVertices, const int resolution, const float maxConcavity) {
+  if (numIndices < POINTS_PER_FACE || maxParts < 1) {
+    return -1;
+  }
+
+  for (int i = 0; i < numIndices; i++) {
+    if (indices[i] < 0 || indices[i] + FLOATS_PER_VERTEX > numVertices) {
+      return -1;
+    }
+  }
+
+  Decomposition d = {0};
+  d.pool = pool;
+  d.outPositions = outPositions;
+  d.outIndices = outIndices;
+  d.outParts = outParts;
+  d.maxPartVertices = maxPartVertices < 4 ? 4 : maxPartVertices;
+
+  for (int i = 0; i < 3; i++) {
+    d.boundsMin[i] = FLT_MAX;
+    d.boundsMax[i] = -FLT_MAX;
+  }
+  for (int i = 0; i < numIndices; i++) {
+    for (int j = 0; j < 3; j++) {
+      d.boundsMin[j] = fminf(d.boundsMin[j], vertices[indices[i] + j]);
+      d.boundsMax[j] = fmaxf(d.boundsMax[j], vertices[indices[i] + j]);
+    }
+  }
+
+  // the grid has a layer of padding all round, so the outside is connected
+  const float longest = fmaxf(d.boundsMax[0] - d.boundsMin[0], fmaxf(d.boundsMax[1] - d.boundsMin[1], d.boundsMax[2] - d.boundsMin[2]));
+  const int gridResolution = resolution < MIN_DECOMPOSE_RESOLUTION ? MIN_DECOMPOSE_RESOLUTION : resolution > MAX_DECOMPOSE_RESOLUTION ? MAX_DECOMPOSE_RESOLUTION : resolution;
+  d.voxelSize = longest/gridResolution;
+
+  for (int i = 0; i < 3; i++) {
+    if (!(d.boundsMax[i] - d.boundsMin[i] > 0.f)) {
+      return -2; // flat, or not a number
+    }
+    const int count = (int)ceilf((d.boundsMax[i] - d.boundsMin[i])/d.voxelSize);
+    d.dims[i] = (count < 1 ? 1 : count > gridResolution ? gridResolution : count) + 2;
+    d.origin[i] = d.boundsMin[i] - d.voxelSize;
+  }
+
+  // a round cuts fewer than maxParts parts, each with up to 3*NUM_CUTS_PER_AXIS cuts
+  d.cuts = malloc(maxParts*3*NUM_CUTS_PER_AXIS*sizeof(DecomposeCut));
+  d.results = malloc(maxParts*sizeof(int));
+  bool ok = d.cuts && d.results && voxelizeMesh(&d, vertices, indices, numIndices);
+
+  if (ok && d.parts[0].numVoxels == 0) {
+    freeDecomposition(&d);
+    return -1;
+  }
+
+  if (ok) {
+    DecomposePart* parts = realloc(d.parts, maxParts*sizeof(DecomposePart));
+    ok = parts != NULL;
+    d.parts = parts ? parts : d.parts;
+    ok = ok && cutParts(&d, maxParts, maxConcavity);
+  }
+
+  if (ok) {
+    runHullTasks(pool, buildPartHull, &d, d.numParts);
+    for (int i = 0; i < d.numParts; i++) {
+      ok = ok && d.results[i] >= 0;
+    }
+  }
+
+  // each part wrote to its own worst case region, pack them down
+  const int maxPartIndices = calcMaxHullIndices(d.maxPartVertices*3, 3);
+  int numPackedVertices = 0;
+  int numPackedIndices = 0;
+  for (int i = 0; ok && i < d.numParts; i++) {
+    int* part = outParts + i*4;
+    memmove(outPositions + numPackedVertices*FLOATS_PER_VERTEX, outPositions + i*d.maxPartVertices*FLOATS_PER_VERTEX, part[1]*FLOATS_PER_VERTEX*sizeof(float));
+    memmove(outIndices + numPackedIndices, outIndices + i*maxPartIndices, part[3]*sizeof(int));
+    part[0] = numPackedVertices;
+    part[2] = numPackedIndices;
+    numPackedVertices += part[1];
+    numPackedIndices += part[3];
+  }
+
+  const int numParts = d.numParts;
+  freeDecomposition(&d);
+  return ok ? numParts : -3;
+}
@@ -2,7 +2,21 @@
 #include <stdbool.h>
 #include <math.h>
 #include <string.h>
+#include <float.h>
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
+
+#ifdef __EMSCRIPTEN__
 #include <emscripten.h>
+#else
+#define EMSCRIPTEN_KEEPALIVE
+#endif
+
+#if defined(HULL_THREADS) || defined(__EMSCRIPTEN_PTHREADS__)
+#include <pthread.h>
+#define HULL_USE_THREADS
+#endif
 
 #define MAX_FACES (65535)
 #define POINTS_PER_FACE (3)
@@ -11,6 +25,12 @@
 #define EDGES_PER_FACE (POINTS_PER_FACE)
 #define POINTS_PER_EDGE (2)
 
+// timing hooks around the phases of generateHullTrianglesLegacy(), defined by bench/bench-hull.c
+#ifndef HULL_PHASE_BEGIN
+#define HULL_PHASE_BEGIN(phase)
+#define HULL_PHASE_END(phase)
+#endif
+
 #ifdef stdout
 
 void printFaceIndices(const int* faceIndices, const int numFaces) {
@@ -137,6 +157,270 @@ bool areCoplanar(const float* a, const float* b, const float* c, const float* d,
   return fabsf( dot( ad, normal ) ) < tolerance;
 }
 
+// Predicates
+// orient3d() decides which side of a triangle's plane a point is on without rounding errors, so duplicate and
+// coplanar points are never outside a face, however they are ordered. The determinant is calculated in double
+// precision, and only when it is too close to zero to trust is it recalculated exactly with floating point
+// expansions (Shewchuk, "Adaptive Precision Floating-Point Arithmetic and Fast Robust Geometric Predicates").
+// An expansion is a sum of non-overlapping doubles, stored from the smallest magnitude to the largest, so
+// its sign is the sign of the last component.
+// The hull builders test the float plane distances first, and only call orient3d() when a distance is within
+// the rounding error of the plane (see calcPlaneError()).
+
+#define ORIENT3D_ERROR_BOUND ( (7. + 28.*DBL_EPSILON)*DBL_EPSILON/2. ) // Shewchuk's o3derrboundA, DBL_EPSILON/2 is his epsilon
+#define MAX_MINOR_COMPONENTS (16) // components in a 2x2 minor of the differences
+
+// outSum + outError is exactly a + b
+void twoSum(double* outSum, double* outError, const double a, const double b) {
+  const double sum = a + b;
+  const double bVirtual = sum - a;
+  const double aVirtual = sum - bVirtual;
+  *outSum = sum;
+  *outError = (a - aVirtual) + (b - bVirtual);
+}
+
+// outProduct + outError is exactly a*b
+void twoProduct(double* outProduct, double* outError, const double a, const double b) {
+  const double product = a*b;
+  *outProduct = product;
+  *outError = fma(a, b, -product);
+}
+
+// out may be e. Zero components are dropped, but there is always at least one. Returns the number of components
+int growExpansion(double* out, const double* e, const int numE, const double b) {
+  double q = b;
+  double error = 0.;
+  int numOut = 0;
+
+  for (int i = 0; i < numE; i++) {
+    twoSum(&q, &error, q, e[i]);
+    if (error != 0.) {
+      out[numOut++] = error;
+    }
+  }
+
+  if (q != 0. || numOut == 0) {
+    out[numOut++] = q;
+  }
+
+  return numOut;
+}
+
+// out = e + f, out may be e but not f. Returns the number of components
+int sumExpansions(double* out, const double* e, const int numE, const double* f, const int numF) {
+  if (out != e) {
+    memcpy(out, e, numE*sizeof(double));
+  }
+
+  int numOut = numE;
+  for (int i = 0; i < numF; i++) {
+    numOut = growExpansion(out, out, numOut, f[i]);
+  }
+
+  return numOut;
+}
+
+// out = e*b, out must not be e. Returns the number of components
+int scaleExpansion(double* out, const double* e, const int numE, const double b) {
+  double q = 0.;
+  double error = 0.;
+  int numOut = 0;
+
+  twoProduct(&q, &error, e[0], b);
+  if (error != 0.) {
+    out[numOut++] = error;
+  }
+
+  for (int i = 1; i < numE; i++) {
+    double product = 0.;
+    double productError = 0.;
+    double sum = 0.;
+
+    twoProduct(&product, &productError, e[i], b);
+    twoSum(&sum, &error, q, productError);
+    if (error != 0.) {
+      out[numOut++] = error;
+    }
+
+    twoSum(&q, &error, product, sum);
+    if (error != 0.) {
+      out[numOut++] = error;
+    }
+  }
+
+  if (q != 0. || numOut == 0) {
+    out[numOut++] = q;
+  }
+
+  return numOut;
+}
+
+// out = e*f, where e has at most MAX_MINOR_COMPONENTS. Returns the number of components
+int multiplyExpansions(double* out, const double* e, const int numE, const double* f, const int numF) {
+  double scaled[2*MAX_MINOR_COMPONENTS];
+  int numOut = scaleExpansion(out, e, numE, f[0]);
+
+  for (int i = 1; i < numF; i++) {
+    const int numScaled = scaleExpansion(scaled, e, numE, f[i]);
+    numOut = sumExpansions(out, out, numOut, scaled, numScaled);
+  }
+
+  return numOut;
+}
+
+// out = a*b - c*d for two component expansions, out has room for MAX_MINOR_COMPONENTS
+int calcMinorExpansion(double* out, const double* a, const double* b, const double* c, const double* d) {
+  double ab[MAX_MINOR_COMPONENTS/2];
+  double cd[MAX_MINOR_COMPONENTS/2];
+  const int numAB = multiplyExpansions(ab, a, 2, b, 2);
+  const int numCD = multiplyExpansions(cd, c, 2, d, 2);
+
+  for (int i = 0; i < numCD; i++) {
+    cd[i] = -cd[i];
+  }
+
+  return sumExpansions(out, ab, numAB, cd, numCD);
+}
+
+// out = a*b - c*d, out has room for 4 components. Returns the number of components
+int calcProductDifference(double* out, const double a, const double b, const double c, const double d) {
+  double ab[2];
+  double cd[2];
+  twoProduct(&ab[1], &ab[0], a, b);
+  twoProduct(&cd[1], &cd[0], -c, d);
+  return sumExpansions(out, ab, 2, cd, 2);
+}
+
+// exact determinant when the differences of the coordinates are exact in double precision, which they are
+// unless the coordinates are very different in magnitude
+double orient3dExactDifferences(const double (*ad)[2], const double (*bd)[2], const double (*cd)[2]) {
+  double minor[4];
+  double terms[3][8];
+  double det[24];
+  int numTerms[3];
+
+  int numMinor = calcProductDifference(minor, bd[0][1], cd[1][1], cd[0][1], bd[1][1]);
+  numTerms[0] = scaleExpansion(terms[0], minor, numMinor, ad[2][1]);
+  numMinor = calcProductDifference(minor, cd[0][1], ad[1][1], ad[0][1], cd[1][1]);
+  numTerms[1] = scaleExpansion(terms[1], minor, numMinor, bd[2][1]);
+  numMinor = calcProductDifference(minor, ad[0][1], bd[1][1], bd[0][1], ad[1][1]);
+  numTerms[2] = scaleExpansion(terms[2], minor, numMinor, cd[2][1]);
+
+  int numDet = sumExpansions(det, terms[0], numTerms[0], terms[1], numTerms[1]);
+  numDet = sumExpansions(det, det, numDet, terms[2], numTerms[2]);
+  return det[numDet - 1];
+}
+
+// exact determinant of the rows a - point, b - point and c - point
+double orient3dExact(const float* a, const float* b, const float* c, const float* point) {
+  double ad[FLOATS_PER_VERTEX][2];
+  double bd[FLOATS_PER_VERTEX][2];
+  double cd[FLOATS_PER_VERTEX][2];
+  double minor[MAX_MINOR_COMPONENTS];
+  double terms[3][4*MAX_MINOR_COMPONENTS];
+  double det[3*4*MAX_MINOR_COMPONENTS];
+  int numTerms[3];
+  bool isExact = true;
+
+  for (int axis = 0; axis < FLOATS_PER_VERTEX; axis++) {
+    twoSum(&ad[axis][1], &ad[axis][0], a[axis], -(double)point[axis]);
+    twoSum(&bd[axis][1], &bd[axis][0], b[axis], -(double)point[axis]);
+    twoSum(&cd[axis][1], &cd[axis][0], c[axis], -(double)point[axis]);
+    isExact = isExact && ad[axis][0] == 0. && bd[axis][0] == 0. && cd[axis][0] == 0.;
+  }
+
+  if (isExact) {
+    return orient3dExactDifferences(ad, bd, cd);
+  }
+
+  int numMinor = calcMinorExpansion(minor, bd[1], cd[2], bd[2], cd[1]);
+  numTerms[0] = multiplyExpansions(terms[0], minor, numMinor, ad[0], 2);
+  numMinor = calcMinorExpansion(minor, cd[1], ad[2], cd[2], ad[1]);
+  numTerms[1] = multiplyExpansions(terms[1], minor, numMinor, bd[0], 2);
+  numMinor = calcMinorExpansion(minor, ad[1], bd[2], ad[2], bd[1]);
+  numTerms[2] = multiplyExpansions(terms[2], minor, numMinor, cd[0], 2);
+
+  int numDet = sumExpansions(det, terms[0], numTerms[0], terms[1], numTerms[1]);
+  numDet = sumExpansions(det, det, numDet, terms[2], numTerms[2]);
+  return det[numDet - 1];
+}
+
+// positive when point is in front of the triangle abc (counter-clockwise when seen from the front), negative
+// when it is behind and zero when all four points are coplanar. Only the sign is exact
+EMSCRIPTEN_KEEPALIVE
+double orient3d(const float* a, const float* b, const float* c, const float* point) {
+  const double adx = (double)a[0] - point[0], ady = (double)a[1] - point[1], adz = (double)a[2] - point[2];
+  const double bdx = (double)b[0] - point[0], bdy = (double)b[1] - point[1], bdz = (double)b[2] - point[2];
+  const double cdx = (double)c[0] - point[0], cdy = (double)c[1] - point[1], cdz = (double)c[2] - point[2];
+
+  const double bdxcdy = bdx*cdy, cdxbdy = cdx*bdy;
+  const double cdxady = cdx*ady, adxcdy = adx*cdy;
+  const double adxbdy = adx*bdy, bdxady = bdx*ady;
+
+  const double det = adz*(bdxcdy - cdxbdy) + bdz*(cdxady - adxcdy) + cdz*(adxbdy - bdxady);
+  const double permanent = (fabs(bdxcdy) + fabs(cdxbdy))*fabs(adz) + (fabs(cdxady) + fabs(adxcdy))*fabs(bdz) +
+    (fabs(adxbdy) + fabs(bdxady))*fabs(cdz);
+  const double errorBound = ORIENT3D_ERROR_BOUND*permanent;
+
+  if (det > errorBound || -det > errorBound) {
+    return -det;
+  }
+
+  // every product is exactly zero (float differences are too large to underflow), e.g. an axis aligned plane
+  if (permanent == 0.) {
+    return 0.;
+  }
+
+  return -orient3dExact(a, b, c, point);
+}
+
+// largest of maxCoord and the absolute value of every coordinate of the vertices
+float growMaxCoord(float maxCoord, const float* vertices, const int numVertices, const int stride) {
+  for (int i = 0; i < numVertices; i += stride) {
+    for (int axis = 0; axis < FLOATS_PER_VERTEX; axis++) {
+      maxCoord = fmaxf(maxCoord, fabsf(vertices[i + axis]));
+    }
+  }
+
+  return maxCoord;
+}
+
+// bound on the error in planeDistance() for the plane of triangle abc (from setFromCoplanarPoints() and
+// setPlane() through a), for any point with no coordinate larger than maxCoord. FLT_MAX if abc is degenerate
+float calcPlaneError(const float* a, const float* b, const float* c, const float maxCoord) {
+  float vbc[] = {0.f,0.f,0.f};
+  float vba[] = {0.f,0.f,0.f};
+  float crossProduct[] = {0.f,0.f,0.f};
+
+  sub(vbc, c, b);
+  sub(vba, a, b);
+  cross(crossProduct, vbc, vba);
+
+  const float crossLength = sqrtf( dot(crossProduct, crossProduct) );
+  if (crossLength == 0.f) {
+    return FLT_MAX;
+  }
+
+  // the angle between the computed and the true normal, and then the error along that normal over the
+  // largest possible distance between two points plus the rounding in the dot products
+  const float normalError = 4.f*FLT_EPSILON*( sqrtf( dot(vbc, vbc)*dot(vba, vba) )/crossLength + 1.f );
+  return 4.f*maxCoord*(normalError + 2.f*FLT_EPSILON);
+}
+
+// exact test of whether point is in front of triangle abc, where distance is the float plane distance and error
+// its bound from calcPlaneError()
+bool isInFrontOfPlane(const float* a, const float* b, const float* c, const float* point, const float distance, const float error) {
+  if (distance > error) {
+    return true;
+  }
+
+  if (distance < -error) {
+    return false;
+  }
+
+  return orient3d(a, b, c, point) > 0.;
+}
+
 float* centroidFromIndices(float* out, const float* vertices, const int* indices, const int numIndices) {
   float n = numIndices;
 
@@ -161,7 +445,7 @@ int calcExtremes(int* outIndices, const float* vertices, const int numVertices,
   int numOutIndices = 0;
   float minAxis[FLOATS_PER_VERTEX];
   float maxAxis[FLOATS_PER_VERTEX];
-  int extremes[NUM_EXTREMES] = {0};
+  int extremes[2*FLOATS_PER_VERTEX] = {0}; // NUM_EXTREMES, but initializers are not allowed on variable length arrays
 
   memcpy(minAxis, vertices, sizeof(minAxis));
   memcpy(maxAxis, vertices, sizeof(maxAxis));
@@ -195,14 +479,11 @@ int calcExtremes(int* outIndices, const float* vertices, const int numVertices,
 }
 
 void buildFace(int* outIndices, float* outNormal, const float* vertices, const int ai, const int bi, const int ci, const float* hullCentroid) {
-  float centroidToA[] = {0.f,0.f,0.f};
   outIndices[0] = ai;
 
   setFromCoplanarPoints(outNormal, vertices + ai, vertices + bi, vertices + ci);
-  sub(centroidToA, vertices + ai, hullCentroid);
 
-  const float cosine = dot(outNormal, centroidToA);
-  if (cosine > 0.f) {
+  if (orient3d(vertices + ai, vertices + bi, vertices + ci, hullCentroid) < 0.) {
     outIndices[1] = bi;
     outIndices[2] = ci;
   } else {
@@ -218,21 +499,15 @@ bool equals(const float* a, const float* b, const float tolerance) {
   return fabsf(a[0] - b[0]) < tolerance && fabsf(a[1] - b[1]) < tolerance && fabsf(a[2] - b[2]) < tolerance;
 }
 
+// writes the faces that point is in front of, exactly (see orient3d()). faceNormals is no longer used, and only
+// kept so existing callers still build. Returns the number of faces written
 int calcFacingFaces(int* outFaces, const float* vertices, const int* faceIndices, const float* faceNormals, const int numFaces, const float* point) {
+  (void)faceNormals;
   int numOutFaces = 0;
-  float faceToPoint[] = {0.f,0.f,0.f};
-  
-  for (int i = 0; i < numFaces; i++) {
-    const int j = i*POINTS_PER_FACE;
-    // if (equals(point, vertices + faceIndices[j], 5.f)) {
-    //   return 0; // point too close to an existing point, ignore it
-    // }
 
-    sub(faceToPoint, point, vertices + faceIndices[j]); // line from the first point on the triangle
-    normalize(faceToPoint, faceToPoint);
-
-    const float cosine = dot(faceToPoint, faceNormals + i*FLOATS_PER_NORMAL);
-    if (cosine > 0.f) {
+  for (int i = 0; i < numFaces; i++) {
+    const int* indices = faceIndices + i*POINTS_PER_FACE;
+    if (orient3d(vertices + indices[0], vertices + indices[1], vertices + indices[2], point) > 0.) {
       outFaces[numOutFaces++] = i;
     }
   }
@@ -240,6 +515,8 @@ int calcFacingFaces(int* outFaces, const float* vertices, const int* faceIndices
   return numOutFaces;
 }
 
+// writes the edges of the faces which are not shared by two of them, comparing every pair of edges. Only the
+// legacy builder uses this, the other builders walk the horizon over faceTwins, see Quickhull below
 int calcOutsideEdges(int* outEdges, const int* faceIndices, const int* faces, const int numFaces) {
   int outEdgesIndex = 0;
 
@@ -288,31 +565,529 @@ int calcOutsideEdges(int* outEdges, const int* faceIndices, const int* faces, co
   return outEdgesIndex/POINTS_PER_EDGE;
 }
 
+// Plane kernels
+// Face planes are kept as a structure of arrays, so the kernels below can test HULL_SIMD_WIDTH planes against
+// a point at once. The signed distance of a point from plane i is nx[i]*x + ny[i]*y + nz[i]*z - d[i], where
+// the normal is unit length, so no normalization or square root is needed per test.
+// The vector width comes from the compiler target (wasm simd128, AVX, SSE or NEON), define HULL_NO_SIMD to
+// force the scalar versions.
+
+#if !defined(HULL_NO_SIMD) && defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define HULL_SIMD_WIDTH (4)
+typedef v128_t simdFloat;
+#define simdLoad(p) wasm_v128_load(p)
+#define simdSplat(x) wasm_f32x4_splat(x)
+#define simdAdd(a,b) wasm_f32x4_add(a,b)
+#define simdSub(a,b) wasm_f32x4_sub(a,b)
+#define simdMul(a,b) wasm_f32x4_mul(a,b)
+#define simdMax(a,b) wasm_f32x4_max(a,b)
+#define simdGreaterMask(a,b) wasm_i32x4_bitmask(wasm_f32x4_gt(a,b))
+#define simdGreaterEqualMask(a,b) wasm_i32x4_bitmask(wasm_f32x4_ge(a,b))
+#define simdStore(p,a) wasm_v128_store(p,a)
+#define simdDiv(a,b) wasm_f32x4_div(a,b)
+#define simdMin(a,b) wasm_f32x4_min(a,b)
+#define simdSelectLess(a,b,x,y) wasm_v128_bitselect(x, y, wasm_f32x4_lt(a,b))
+
+#elif !defined(HULL_NO_SIMD) && defined(__AVX__)
+#include <immintrin.h>
+#define HULL_SIMD_WIDTH (8)
+typedef __m256 simdFloat;
+#define simdLoad(p) _mm256_loadu_ps(p)
+#define simdSplat(x) _mm256_set1_ps(x)
+#define simdAdd(a,b) _mm256_add_ps(a,b)
+#define simdSub(a,b) _mm256_sub_ps(a,b)
+#define simdMul(a,b) _mm256_mul_ps(a,b)
+#define simdMax(a,b) _mm256_max_ps(a,b)
+#define simdGreaterMask(a,b) _mm256_movemask_ps(_mm256_cmp_ps(a,b,_CMP_GT_OQ))
+#define simdGreaterEqualMask(a,b) _mm256_movemask_ps(_mm256_cmp_ps(a,b,_CMP_GE_OQ))
+#define simdStore(p,a) _mm256_storeu_ps(p,a)
+#define simdDiv(a,b) _mm256_div_ps(a,b)
+#define simdMin(a,b) _mm256_min_ps(a,b)
+#define simdSelectLess(a,b,x,y) _mm256_blendv_ps(y, x, _mm256_cmp_ps(a,b,_CMP_LT_OQ))
+
+#elif !defined(HULL_NO_SIMD) && (defined(__SSE__) || defined(_M_X64))
+#include <xmmintrin.h>
+#define HULL_SIMD_WIDTH (4)
+typedef __m128 simdFloat;
+#define simdLoad(p) _mm_loadu_ps(p)
+#define simdSplat(x) _mm_set1_ps(x)
+#define simdAdd(a,b) _mm_add_ps(a,b)
+#define simdSub(a,b) _mm_sub_ps(a,b)
+#define simdMul(a,b) _mm_mul_ps(a,b)
+#define simdMax(a,b) _mm_max_ps(a,b)
+#define simdGreaterMask(a,b) _mm_movemask_ps(_mm_cmpgt_ps(a,b))
+#define simdGreaterEqualMask(a,b) _mm_movemask_ps(_mm_cmpge_ps(a,b))
+#define simdStore(p,a) _mm_storeu_ps(p,a)
+#define simdDiv(a,b) _mm_div_ps(a,b)
+#define simdMin(a,b) _mm_min_ps(a,b)
+#define simdSelectLess(a,b,x,y) _mm_or_ps(_mm_and_ps(_mm_cmplt_ps(a,b), x), _mm_andnot_ps(_mm_cmplt_ps(a,b), y))
+
+#elif !defined(HULL_NO_SIMD) && defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define HULL_SIMD_WIDTH (4)
+typedef float32x4_t simdFloat;
+
+int neonBitmask(const uint32x4_t mask) {
+  const int32x4_t shifts = {0, 1, 2, 3};
+  return (int)vaddvq_u32( vshlq_u32( vshrq_n_u32(mask, 31), shifts ) );
+}
+
+#define simdLoad(p) vld1q_f32(p)
+#define simdSplat(x) vdupq_n_f32(x)
+#define simdAdd(a,b) vaddq_f32(a,b)
+#define simdSub(a,b) vsubq_f32(a,b)
+#define simdMul(a,b) vmulq_f32(a,b)
+#define simdMax(a,b) vmaxq_f32(a,b)
+#define simdGreaterMask(a,b) neonBitmask(vcgtq_f32(a,b))
+#define simdGreaterEqualMask(a,b) neonBitmask(vcgeq_f32(a,b))
+#define simdStore(p,a) vst1q_f32(p,a)
+#define simdDiv(a,b) vdivq_f32(a,b)
+#define simdMin(a,b) vminq_f32(a,b)
+#define simdSelectLess(a,b,x,y) vbslq_f32(vcltq_f32(a,b), x, y)
+
+#else
+#define HULL_SIMD_WIDTH (1)
+#endif
+
+typedef struct {
+  float* nx;
+  float* ny;
+  float* nz;
+  float* d;
+} HullPlanes;
+
+float planeDistance(const HullPlanes* planes, const int i, const float* point) {
+  return planes->nx[i]*point[0] + planes->ny[i]*point[1] + planes->nz[i]*point[2] - planes->d[i];
+}
+
+// normal must be unit length, point is any point on the plane
+void setPlane(HullPlanes* planes, const int i, const float* normal, const float* point) {
+  planes->nx[i] = normal[0];
+  planes->ny[i] = normal[1];
+  planes->nz[i] = normal[2];
+  planes->d[i] = dot(normal, point);
+}
+
+void copyPlane(HullPlanes* outPlanes, const int outIndex, const HullPlanes* planes, const int i) {
+  outPlanes->nx[outIndex] = planes->nx[i];
+  outPlanes->ny[outIndex] = planes->ny[i];
+  outPlanes->nz[outIndex] = planes->nz[i];
+  outPlanes->d[outIndex] = planes->d[i];
+}
+
+#if HULL_SIMD_WIDTH > 1
+// signed distance of the point from planes i to i + HULL_SIMD_WIDTH - 1
+simdFloat simdPlaneDistances(const HullPlanes* planes, const int i, const simdFloat px, const simdFloat py, const simdFloat pz) {
+  const simdFloat xy = simdAdd( simdMul(simdLoad(planes->nx + i), px), simdMul(simdLoad(planes->ny + i), py) );
+  return simdSub( simdAdd( xy, simdMul(simdLoad(planes->nz + i), pz) ), simdLoad(planes->d + i) );
+}
+#endif
+
+// writes the planes that point is more than epsilon in front of. Returns the number of planes written
+int calcFacingPlanes(int* outPlanes, const HullPlanes* planes, const int numPlanes, const float* point, const float epsilon) {
+  int numOutPlanes = 0;
+  int i = 0;
+
+#if HULL_SIMD_WIDTH > 1
+  const simdFloat px = simdSplat(point[0]);
+  const simdFloat py = simdSplat(point[1]);
+  const simdFloat pz = simdSplat(point[2]);
+  const simdFloat threshold = simdSplat(epsilon);
+
+  for ( ; i + HULL_SIMD_WIDTH <= numPlanes; i += HULL_SIMD_WIDTH) {
+    int mask = simdGreaterMask( simdPlaneDistances(planes, i, px, py, pz), threshold );
+    while (mask) {
+      outPlanes[numOutPlanes++] = i + __builtin_ctz(mask);
+      mask &= mask - 1;
+    }
+  }
+#endif
+
+  for ( ; i < numPlanes; i++) {
+    if (planeDistance(planes, i, point) > epsilon) {
+      outPlanes[numOutPlanes++] = i;
+    }
+  }
+
+  return numOutPlanes;
+}
+
+// returns the plane that point is farthest in front of (or least behind), and its signed distance in
+// outDistance. numPlanes must be at least 1
+int calcFarthestPlane(float* outDistance, const HullPlanes* planes, const int numPlanes, const float* point) {
+  float maxDistance = -FLT_MAX;
+  int i = 0;
+
+#if HULL_SIMD_WIDTH > 1
+  const simdFloat px = simdSplat(point[0]);
+  const simdFloat py = simdSplat(point[1]);
+  const simdFloat pz = simdSplat(point[2]);
+  const int numSimdPlanes = numPlanes - numPlanes % HULL_SIMD_WIDTH;
+
+  if (numSimdPlanes > 0) {
+    float lanes[HULL_SIMD_WIDTH];
+    simdFloat maxDistances = simdPlaneDistances(planes, 0, px, py, pz);
+
+    for (i = HULL_SIMD_WIDTH; i < numSimdPlanes; i += HULL_SIMD_WIDTH) {
+      maxDistances = simdMax( maxDistances, simdPlaneDistances(planes, i, px, py, pz) );
+    }
+
+    simdStore(lanes, maxDistances);
+    for (int lane = 0; lane < HULL_SIMD_WIDTH; lane++) {
+      maxDistance = fmaxf(maxDistance, lanes[lane]);
+    }
+  }
+#endif
+
+  int farthest = -1;
+
+  for ( ; i < numPlanes; i++) {
+    const float distance = planeDistance(planes, i, point);
+    if (distance > maxDistance) {
+      maxDistance = distance;
+      farthest = i;
+    }
+  }
+
+#if HULL_SIMD_WIDTH > 1
+  // the farthest plane is in the vector part, so find the first plane with the maximum distance
+  if (farthest == -1) {
+    const simdFloat threshold = simdSplat(maxDistance);
+
+    for (i = 0; farthest == -1 && i < numSimdPlanes; i += HULL_SIMD_WIDTH) {
+      const int mask = simdGreaterEqualMask( simdPlaneDistances(planes, i, px, py, pz), threshold );
+      if (mask) {
+        farthest = i + __builtin_ctz(mask);
+      }
+    }
+  }
+#endif
+
+  *outDistance = maxDistance;
+  return farthest;
+}
+
+// Planar hull
+// When every point is coplanar there is no tetrahedron to start from, so the hull is the convex polygon of the
+// points, from Andrew's monotone chain on the points projected onto the two axes the plane faces least. Points
+// strictly inside the octagon of the projected extremes are culled first with the plane kernels, and each
+// turn of the chain is decided by orient3d(), so the polygon is exact.
+// The polygon is written as a fan of triangles on each side, so it is still a closed mesh (2*numCorners - 4
+// triangles, and every edge has a twin) in the same format as a solid hull. A budgeted build keeps the same
+// limits on it, see reducePlanarHull().
+
+#define NUM_PLANAR_CORNERS (8)
+
+typedef struct {
+  float u, v;
+  int index;
+} PlanarPoint;
+
+// exact, positive if the projected points turn left. The projection keeps the sign of the turn in the plane,
+// and the projected points are close together in memory, unlike the vertices
+double calcPlanarTurn(const PlanarPoint* a, const PlanarPoint* b, const PlanarPoint* c) {
+  const float pa[] = { a->u, a->v, 0.f };
+  const float pb[] = { b->u, b->v, 0.f };
+  const float pc[] = { c->u, c->v, 0.f };
+  const float above[] = { 0.f, 0.f, 1.f };
+  return orient3d(pa, pb, pc, above);
+}
+
+int comparePlanarPoints(const void* a, const void* b) {
+  const PlanarPoint* p = a;
+  const PlanarPoint* q = b;
+  if (p->u != q->u) {
+    return p->u < q->u ? -1 : 1;
+  }
+  if (p->v != q->v) {
+    return p->v < q->v ? -1 : 1;
+  }
+  return p->index - q->index;
+}
+
+float distanceToLineSquared(const float* a, const float* b, const float* point) {
+  float ab[] = {0.f,0.f,0.f};
+  float ap[] = {0.f,0.f,0.f};
+  float perpendicular[] = {0.f,0.f,0.f};
+
+  sub(ab, b, a);
+  sub(ap, point, a);
+  cross(perpendicular, ab, ap);
+
+  const float lengthSquared = dot(ab, ab);
+  return lengthSquared > 0.f ? dot(perpendicular, perpendicular)/lengthSquared : dot(ap, ap);
+}
+
+// picks the two most distant extremes, the point farthest from the line between them, and then the point
+// farthest from the plane of those three. Returns the number of points found, 4 unless all points are the same
+// (1), collinear (2) or coplanar (3, exactly, see orient3d())
+int calcInitialSimplex(int* outIndices, const float* vertices, const int numVertices, const int stride) {
+  int extremes[2*FLOATS_PER_VERTEX] = {0};
+  const int numExtremes = calcExtremes(extremes, vertices, numVertices, stride);
+  float maxDistance = 0.f;
+  float delta[] = {0.f,0.f,0.f};
+  float normal[] = {0.f,0.f,0.f};
+
+  outIndices[0] = outIndices[1] = extremes[0];
+
+  for (int i = 0; i < numExtremes; i++) {
+    for (int j = i + 1; j < numExtremes; j++) {
+      sub(delta, vertices + extremes[i], vertices + extremes[j]);
+      const float distance = dot(delta, delta);
+      if (distance > maxDistance) {
+        maxDistance = distance;
+        outIndices[0] = extremes[i];
+        outIndices[1] = extremes[j];
+      }
+    }
+  }
+
+  if (maxDistance <= 0.f) {
+    return 1; // all points are the same
+  }
+
+  maxDistance = 0.f;
+  for (int i = 0; i < numVertices; i += stride) {
+    const float distance = distanceToLineSquared(vertices + outIndices[0], vertices + outIndices[1], vertices + i);
+    if (distance > maxDistance) {
+      maxDistance = distance;
+      outIndices[2] = i;
+    }
+  }
+
+  if (maxDistance <= 0.f) {
+    return 2; // all points are collinear
+  }
+
+  maxDistance = 0.f;
+  setFromCoplanarPoints(normal, vertices + outIndices[0], vertices + outIndices[1], vertices + outIndices[2]);
+  for (int i = 0; i < numVertices; i += stride) {
+    sub(delta, vertices + i, vertices + outIndices[0]);
+    const float distance = fabsf( dot(delta, normal) );
+    if (distance > maxDistance) {
+      maxDistance = distance;
+      outIndices[3] = i;
+    }
+  }
+
+  const float* a = vertices + outIndices[0];
+  const float* b = vertices + outIndices[1];
+  const float* c = vertices + outIndices[2];
+
+  // the farthest point by float distance can still be coplanar, so look for any point which is not
+  for (int i = 0; orient3d(a, b, c, vertices + outIndices[3]) == 0.; i += stride) {
+    if (i >= numVertices) {
+      return 3; // all points are coplanar
+    }
+    outIndices[3] = i;
+  }
+
+  return 4;
+}
+
+// sorts the points and writes the corners of their convex polygon to outChain (room for numPoints + 1),
+// counter-clockwise in (u, v). Returns the number of corners
+int calcPlanarChain(PlanarPoint* outChain, PlanarPoint* points, const int numPoints) {
+  qsort(points, numPoints, sizeof(PlanarPoint), comparePlanarPoints);
+
+  // the lower chain from left to right, then the upper chain back again, dropping corners which are not a left
+  // turn. The last corner is the first one again
+  int numLoop = 0;
+  for (int i = 0; i < numPoints; i++) {
+    while (numLoop >= 2 && calcPlanarTurn(outChain + numLoop - 2, outChain + numLoop - 1, points + i) <= 0.) {
+      numLoop--;
+    }
+    outChain[numLoop++] = points[i];
+  }
+
+  for (int i = numPoints - 2, numLower = numLoop; i >= 0; i--) {
+    while (numLoop > numLower && calcPlanarTurn(outChain + numLoop - 2, outChain + numLoop - 1, points + i) <= 0.) {
+      numLoop--;
+    }
+    outChain[numLoop++] = points[i];
+  }
+
+  return numLoop > 0 ? numLoop - 1 : 0;
+}
+
+// writes the corners of the polygon of the coplanar vertices to outLoop (room for one per point), where triangle
+// is 3 vertices which are not collinear (see calcInitialSimplex()). The corners are counter-clockwise when seen
+// from the side the triangle faces. Returns the number of corners, 0 if out of memory
+int calcPlanarHull(int* outLoop, const float* vertices, const int numVertices, const int stride, const int* triangle) {
+  const int numPoints = (numVertices + stride - 1)/stride;
+  const float* a = vertices + triangle[0];
+  const float maxCoord = growMaxCoord(0.f, vertices, numVertices, stride);
+  float normal[] = {0.f,0.f,0.f};
+
+  setFromCoplanarPoints(normal, a, vertices + triangle[1], vertices + triangle[2]);
+
+  // drop the axis the normal is most along, and swap the other two if the normal points down that axis, so a
+  // left turn in (u, v) is counter-clockwise when seen from the side the triangle faces
+  const float absNormal[] = { fabsf(normal[0]), fabsf(normal[1]), fabsf(normal[2]) };
+  const int axis = absNormal[0] >= absNormal[1] && absNormal[0] >= absNormal[2] ? 0 : absNormal[1] >= absNormal[2] ? 1 : 2;
+  const float side = normal[axis] > 0.f ? 1.f : -1.f;
+  const int uAxis = side > 0.f ? (axis + 1) % 3 : (axis + 2) % 3;
+  const int vAxis = side > 0.f ? (axis + 2) % 3 : (axis + 1) % 3;
+  const float height = side*2.f*(maxCoord + 1.f);
+
+  PlanarPoint* points = malloc((2*numPoints + 1)*sizeof(PlanarPoint));
+  if (points == NULL) {
+    return 0;
+  }
+
+  PlanarPoint* chain = points + numPoints;
+  // the extremes along 8 directions in (u, v), in counter-clockwise order
+  const float directions[NUM_PLANAR_CORNERS][2] = { {0.f,-1.f}, {1.f,-1.f}, {1.f,0.f}, {1.f,1.f}, {0.f,1.f}, {-1.f,1.f}, {-1.f,0.f}, {-1.f,-1.f} };
+  float maxProjections[NUM_PLANAR_CORNERS];
+  int corners[NUM_PLANAR_CORNERS] = {0};
+
+  for (int k = 0; k < NUM_PLANAR_CORNERS; k++) {
+    maxProjections[k] = -FLT_MAX;
+  }
+
+  for (int i = 0; i < numVertices; i += stride) {
+    const float* p = vertices + i;
+    for (int k = 0; k < NUM_PLANAR_CORNERS; k++) {
+      const float projection = directions[k][0]*p[uAxis] + directions[k][1]*p[vAxis];
+      if (projection > maxProjections[k]) {
+        maxProjections[k] = projection;
+        corners[k] = i;
+      }
+    }
+  }
+
+  // each edge of the octagon becomes a plane through the edge and a point above it, with the inside of the
+  // octagon behind it. The octagon's corners are points, so everything inside it is inside the hull
+  float planeBuffer[4*NUM_PLANAR_CORNERS];
+  HullPlanes planes = { planeBuffer, planeBuffer + NUM_PLANAR_CORNERS, planeBuffer + 2*NUM_PLANAR_CORNERS, planeBuffer + 3*NUM_PLANAR_CORNERS };
+  int numPlanes = 0;
+  float maxPlaneError = 0.f;
+
+  for (int i = 0; i < NUM_PLANAR_CORNERS; i++) {
+    const float* p = vertices + corners[i];
+    const float* q = vertices + corners[(i + 1) % NUM_PLANAR_CORNERS];
+    float above[] = { p[0], p[1], p[2] };
+    float edgeNormal[] = {0.f,0.f,0.f};
+
+    if (p[0] != q[0] || p[1] != q[1] || p[2] != q[2]) {
+      above[axis] += height;
+      setFromCoplanarPoints(edgeNormal, p, q, above);
+      setPlane(&planes, numPlanes++, edgeNormal, p);
+      maxPlaneError = fmaxf(maxPlaneError, calcPlaneError(p, q, above, 3.f*maxCoord + 2.f));
+    }
+  }
+
+  int numCandidates = 0;
+  float distance = 0.f;
+  for (int i = 0; i < numVertices; i += stride) {
+    const float* p = vertices + i;
+    if (numPlanes >= 3) {
+      calcFarthestPlane(&distance, &planes, numPlanes, p);
+      if (distance < -maxPlaneError) {
+        continue; // strictly inside the octagon
+      }
+    }
+
+    points[numCandidates++] = (PlanarPoint){ p[uAxis], p[vAxis], i };
+  }
+
+  const int numLoop = calcPlanarChain(chain, points, numCandidates);
+  for (int i = 0; i < numLoop; i++) {
+    outLoop[i] = chain[i].index;
+  }
+
+  free(points);
+
+  return numLoop;
+}
+
+// writes the polygon as a fan of triangles on each side, see above. Returns the number of indices
+int writePlanarTriangles(int* outIndices, const int* loop, const int numLoop) {
+  int numIndices = 0;
+
+  for (int i = 1; i + 1 < numLoop; i++) {
+    outIndices[numIndices++] = loop[0];
+    outIndices[numIndices++] = loop[i];
+    outIndices[numIndices++] = loop[i + 1];
+  }
+
+  for (int i = 1; i + 1 < numLoop; i++) {
+    outIndices[numIndices++] = loop[0];
+    outIndices[numIndices++] = loop[i + 1];
+    outIndices[numIndices++] = loop[i];
+  }
+
+  return numIndices;
+}
+
+// the hull of coplanar vertices, as triangles. Returns the number of indices, or -2 if the vertices are collinear
+// (or not coplanar at all) and -3 if out of memory
+int generatePlanarHullTriangles(int* outIndices, const float* vertices, const int numVertices, const int stride) {
+  int triangle[4] = {0};
+  if (calcInitialSimplex(triangle, vertices, numVertices, stride) != 3) {
+    return -2;
+  }
+
+  int* loop = malloc((numVertices + stride - 1)/stride*sizeof(int));
+  const int numLoop = loop ? calcPlanarHull(loop, vertices, numVertices, stride, triangle) : 0;
+  const int result = numLoop > 0 ? writePlanarTriangles(outIndices, loop, numLoop) : -3;
+
+  free(loop);
+  return result;
+}
+
 // int faceIndices[MAX_FACES][POINTS_PER_FACE] = {0};
 // float faceNormals[MAX_FACES][FLOATS_PER_NORMAL] = {0.f};
 // int outFaces[MAX_FACES] = {0};
 // int outEdges[MAX_FACES][EDGES_PER_FACE][POINTS_PER_EDGE] = {0};
 // int numOutFaces = 0;
 
-EMSCRIPTEN_KEEPALIVE
-int generateHullTriangles(int* outIndices, const float* vertices, const int numVertices, const int stride) {
+// writes the faces that point is in front of, where planeErrors are from calcPlaneError() and maxPlaneError is
+// at least the largest of them. Only the faces within their error of the point need orient3d(). Returns the
+// number of faces written
+int calcFacingFacesExact(int* outFaces, const HullPlanes* planes, const float* planeErrors, const float maxPlaneError, const int* faceIndices, const float* vertices, const int numFaces, const float* point) {
+  const int numCandidates = calcFacingPlanes(outFaces, planes, numFaces, point, -maxPlaneError);
+  int numOutFaces = 0;
+
+  for (int i = 0; i < numCandidates; i++) {
+    const int face = outFaces[i];
+    const int* indices = faceIndices + face*POINTS_PER_FACE;
+    const float distance = planeDistance(planes, face, point);
+
+    if (isInFrontOfPlane(vertices + indices[0], vertices + indices[1], vertices + indices[2], point, distance, planeErrors[face])) {
+      outFaces[numOutFaces++] = face;
+    }
+  }
+
+  return numOutFaces;
+}
+
+// the original builder, which adds the points in order and checks each one against every face, with at most
+// MAX_FACES faces. It is only kept as the baseline for bench/bench-hull.c, generateHullTriangles() is Quickhull
+int generateHullTrianglesLegacy(int* outIndices, const float* vertices, const int numVertices, const int stride) {
   if (numVertices < 12) {
     return -1; // not enough vertices
   }
 
-  const float TOLERANCE = 1e-5f;
-  float centroid[] = {0.f,0.f,0.f}; // this is only the approximate center, but will always be within the hull
+  const float maxCoord = growMaxCoord(0.f, vertices, numVertices, stride);
+  float centroid[] = {0.f,0.f,0.f}; // center of the initial pyramid, only used to orient its faces
+  float maxPlaneError = 0.f;
   int numFaces = 0;
-  int numProcessed = 4;
   int numIndices = 0;
 
   int* outEdges = malloc(MAX_FACES*sizeof(int));
   int* outFaces = malloc(MAX_FACES*sizeof(int));
   int* faceIndices = malloc(MAX_FACES*POINTS_PER_FACE*sizeof(int));
   float* faceNormals = malloc(MAX_FACES*FLOATS_PER_NORMAL*sizeof(float));
+  float* planeErrors = malloc(MAX_FACES*sizeof(float));
+  float* planeBuffer = malloc(MAX_FACES*4*sizeof(float));
+  HullPlanes planes = { planeBuffer, planeBuffer + MAX_FACES, planeBuffer + 2*MAX_FACES, planeBuffer + 3*MAX_FACES };
 
   int extremes[6] = {0};
+  HULL_PHASE_BEGIN(calcExtremes);
   const int numExtremes = calcExtremes(extremes, vertices, numVertices, stride);
+  HULL_PHASE_END(calcExtremes);
 
   // form a triangular pyramid from the first 4 non-coplanar points
   int ai = extremes[0]; //0;
@@ -321,7 +1096,7 @@ int generateHullTriangles(int* outIndices, const float* vertices, const int numV
   int di = numExtremes > 3 ? extremes[3] : 3*stride;
 
   for ( ; di < numVertices; di += stride) {
-    if (!areCoplanar(vertices + ai, vertices + bi, vertices + ci, vertices + di, TOLERANCE)) {
+    if (orient3d(vertices + ai, vertices + bi, vertices + ci, vertices + di) != 0.) {
       add(centroid, vertices + ai, vertices + bi);
       add(centroid, centroid, vertices + ci);
       add(centroid, centroid, vertices + di);
@@ -331,34 +1106,39 @@ int generateHullTriangles(int* outIndices, const float* vertices, const int numV
       buildFace(faceIndices + 3, faceNormals + 3, vertices, ai, bi, di, centroid);
       buildFace(faceIndices + 6, faceNormals + 6, vertices, ai, ci, di, centroid);
       buildFace(faceIndices + 9, faceNormals + 9, vertices, bi, ci, di, centroid);
+      for (int i = 0; i < 4; i++) {
+        const int* indices = faceIndices + i*POINTS_PER_FACE;
+        setPlane(&planes, i, faceNormals + i*FLOATS_PER_NORMAL, vertices + indices[0]);
+        planeErrors[i] = calcPlaneError(vertices + indices[0], vertices + indices[1], vertices + indices[2], maxCoord);
+        maxPlaneError = fmaxf(maxPlaneError, planeErrors[i]);
+      }
       numFaces = 4;
-      numProcessed = 4;
       break;
     }
   }
 
   if (numFaces == 0) {
-    return -2; // all points are coplanar, unable to build a hull
+    // all points are coplanar, so the hull is a polygon (or -2 if they are collinear)
+    numIndices = generatePlanarHullTriangles(outIndices, vertices, numVertices, stride);
   }
 
-  for (int xi = 3*stride; xi < numVertices; xi += stride) {
-    // if (xi == di) {
-    //   continue;
-    // }
+  // every point is tested, as the pyramid comes from the extremes rather than the first points. Points already
+  // on the hull (including the pyramid's) are never in front of a face
+  for (int xi = 0; numIndices == 0 && xi < numVertices; xi += stride) {
 
     // printf("numFaces %d %d of %d\n", numFaces, xi, numVertices);
 
-    const int numFacing = calcFacingFaces(outFaces, vertices, faceIndices, faceNormals, numFaces, vertices + xi);
+    HULL_PHASE_BEGIN(calcFacingPlanes);
+    const int numFacing = calcFacingFacesExact(outFaces, &planes, planeErrors, maxPlaneError, faceIndices, vertices, numFaces, vertices + xi);
+    HULL_PHASE_END(calcFacingPlanes);
 
     if (numFacing == 0) {
       continue;
     }
 
+    HULL_PHASE_BEGIN(calcOutsideEdges);
     const int numEdges = calcOutsideEdges(outEdges, faceIndices, outFaces, numFacing);
-
-    // recaluclate the centroid
-    scaleAndAdd(centroid, vertices + xi, centroid, numProcessed);
-    multiplyScalar(centroid, centroid, 1.f/(numProcessed + 1.f));
+    HULL_PHASE_END(calcOutsideEdges);
 
     // remove all facing triangles
     // replace the face with a face from the end of the list
@@ -378,28 +1158,3668 @@ int generateHullTriangles(int* outIndices, const float* vertices, const int numV
       faceNormals[k] = faceNormals[m];
       faceNormals[k+1] = faceNormals[m+1];
       faceNormals[k+2] = faceNormals[m+2];
+
+      copyPlane(&planes, faceIndex, &planes, numFaces);
+      planeErrors[faceIndex] = planeErrors[numFaces];
     }
 
-    // add faces using the outside edges to the new xi point
+    // add faces using the outside edges to the new xi point. The edges keep the winding of the facing
+    // triangles, so the new faces are already counter-clockwise when seen from outside
     for (int index = 0; index < numEdges; index++) {
       const int edgeIndex = index*POINTS_PER_EDGE;
       const int faceIndex = numFaces*POINTS_PER_FACE;
-      buildFace(faceIndices + faceIndex, faceNormals + faceIndex, vertices, outEdges[edgeIndex], outEdges[edgeIndex+1], xi, centroid);
+      const int ei = outEdges[edgeIndex];
+      const int fi = outEdges[edgeIndex+1];
+      faceIndices[faceIndex] = ei;
+      faceIndices[faceIndex+1] = fi;
+      faceIndices[faceIndex+2] = xi;
+      setFromCoplanarPoints(faceNormals + faceIndex, vertices + ei, vertices + fi, vertices + xi);
+      setPlane(&planes, numFaces, faceNormals + faceIndex, vertices + ei);
+      planeErrors[numFaces] = calcPlaneError(vertices + ei, vertices + fi, vertices + xi, maxCoord);
+      maxPlaneError = fmaxf(maxPlaneError, planeErrors[numFaces]);
       numFaces++;
       if (numFaces >= MAX_FACES) {
         // printf("too many faces\n");
-        return -3; // out of memory, increase MAX_FACES
+        numIndices = -3; // out of memory, increase MAX_FACES (or use generateHullTrianglesWithContext())
+        break;
       }
     }
 
   }
 
-  memcpy(outIndices, faceIndices, numFaces*POINTS_PER_FACE*sizeof(int));
+  if (numIndices == 0) {
+    memcpy(outIndices, faceIndices, numFaces*POINTS_PER_FACE*sizeof(int));
+    numIndices = numFaces*POINTS_PER_FACE;
+  }
 
   free(faceIndices);
   free(faceNormals);
+  free(planeErrors);
+  free(planeBuffer);
   free(outEdges);
   free(outFaces);
 
-  return numFaces*POINTS_PER_FACE;
-}
\ No newline at end of file
+  return numIndices;
+}
+
+// Quickhull
+// Each face keeps an outside set of the points that can see it. The farthest point of a face's outside set is
+// always added next, points that are not outside any face are dropped, so the work scales with the size of
+// the output rather than the number of input points multiplied by the number of faces.
+//
+// Faces are connected by half-edges. Half-edge k of a face runs from faceIndices[k] to faceIndices[(k+1)%3]
+// and is identified by face*EDGES_PER_FACE + k, faceTwins holds the matching half-edge of the neighbouring face.
+// The visible faces and the horizon are found by walking over the neighbours, starting from the face that
+// the new point is outside of.
+//
+// All of the working memory belongs to a HullContext, which can be reused across calls. The per face storage
+// and the per point storage each grow on demand, so there is no upper limit on the number of faces.
+
+#define NO_INDEX (-1)
+#define MAX_UINT16_VERTICES (65536) // hulls with fewer vertices than this have uint16_t compact indices
+#define MIN_CONTEXT_FACES (64)
+#define NUM_KDOP_AXES (13)
+#define MAX_CULL_PLANES (2*2*NUM_KDOP_AXES - 4)
+
+// flags for hullContextSetFlags()
+#define HULL_CULL_INTERIOR (1) // discard points inside the hull of the k-DOP extremes before building
+#define HULL_COLLECT_STATS (2) // time the phases of each build, see hullContextGetStats()
+
+// what the last build with a context did, see hullContextGetStats(). Every field is a double so the wasm
+// binding can read the struct as a Float64Array, and the JS names are in the same order
+typedef struct {
+  // seconds in each phase, only timed with HULL_COLLECT_STATS
+  double extremesSeconds; // the initial simplex and the culling polytope
+  double seedSeconds; // building the simplex (or the planar hull) and the first outside sets
+  double visibilitySeconds; // walking the faces visible from each new vertex
+  double horizonSeconds; // copying the horizon and gathering the outside sets of the visible faces
+  double rebuildSeconds; // adding the new faces and reassigning the gathered points to them
+
+  double numPoints; // points in the input
+  double numCulledPoints; // points inside the culling polytope, never assigned to a face
+  double numDroppedPoints; // assignments which found the point inside the hull
+  double numExpansions; // points added to the hull
+  double numFacesCreated;
+  double numFacesDestroyed;
+  double peakLiveFaces;
+  double numVisibleFaces; // summed over the expansions
+  double numHorizonEdges; // summed over the expansions
+  double maxHorizonEdges;
+} HullStats;
+
+typedef struct HullContext {
+  int flags;
+  const float* vertices;
+  int numVertices;
+  int stride;
+  float maxCoord; // largest absolute coordinate of the vertices, for calcPlaneError()
+
+  // per face storage, faceCapacity faces
+  int* faceIndices; // POINTS_PER_FACE per face, counter-clockwise when seen from outside, the first index is NO_INDEX for deleted faces
+  int* faceTwins; // EDGES_PER_FACE per face, the opposite half-edge in the neighbouring face
+  HullPlanes planes; // one plane per face
+  float* planeErrors; // bound on the rounding error of each plane, distances within it are decided by orient3d()
+  HullPlanes newPlanes; // EDGES_PER_FACE per face, planes of the faces in newFaces
+  int* outsideHeads; // first point in the outside set of each face, NO_INDEX if empty
+  int* farthestPoints; // farthest point in the outside set of each face
+  float* farthestDistances;
+  int* faceMarks; // faceMarks[face] == visibleMark when the face is visible from the current point
+  int* freeFaces; // deleted faces which can be reused
+  int* pendingFaces; // faces which may have a non-empty outside set
+  bool* isPending; // a face is only added once to pendingFaces, even if it is deleted and reused
+  int* visibleFaces;
+  int* horizon; // EDGES_PER_FACE per face, half-edges of the visible faces which border a hidden face, in counter-clockwise order
+  int* horizonStack; // 3 ints per face, face, next edge and number of edges remaining
+  int* newFaces; // EDGES_PER_FACE per face
+  int* outEdges; // EDGES_PER_FACE*POINTS_PER_EDGE per face
+  int faceCapacity;
+  float newPlanesError; // the largest planeErrors of the faces in newPlanes
+
+  // per point storage, pointCapacity points
+  int* pointNext; // next point in an outside set, indexed by vertex number (vertex index/stride)
+  int* orphans; // points from the outside sets of deleted faces
+  int pointCapacity;
+
+  int numFaces; // includes deleted faces
+  int numLiveFaces;
+  int numFreeFaces;
+  int numPendingFaces;
+  int visibleMark;
+  bool isPlanar; // the points are coplanar, and the hull is a polygon with a fan of faces on each side
+
+  int highWaterFaces;
+  int highWaterPoints;
+  HullStats stats; // since the last clearHull()
+
+  struct HullContext* cullContext; // builds the culling polytope, created on first use
+  float cullPlaneBuffer[4*MAX_CULL_PLANES];
+  HullPlanes cullPlanes;
+  float cullPlanesError; // the largest plane error of cullPlanes
+
+  // general purpose storage for the entry points which build more than one hull
+  int* scratchIndices;
+  float* scratchVertices; // FLOATS_PER_VERTEX per index
+  int scratchCapacity;
+
+  int* weldTable; // hash table of grid cells for weldPoints(), the offset of the first point in each cell
+  int weldTableCapacity;
+} HullContext;
+
+#define BYTES_PER_FACE ( (POINTS_PER_FACE + 3*EDGES_PER_FACE + EDGES_PER_FACE*POINTS_PER_EDGE + 9)*sizeof(int) + (4 + 4*EDGES_PER_FACE + 2)*sizeof(float) + sizeof(bool) )
+#define BYTES_PER_POINT ( 2*sizeof(int) )
+
+bool resizeBuffer(void** buffer, const size_t numBytes) {
+  void* newBuffer = realloc(*buffer, numBytes);
+  if (newBuffer == NULL) {
+    return false;
+  }
+
+  *buffer = newBuffer;
+  return true;
+}
+
+// grows the per face storage to hold at least numFaces, keeping the current hull. Returns false if out of memory
+bool reserveFaces(HullContext* ctx, const int numFaces) {
+  if (numFaces <= ctx->faceCapacity) {
+    return true;
+  }
+
+  int capacity = ctx->faceCapacity < MIN_CONTEXT_FACES ? MIN_CONTEXT_FACES : ctx->faceCapacity;
+  while (capacity < numFaces) {
+    capacity *= 2;
+  }
+
+  const size_t n = capacity;
+  if (!resizeBuffer((void**)&ctx->faceIndices, n*POINTS_PER_FACE*sizeof(int)) ||
+    !resizeBuffer((void**)&ctx->faceTwins, n*EDGES_PER_FACE*sizeof(int)) ||
+    !resizeBuffer((void**)&ctx->planes.nx, n*sizeof(float)) ||
+    !resizeBuffer((void**)&ctx->planes.ny, n*sizeof(float)) ||
+    !resizeBuffer((void**)&ctx->planes.nz, n*sizeof(float)) ||
+    !resizeBuffer((void**)&ctx->planes.d, n*sizeof(float)) ||
+    !resizeBuffer((void**)&ctx->planeErrors, n*sizeof(float)) ||
+    !resizeBuffer((void**)&ctx->newPlanes.nx, n*EDGES_PER_FACE*sizeof(float)) ||
+    !resizeBuffer((void**)&ctx->newPlanes.ny, n*EDGES_PER_FACE*sizeof(float)) ||
+    !resizeBuffer((void**)&ctx->newPlanes.nz, n*EDGES_PER_FACE*sizeof(float)) ||
+    !resizeBuffer((void**)&ctx->newPlanes.d, n*EDGES_PER_FACE*sizeof(float)) ||
+    !resizeBuffer((void**)&ctx->outsideHeads, n*sizeof(int)) ||
+    !resizeBuffer((void**)&ctx->farthestPoints, n*sizeof(int)) ||
+    !resizeBuffer((void**)&ctx->farthestDistances, n*sizeof(float)) ||
+    !resizeBuffer((void**)&ctx->faceMarks, n*sizeof(int)) ||
+    !resizeBuffer((void**)&ctx->freeFaces, n*sizeof(int)) ||
+    !resizeBuffer((void**)&ctx->pendingFaces, n*sizeof(int)) ||
+    !resizeBuffer((void**)&ctx->isPending, n*sizeof(bool)) ||
+    !resizeBuffer((void**)&ctx->visibleFaces, n*sizeof(int)) ||
+    !resizeBuffer((void**)&ctx->horizon, n*EDGES_PER_FACE*sizeof(int)) ||
+    !resizeBuffer((void**)&ctx->horizonStack, n*3*sizeof(int)) ||
+    !resizeBuffer((void**)&ctx->newFaces, n*EDGES_PER_FACE*sizeof(int)) ||
+    !resizeBuffer((void**)&ctx->outEdges, n*EDGES_PER_FACE*POINTS_PER_EDGE*sizeof(int))) {
+    return false; // the buffers which did grow are still valid, faceCapacity is unchanged
+  }
+
+  memset(ctx->isPending + ctx->faceCapacity, 0, (capacity - ctx->faceCapacity)*sizeof(bool));
+  ctx->faceCapacity = capacity;
+  return true;
+}
+
+// grows the per point storage to hold at least numPoints. Returns false if out of memory
+bool reservePoints(HullContext* ctx, const int numPoints) {
+  if (numPoints <= ctx->pointCapacity) {
+    return true;
+  }
+
+  if (!resizeBuffer((void**)&ctx->pointNext, numPoints*sizeof(int)) ||
+    !resizeBuffer((void**)&ctx->orphans, numPoints*sizeof(int))) {
+    return false;
+  }
+
+  ctx->pointCapacity = numPoints;
+  return true;
+}
+
+EMSCRIPTEN_KEEPALIVE
+void hullContextDestroy(HullContext* ctx) {
+  if (ctx == NULL) {
+    return;
+  }
+
+  free(ctx->faceIndices);
+  free(ctx->faceTwins);
+  free(ctx->planes.nx);
+  free(ctx->planes.ny);
+  free(ctx->planes.nz);
+  free(ctx->planes.d);
+  free(ctx->planeErrors);
+  free(ctx->newPlanes.nx);
+  free(ctx->newPlanes.ny);
+  free(ctx->newPlanes.nz);
+  free(ctx->newPlanes.d);
+  free(ctx->outsideHeads);
+  free(ctx->farthestPoints);
+  free(ctx->farthestDistances);
+  free(ctx->faceMarks);
+  free(ctx->freeFaces);
+  free(ctx->pendingFaces);
+  free(ctx->isPending);
+  free(ctx->visibleFaces);
+  free(ctx->horizon);
+  free(ctx->horizonStack);
+  free(ctx->newFaces);
+  free(ctx->outEdges);
+  free(ctx->pointNext);
+  free(ctx->orphans);
+  free(ctx->scratchIndices);
+  free(ctx->scratchVertices);
+  free(ctx->weldTable);
+  hullContextDestroy(ctx->cullContext);
+  free(ctx);
+}
+
+// grows scratchIndices and scratchVertices to hold at least numIndices. Returns false if out of memory
+bool reserveScratch(HullContext* ctx, const int numIndices) {
+  if (numIndices <= ctx->scratchCapacity) {
+    return true;
+  }
+
+  if (!resizeBuffer((void**)&ctx->scratchIndices, numIndices*sizeof(int)) ||
+    !resizeBuffer((void**)&ctx->scratchVertices, numIndices*FLOATS_PER_VERTEX*sizeof(float))) {
+    return false;
+  }
+
+  ctx->scratchCapacity = numIndices;
+  return true;
+}
+
+// returns NULL if out of memory. initialFaces and initialPoints may be 0, the storage grows as needed
+EMSCRIPTEN_KEEPALIVE
+HullContext* hullContextCreate(const int initialFaces, const int initialPoints) {
+  HullContext* ctx = calloc(1, sizeof(HullContext));
+
+  if (ctx && (!reserveFaces(ctx, initialFaces) || !reservePoints(ctx, initialPoints))) {
+    hullContextDestroy(ctx);
+    return NULL;
+  }
+
+  return ctx;
+}
+
+// forgets the current hull, but keeps the memory for the next build
+void clearHull(HullContext* ctx) {
+  for (int i = 0; i < ctx->numPendingFaces; i++) {
+    ctx->isPending[ctx->pendingFaces[i]] = false;
+  }
+
+  ctx->numFaces = 0;
+  ctx->numLiveFaces = 0;
+  ctx->numFreeFaces = 0;
+  ctx->numPendingFaces = 0;
+  ctx->isPlanar = false;
+  memset(&ctx->stats, 0, sizeof(ctx->stats));
+}
+
+// flags is a combination of HULL_CULL_INTERIOR and HULL_COLLECT_STATS, and applies to all future builds with
+// this context
+EMSCRIPTEN_KEEPALIVE
+void hullContextSetFlags(HullContext* ctx, const int flags) {
+  ctx->flags = flags;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int hullContextGetFlags(const HullContext* ctx) {
+  return ctx->flags;
+}
+
+// forgets the current hull and the high-water marks, the memory is kept
+EMSCRIPTEN_KEEPALIVE
+void hullContextReset(HullContext* ctx) {
+  clearHull(ctx);
+  ctx->highWaterFaces = 0;
+  ctx->highWaterPoints = 0;
+}
+
+// the most faces (including deleted faces awaiting reuse) needed by any build since the last reset
+EMSCRIPTEN_KEEPALIVE
+int hullContextHighWaterFaces(const HullContext* ctx) {
+  return ctx->highWaterFaces;
+}
+
+// the most points in any build since the last reset
+EMSCRIPTEN_KEEPALIVE
+int hullContextHighWaterPoints(const HullContext* ctx) {
+  return ctx->highWaterPoints;
+}
+
+// bytes of working memory that hullContextCreate(highWaterFaces, highWaterPoints) would allocate
+EMSCRIPTEN_KEEPALIVE
+int hullContextHighWaterBytes(const HullContext* ctx) {
+  return (int)(ctx->highWaterFaces*BYTES_PER_FACE + ctx->highWaterPoints*BYTES_PER_POINT);
+}
+
+// the statistics of the last build, or of the inserts since the last build for a Hull. The counts are always
+// kept, the times are 0 unless the flags include HULL_COLLECT_STATS
+EMSCRIPTEN_KEEPALIVE
+const HullStats* hullContextGetStats(const HullContext* ctx) {
+  return &ctx->stats;
+}
+
+// seconds from an arbitrary start, only for measuring intervals
+double hullNow() {
+#ifdef __EMSCRIPTEN__
+  return emscripten_get_now()*1e-3;
+#else
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec*1e-9;
+#endif
+}
+
+bool isCollectingStats(const HullContext* ctx) {
+  return (ctx->flags & HULL_COLLECT_STATS) != 0;
+}
+
+float distanceToFace(const HullContext* ctx, const int face, const float* point) {
+  return planeDistance(&ctx->planes, face, point);
+}
+
+// exact test of whether point is outside the face, where distance is distanceToFace()
+bool isOutsideFace(const HullContext* ctx, const int face, const float* point, const float distance) {
+  const int* indices = ctx->faceIndices + face*POINTS_PER_FACE;
+  return isInFrontOfPlane(ctx->vertices + indices[0], ctx->vertices + indices[1], ctx->vertices + indices[2], point, distance, ctx->planeErrors[face]);
+}
+
+// ai, bi, ci must be counter-clockwise when seen from outside the hull, and there must be a free face or
+// spare capacity (see reserveFaces()). Returns the new face
+int addQuickHullFace(HullContext* ctx, const int ai, const int bi, const int ci) {
+  const int face = ctx->numFreeFaces > 0 ? ctx->freeFaces[--ctx->numFreeFaces] : ctx->numFaces++;
+
+  int* indices = ctx->faceIndices + face*POINTS_PER_FACE;
+  float normal[] = {0.f,0.f,0.f};
+
+  indices[0] = ai;
+  indices[1] = bi;
+  indices[2] = ci;
+  setFromCoplanarPoints(normal, ctx->vertices + ai, ctx->vertices + bi, ctx->vertices + ci);
+  setPlane(&ctx->planes, face, normal, ctx->vertices + ai);
+  ctx->planeErrors[face] = calcPlaneError(ctx->vertices + ai, ctx->vertices + bi, ctx->vertices + ci, ctx->maxCoord);
+  ctx->outsideHeads[face] = NO_INDEX;
+  ctx->farthestPoints[face] = NO_INDEX;
+  ctx->farthestDistances[face] = 0.f;
+  ctx->faceMarks[face] = 0;
+  ctx->numLiveFaces++;
+  ctx->stats.numFacesCreated++;
+  ctx->stats.peakLiveFaces = ctx->numLiveFaces > ctx->stats.peakLiveFaces ? ctx->numLiveFaces : ctx->stats.peakLiveFaces;
+
+  return face;
+}
+
+void deleteQuickHullFace(HullContext* ctx, const int face) {
+  ctx->faceIndices[face*POINTS_PER_FACE] = NO_INDEX;
+  ctx->freeFaces[ctx->numFreeFaces++] = face;
+  ctx->numLiveFaces--;
+  ctx->stats.numFacesDestroyed++;
+}
+
+// copies the planes of the first numNewFaces of newFaces into newPlanes, so they are contiguous for the kernels
+void gatherNewPlanes(HullContext* ctx, const int numNewFaces) {
+  ctx->newPlanesError = 0.f;
+
+  for (int i = 0; i < numNewFaces; i++) {
+    copyPlane(&ctx->newPlanes, i, &ctx->planes, ctx->newFaces[i]);
+    ctx->newPlanesError = fmaxf(ctx->newPlanesError, ctx->planeErrors[ctx->newFaces[i]]);
+  }
+}
+
+// the point must be outside the face (see isOutsideFace()), distance is distanceToFace()
+void addToOutsideSet(HullContext* ctx, const int face, const int point, const float distance) {
+  if (!ctx->isPending[face]) {
+    ctx->isPending[face] = true;
+    ctx->pendingFaces[ctx->numPendingFaces++] = face;
+  }
+
+  ctx->pointNext[point/ctx->stride] = ctx->outsideHeads[face];
+  ctx->outsideHeads[face] = point;
+
+  // a point within the plane error can be outside with a distance of 0 or less
+  if (ctx->farthestPoints[face] == NO_INDEX || distance > ctx->farthestDistances[face]) {
+    ctx->farthestDistances[face] = distance;
+    ctx->farthestPoints[face] = point;
+  }
+}
+
+// adds the point to the outside set of the new face it is farthest outside of (see gatherNewPlanes()). Returns
+// false if the point is not outside any of the new faces, in which case it is inside the hull and can be dropped
+bool assignToOutsideSet(HullContext* ctx, const int numNewFaces, const int point) {
+  const float* p = ctx->vertices + point;
+  float bestDistance = 0.f;
+  const int best = calcFarthestPlane(&bestDistance, &ctx->newPlanes, numNewFaces, p);
+
+  if (bestDistance < -ctx->newPlanesError) {
+    ctx->stats.numDroppedPoints++;
+    return false; // certainly inside every new face
+  }
+
+  if (isOutsideFace(ctx, ctx->newFaces[best], p, bestDistance)) {
+    addToOutsideSet(ctx, ctx->newFaces[best], point, bestDistance);
+    return true;
+  }
+
+  // the point is on (or within rounding of) the best face, but may still be outside another one
+  for (int i = 0; i < numNewFaces; i++) {
+    const int face = ctx->newFaces[i];
+    const float distance = planeDistance(&ctx->newPlanes, i, p);
+
+    if (i != best && distance >= -ctx->planeErrors[face] && isOutsideFace(ctx, face, p, distance)) {
+      addToOutsideSet(ctx, face, point, distance);
+      return true;
+    }
+  }
+
+  ctx->stats.numDroppedPoints++;
+  return false;
+}
+
+void setTwins(HullContext* ctx, const int edgeA, const int edgeB) {
+  ctx->faceTwins[edgeA] = edgeB;
+  ctx->faceTwins[edgeB] = edgeA;
+}
+
+// depth first walk over the faces visible from point, starting at face (which must be visible). Fills
+// visibleFaces and the horizon, where the end of each horizon edge is the start of the next one.
+// Returns the number of horizon edges
+int calcHorizon(HullContext* ctx, int* outNumVisible, const int face, const float* point) {
+  int* stack = ctx->horizonStack;
+  int numStack = 0;
+  int numVisible = 0;
+  int numHorizon = 0;
+
+  ctx->visibleMark++;
+  ctx->faceMarks[face] = ctx->visibleMark;
+  ctx->visibleFaces[numVisible++] = face;
+  stack[numStack++] = face;
+  stack[numStack++] = 0;
+  stack[numStack++] = EDGES_PER_FACE;
+
+  while (numStack > 0) {
+    int* top = stack + numStack - 3;
+
+    if (top[2] == 0) {
+      numStack -= 3;
+      continue;
+    }
+
+    const int edge = top[0]*EDGES_PER_FACE + top[1];
+    top[1] = (top[1] + 1) % EDGES_PER_FACE;
+    top[2]--;
+
+    const int twin = ctx->faceTwins[edge];
+    const int neighbour = twin/EDGES_PER_FACE;
+
+    if (ctx->faceMarks[neighbour] == ctx->visibleMark) {
+      continue;
+    }
+
+    if (isOutsideFace(ctx, neighbour, point, distanceToFace(ctx, neighbour, point))) {
+      // continue around the neighbour from the edge after the one we entered by
+      ctx->faceMarks[neighbour] = ctx->visibleMark;
+      ctx->visibleFaces[numVisible++] = neighbour;
+      stack[numStack++] = neighbour;
+      stack[numStack++] = (twin + 1) % EDGES_PER_FACE;
+      stack[numStack++] = EDGES_PER_FACE - 1;
+    } else {
+      ctx->horizon[numHorizon++] = edge;
+    }
+  }
+
+  *outNumVisible = numVisible;
+  return numHorizon;
+}
+
+// adds the farthest point of the face's outside set to the hull. Returns false if out of memory
+bool expandQuickHull(HullContext* ctx, const int face) {
+  const bool isTimed = isCollectingStats(ctx);
+  const double visibilityStart = isTimed ? hullNow() : 0.;
+  const int eye = ctx->farthestPoints[face];
+  int numVisible = 0;
+  const int numEdges = calcHorizon(ctx, &numVisible, face, ctx->vertices + eye);
+  int numOrphans = 0;
+
+  const double horizonStart = isTimed ? hullNow() : 0.;
+  ctx->stats.visibilitySeconds += horizonStart - visibilityStart;
+  ctx->stats.numExpansions++;
+  ctx->stats.numVisibleFaces += numVisible;
+  ctx->stats.numHorizonEdges += numEdges;
+  ctx->stats.maxHorizonEdges = numEdges > ctx->stats.maxHorizonEdges ? numEdges : ctx->stats.maxHorizonEdges;
+
+  // the visible faces will be freed before the new faces are added
+  if (!reserveFaces(ctx, ctx->numFaces + numEdges - ctx->numFreeFaces - numVisible)) {
+    return false;
+  }
+
+  // the visible faces are about to be deleted, so copy the horizon vertices and replace each horizon edge
+  // with its twin on the hidden side
+  for (int i = 0; i < numEdges; i++) {
+    const int edge = ctx->horizon[i];
+    const int j = edge - edge % EDGES_PER_FACE;
+    ctx->outEdges[i*POINTS_PER_EDGE] = ctx->faceIndices[edge];
+    ctx->outEdges[i*POINTS_PER_EDGE + 1] = ctx->faceIndices[j + (edge + 1) % EDGES_PER_FACE];
+    ctx->horizon[i] = ctx->faceTwins[edge];
+  }
+
+  // gather the outside sets of the visible faces, they will be reassigned to the new faces
+  for (int i = 0; i < numVisible; i++) {
+    const int visibleFace = ctx->visibleFaces[i];
+
+    for (int point = ctx->outsideHeads[visibleFace]; point != NO_INDEX; point = ctx->pointNext[point/ctx->stride]) {
+      if (point != eye) {
+        ctx->orphans[numOrphans++] = point;
+      }
+    }
+
+    deleteQuickHullFace(ctx, visibleFace);
+  }
+
+  const double rebuildStart = isTimed ? hullNow() : 0.;
+  ctx->stats.horizonSeconds += rebuildStart - horizonStart;
+
+  for (int i = 0; i < numEdges; i++) {
+    const int j = i*POINTS_PER_EDGE;
+    const int newFace = addQuickHullFace(ctx, ctx->outEdges[j], ctx->outEdges[j+1], eye);
+    ctx->newFaces[i] = newFace;
+    setTwins(ctx, newFace*EDGES_PER_FACE, ctx->horizon[i]);
+  }
+
+  // stitch the new faces together around the eye
+  for (int i = 0; i < numEdges; i++) {
+    const int nextFace = ctx->newFaces[(i + 1) % numEdges];
+    setTwins(ctx, ctx->newFaces[i]*EDGES_PER_FACE + 1, nextFace*EDGES_PER_FACE + 2);
+  }
+
+  gatherNewPlanes(ctx, numEdges);
+  for (int i = 0; i < numOrphans; i++) {
+    assignToOutsideSet(ctx, numEdges, ctx->orphans[i]);
+  }
+
+  ctx->stats.rebuildSeconds += isTimed ? hullNow() - rebuildStart : 0.;
+  return true;
+}
+
+// builds the tetrahedron into faces 0 to 3, with (a,b,c) facing away from d
+void buildSimplex(HullContext* ctx, const int* simplex) {
+  const int ai = simplex[0];
+  const int di = simplex[3];
+  int bi = simplex[1];
+  int ci = simplex[2];
+
+  if (orient3d(ctx->vertices + ai, ctx->vertices + bi, ctx->vertices + ci, ctx->vertices + di) > 0.) {
+    bi = simplex[2];
+    ci = simplex[1];
+  }
+
+  ctx->newFaces[0] = addQuickHullFace(ctx, ai, bi, ci);
+  ctx->newFaces[1] = addQuickHullFace(ctx, bi, ai, di);
+  ctx->newFaces[2] = addQuickHullFace(ctx, ci, bi, di);
+  ctx->newFaces[3] = addQuickHullFace(ctx, ai, ci, di);
+
+  setTwins(ctx, 0*EDGES_PER_FACE + 0, 1*EDGES_PER_FACE + 0); // a-b
+  setTwins(ctx, 0*EDGES_PER_FACE + 1, 2*EDGES_PER_FACE + 0); // b-c
+  setTwins(ctx, 0*EDGES_PER_FACE + 2, 3*EDGES_PER_FACE + 0); // c-a
+  setTwins(ctx, 1*EDGES_PER_FACE + 1, 3*EDGES_PER_FACE + 2); // a-d
+  setTwins(ctx, 1*EDGES_PER_FACE + 2, 2*EDGES_PER_FACE + 1); // d-b
+  setTwins(ctx, 2*EDGES_PER_FACE + 2, 3*EDGES_PER_FACE + 1); // d-c
+}
+
+// finds the points with the minimum and maximum projection along each of the 13 k-DOP axes (the coordinate
+// axes, the 4 cube diagonals and the 6 face diagonals). Returns the number of unique indices written (up to 26)
+int calcKDopExtremes(int* outIndices, const float* vertices, const int numVertices, const int stride) {
+  static const float AXES[NUM_KDOP_AXES][FLOATS_PER_VERTEX] = {
+    {1.f,0.f,0.f}, {0.f,1.f,0.f}, {0.f,0.f,1.f},
+    {1.f,1.f,1.f}, {1.f,1.f,-1.f}, {1.f,-1.f,1.f}, {-1.f,1.f,1.f},
+    {1.f,1.f,0.f}, {1.f,-1.f,0.f}, {1.f,0.f,1.f}, {1.f,0.f,-1.f}, {0.f,1.f,1.f}, {0.f,1.f,-1.f},
+  };
+
+  if (numVertices <= 0) {
+    return 0;
+  }
+
+  float minProjections[NUM_KDOP_AXES];
+  float maxProjections[NUM_KDOP_AXES];
+  int extremes[2*NUM_KDOP_AXES] = {0};
+  int numOutIndices = 0;
+
+  for (int axis = 0; axis < NUM_KDOP_AXES; axis++) {
+    minProjections[axis] = maxProjections[axis] = dot(AXES[axis], vertices);
+  }
+
+  for (int i = stride; i < numVertices; i += stride) {
+    for (int axis = 0; axis < NUM_KDOP_AXES; axis++) {
+      const float projection = dot(AXES[axis], vertices + i);
+
+      if (projection < minProjections[axis]) {
+        minProjections[axis] = projection;
+        extremes[axis] = i;
+      }
+
+      if (projection > maxProjections[axis]) {
+        maxProjections[axis] = projection;
+        extremes[axis + NUM_KDOP_AXES] = i;
+      }
+    }
+  }
+
+  for (int i = 0; i < 2*NUM_KDOP_AXES; i++) {
+    if (indexOfInt(outIndices, numOutIndices, extremes[i]) == -1) {
+      outIndices[numOutIndices++] = extremes[i];
+    }
+  }
+
+  return numOutIndices;
+}
+
+int buildQuickHull(HullContext* ctx, const float* vertices, const int numVertices, const int stride);
+
+// Akl-Toussaint heuristic, builds the planes of the hull of the k-DOP extremes into cullPlanes. Every point
+// strictly inside these planes is inside the final hull, so it can be skipped. Returns the number of planes,
+// 0 if the extremes do not form a polytope (or out of memory), in which case nothing can be culled
+int buildCullPlanes(HullContext* ctx) {
+  int extremes[2*NUM_KDOP_AXES] = {0};
+  float points[2*NUM_KDOP_AXES*FLOATS_PER_VERTEX];
+  const int numExtremes = calcKDopExtremes(extremes, ctx->vertices, ctx->numVertices, ctx->stride);
+
+  for (int i = 0; i < numExtremes; i++) {
+    memcpy(points + i*FLOATS_PER_VERTEX, ctx->vertices + extremes[i], FLOATS_PER_VERTEX*sizeof(float));
+  }
+
+  if (ctx->cullContext == NULL) {
+    ctx->cullContext = hullContextCreate(MAX_CULL_PLANES, 2*NUM_KDOP_AXES);
+  }
+
+  HullContext* cull = ctx->cullContext;
+  if (cull == NULL || buildQuickHull(cull, points, numExtremes*FLOATS_PER_VERTEX, FLOATS_PER_VERTEX) <= 0) {
+    return 0;
+  }
+
+  int numPlanes = 0;
+  ctx->cullPlanes = (HullPlanes){ ctx->cullPlaneBuffer, ctx->cullPlaneBuffer + MAX_CULL_PLANES, ctx->cullPlaneBuffer + 2*MAX_CULL_PLANES, ctx->cullPlaneBuffer + 3*MAX_CULL_PLANES };
+  ctx->cullPlanesError = 0.f;
+
+  for (int face = 0; face < cull->numFaces; face++) {
+    const int* indices = cull->faceIndices + face*POINTS_PER_FACE;
+    if (indices[0] != NO_INDEX) {
+      copyPlane(&ctx->cullPlanes, numPlanes++, &cull->planes, face);
+      // the error must cover all of the points, not just the extremes
+      const float error = calcPlaneError(points + indices[0], points + indices[1], points + indices[2], ctx->maxCoord);
+      ctx->cullPlanesError = fmaxf(ctx->cullPlanesError, error);
+    }
+  }
+
+  return numPlanes;
+}
+
+void updateHighWater(HullContext* ctx) {
+  const int numPoints = (ctx->numVertices + ctx->stride - 1)/ctx->stride;
+  ctx->highWaterFaces = ctx->numFaces > ctx->highWaterFaces ? ctx->numFaces : ctx->highWaterFaces;
+  ctx->highWaterPoints = numPoints > ctx->highWaterPoints ? numPoints : ctx->highWaterPoints;
+}
+
+void simplifyHull(HullContext* ctx);
+
+// expands faces until every outside set is empty, then drops the vertices which are not corners of the hull
+// (see simplifyHull()). Returns false if out of memory
+bool expandPendingFaces(HullContext* ctx) {
+  bool ok = true;
+
+  while (ctx->numPendingFaces > 0) {
+    const int face = ctx->pendingFaces[--ctx->numPendingFaces];
+    ctx->isPending[face] = false;
+
+    // the face may have been deleted (or reused) since it was added to the pending list
+    if (ctx->faceIndices[face*POINTS_PER_FACE] == NO_INDEX || ctx->outsideHeads[face] == NO_INDEX) {
+      continue;
+    }
+
+    if (!expandQuickHull(ctx, face)) {
+      ok = false;
+      break;
+    }
+  }
+
+  if (ok) {
+    simplifyHull(ctx);
+  }
+
+  updateHighWater(ctx);
+  return ok;
+}
+
+// builds the polygon with the corners of loop into the context, as in writePlanarTriangles(), the front fan then
+// the back fan. Returns false if out of memory
+bool buildPlanarFans(HullContext* ctx, const int* loop, const int numLoop) {
+  const int numFan = numLoop - 2;
+  if (!reserveFaces(ctx, 2*numFan)) {
+    return false;
+  }
+
+  for (int i = 1; i <= numFan; i++) {
+    addQuickHullFace(ctx, loop[0], loop[i], loop[i + 1]);
+  }
+
+  for (int i = 1; i <= numFan; i++) {
+    addQuickHullFace(ctx, loop[0], loop[i + 1], loop[i]);
+  }
+
+  // front face i - 1 is (0, i, i+1) and back face numFan + i - 1 is (0, i+1, i)
+  for (int i = 0; i < numFan; i++) {
+    const int front = i*EDGES_PER_FACE;
+    const int back = (numFan + i)*EDGES_PER_FACE;
+
+    setTwins(ctx, front + 1, back + 1); // the polygon's edge from i to i+1
+    if (i + 1 < numFan) {
+      setTwins(ctx, front + 2, front + EDGES_PER_FACE); // diagonal from 0 to i+1
+      setTwins(ctx, back, back + EDGES_PER_FACE + 2);
+    }
+  }
+
+  setTwins(ctx, 0, numFan*EDGES_PER_FACE + 2); // the polygon's edge from 0 to 1
+  setTwins(ctx, (numFan - 1)*EDGES_PER_FACE + 2, (2*numFan - 1)*EDGES_PER_FACE); // and from the last corner to 0
+
+  ctx->isPlanar = true;
+  return true;
+}
+
+// builds the planar hull of the coplanar points into the context, see calcPlanarHull(). The corners are kept in
+// orphans. Returns false if out of memory
+bool buildPlanarQuickHull(HullContext* ctx, const int* triangle) {
+  const int numLoop = calcPlanarHull(ctx->orphans, ctx->vertices, ctx->numVertices, ctx->stride, triangle);
+  return numLoop > 0 && buildPlanarFans(ctx, ctx->orphans, numLoop);
+}
+
+// builds the initial simplex and assigns every point to the outside set of a simplex face, flags are
+// HULL_CULL_INTERIOR or 0. If the points are coplanar the planar hull is built instead, and there is nothing
+// left to expand. Returns 0, or the same negative results as buildQuickHull()
+int startQuickHull(HullContext* ctx, const float* vertices, const int numVertices, const int stride, const int flags) {
+  if (numVertices < 12) {
+    return -1; // not enough vertices
+  }
+
+  const int numPoints = (numVertices + stride - 1)/stride;
+  const bool isTimed = isCollectingStats(ctx);
+  const double extremesStart = isTimed ? hullNow() : 0.;
+  int simplex[4] = {0};
+
+  clearHull(ctx);
+  ctx->vertices = vertices;
+  ctx->numVertices = numVertices;
+  ctx->stride = stride;
+  ctx->maxCoord = growMaxCoord(0.f, vertices, numVertices, stride);
+  ctx->stats.numPoints = numPoints;
+
+  const int numSimplex = calcInitialSimplex(simplex, vertices, numVertices, stride);
+  if (numSimplex < 3) {
+    return -2; // all points are collinear, unable to build a hull
+  }
+
+  if (!reserveFaces(ctx, MIN_CONTEXT_FACES) || !reservePoints(ctx, numPoints)) {
+    return -3; // out of memory
+  }
+
+  const int numCullPlanes = numSimplex == 4 && flags & HULL_CULL_INTERIOR ? buildCullPlanes(ctx) : 0;
+  float cullDistance = 0.f;
+
+  const double seedStart = isTimed ? hullNow() : 0.;
+  ctx->stats.extremesSeconds = seedStart - extremesStart;
+
+  if (numSimplex == 3) {
+    const bool ok = buildPlanarQuickHull(ctx, simplex);
+    ctx->stats.seedSeconds = isTimed ? hullNow() - seedStart : 0.;
+    return ok ? 0 : -3;
+  }
+
+  buildSimplex(ctx, simplex);
+  gatherNewPlanes(ctx, 4);
+
+  for (int i = 0; i < numVertices; i += stride) {
+    if (i == simplex[0] || i == simplex[1] || i == simplex[2] || i == simplex[3]) {
+      continue;
+    }
+
+    if (numCullPlanes > 0) {
+      calcFarthestPlane(&cullDistance, &ctx->cullPlanes, numCullPlanes, vertices + i);
+      if (cullDistance < -ctx->cullPlanesError) {
+        ctx->stats.numCulledPoints++;
+        continue; // strictly inside the culling polytope
+      }
+    }
+
+    assignToOutsideSet(ctx, 4, i);
+  }
+
+  ctx->stats.seedSeconds = isTimed ? hullNow() - seedStart : 0.;
+  return 0;
+}
+
+// builds the hull of the vertices into the context. Returns the number of live faces, or -1 if there are not
+// enough vertices, -2 if all the vertices are collinear and -3 if out of memory. Coplanar vertices give a
+// planar hull, see calcPlanarHull()
+int buildQuickHull(HullContext* ctx, const float* vertices, const int numVertices, const int stride) {
+  const int result = startQuickHull(ctx, vertices, numVertices, stride, ctx->flags);
+  if (result < 0) {
+    return result;
+  }
+
+  return expandPendingFaces(ctx) ? ctx->numLiveFaces : -3;
+}
+
+// puts every live face into newFaces and newPlanes, so points can be assigned to any face of the current hull.
+// Returns the number of live faces
+int gatherLiveFaces(HullContext* ctx) {
+  int numFaces = 0;
+  for (int face = 0; face < ctx->numFaces; face++) {
+    if (ctx->faceIndices[face*POINTS_PER_FACE] != NO_INDEX) {
+      ctx->newFaces[numFaces++] = face;
+    }
+  }
+
+  gatherNewPlanes(ctx, numFaces);
+  return numFaces;
+}
+
+// Budgeted hull
+// Colliders only want a few dozen vertices, so the budgeted build always expands the face with the farthest
+// outside point of the whole hull (rather than the most recent face), and stops once the next expansion could
+// go over the budget. Every expansion adds one vertex and removes the vertices whose faces were all visible,
+// and a closed triangle mesh has 2*numVertices - 4 faces, so a face budget is also a vertex budget.
+// The points left in the outside sets are the ones the approximation misses. Coplanar points are built as a
+// whole polygon at once, which then keeps the corners farthest outside each other, see reducePlanarHull().
+
+// expands the face with the farthest outside point until every outside set is empty or the hull has
+// maxHullVertices vertices. The pending faces are searched each time, which is cheap for the small budgets
+// this is meant for. Returns false if out of memory
+bool expandFarthestFaces(HullContext* ctx, const int maxHullVertices) {
+  bool ok = true;
+
+  while (ok && (ctx->numLiveFaces + 4)/2 < maxHullVertices) {
+    int best = NO_INDEX;
+    int numPending = 0;
+
+    // drop the faces which have been deleted or have nothing left outside them
+    for (int i = 0; i < ctx->numPendingFaces; i++) {
+      const int face = ctx->pendingFaces[i];
+      if (ctx->faceIndices[face*POINTS_PER_FACE] == NO_INDEX || ctx->outsideHeads[face] == NO_INDEX) {
+        ctx->isPending[face] = false;
+        continue;
+      }
+
+      ctx->pendingFaces[numPending++] = face;
+      if (best == NO_INDEX || ctx->farthestDistances[face] > ctx->farthestDistances[best]) {
+        best = face;
+      }
+    }
+
+    ctx->numPendingFaces = numPending;
+    if (best == NO_INDEX) {
+      break;
+    }
+
+    ok = expandQuickHull(ctx, best);
+  }
+
+  updateHighWater(ctx);
+  return ok;
+}
+
+// the largest distance of a point in front of any plane of the current hull, the points inside the hull were
+// dropped as it grew so only the outside sets need checking. Returns 0 if every point is inside
+float calcMaxOutsideDistance(HullContext* ctx) {
+  const int numFaces = gatherLiveFaces(ctx);
+  float maxDistance = 0.f;
+  float distance = 0.f;
+
+  for (int i = 0; i < ctx->numPendingFaces; i++) {
+    const int face = ctx->pendingFaces[i];
+    if (ctx->faceIndices[face*POINTS_PER_FACE] == NO_INDEX) {
+      continue;
+    }
+
+    for (int point = ctx->outsideHeads[face]; point != NO_INDEX; point = ctx->pointNext[point/ctx->stride]) {
+      calcFarthestPlane(&distance, &ctx->newPlanes, numFaces, ctx->vertices + point);
+      maxDistance = fmaxf(maxDistance, distance);
+    }
+  }
+
+  return maxDistance;
+}
+
+// the distance of p from the line through a and b
+float calcLineDistance(const float* p, const float* a, const float* b) {
+  float ab[] = {0.f,0.f,0.f};
+  float ap[] = {0.f,0.f,0.f};
+  float normal[] = {0.f,0.f,0.f};
+
+  sub(ab, b, a);
+  sub(ap, p, a);
+  cross(normal, ab, ap);
+  return sqrtf(dot(normal, normal)/dot(ab, ab));
+}
+
+// keeps at most maxVertices (at least 3) corners of the planar hull, whose corners are in orphans (see
+// buildPlanarQuickHull()), and rebuilds it from them. The corners are added farthest first, as the faces are
+// expanded for a solid hull: from the first corner and the one farthest from it, the corner farthest outside
+// the polygon kept so far is added next. outMaxDistance gets how far the dropped corners are outside the
+// polygon, 0 if none are dropped. Returns false if out of memory
+bool reducePlanarHull(HullContext* ctx, float* outMaxDistance, const int maxVertices) {
+  int* loop = ctx->orphans;
+  const int numLoop = ctx->numLiveFaces/2 + 2;
+  const int maxCorners = maxVertices > 3 ? maxVertices : 3;
+  const float* v = ctx->vertices;
+
+  *outMaxDistance = 0.f;
+  if (numLoop <= maxCorners) {
+    return true;
+  }
+
+  // the positions in loop of the corners kept, in order, in newFaces (room for a corner per face)
+  int* kept = ctx->newFaces;
+  int numKept = 2;
+  float farthest = 0.f;
+  kept[0] = 0;
+  kept[1] = 1;
+  for (int i = 2; i < numLoop; i++) {
+    float ap[] = {0.f,0.f,0.f};
+    const float distance = dot(sub(ap, v + loop[i], v + loop[0]), ap);
+    if (distance > farthest) {
+      farthest = distance;
+      kept[1] = i;
+    }
+  }
+
+  // each dropped corner is outside the side between the kept corners either side of it, the first corner is
+  // always kept so the last side ends at it
+  while (true) {
+    int best = NO_INDEX, bestGap = 0;
+    float bestDistance = 0.f;
+    for (int j = 0; j < numKept; j++) {
+      const int start = kept[j];
+      const int end = j + 1 < numKept ? kept[j + 1] : numLoop;
+      for (int i = start + 1; i < end; i++) {
+        const float distance = calcLineDistance(v + loop[i], v + loop[start], v + loop[end % numLoop]);
+        if (best == NO_INDEX || distance > bestDistance) {
+          best = i;
+          bestGap = j;
+          bestDistance = distance;
+        }
+      }
+    }
+
+    if (numKept == maxCorners || best == NO_INDEX) {
+      *outMaxDistance = bestDistance;
+      break;
+    }
+
+    memmove(kept + bestGap + 2, kept + bestGap + 1, (numKept - bestGap - 1)*sizeof(int));
+    kept[bestGap + 1] = best;
+    numKept++;
+  }
+
+  for (int i = 0; i < numKept; i++) {
+    loop[i] = loop[kept[i]];
+  }
+
+  ctx->numFaces = 0;
+  ctx->numLiveFaces = 0;
+  ctx->numFreeFaces = 0;
+  return buildPlanarFans(ctx, loop, numKept);
+}
+
+// same as buildQuickHull(), but the hull has at most maxVertices vertices (at least 4, 0 for no limit), see
+// above. A planar hull keeps at most maxVertices corners, see reducePlanarHull(). HULL_CULL_INTERIOR is ignored, as the points inside the k-DOP hull may be outside the smaller hull.
+// outMaxDistance is set to the largest distance of any point in front of a plane of the hull
+int buildQuickHullBudget(HullContext* ctx, float* outMaxDistance, const float* vertices, const int numVertices, const int stride, const int maxVertices) {
+  *outMaxDistance = 0.f;
+
+  const int result = startQuickHull(ctx, vertices, numVertices, stride, 0);
+  if (result < 0) {
+    return result;
+  }
+
+  if (!expandFarthestFaces(ctx, maxVertices > 0 ? maxVertices : INT_MAX)) {
+    return -3;
+  }
+
+  if (ctx->isPlanar) {
+    return reducePlanarHull(ctx, outMaxDistance, maxVertices > 0 ? maxVertices : INT_MAX) ? ctx->numLiveFaces : -3;
+  }
+
+  // the outside sets are lost when the faces are rebuilt, so only a finished hull is simplified
+  if (ctx->numPendingFaces == 0) {
+    simplifyHull(ctx);
+  }
+
+  *outMaxDistance = calcMaxOutsideDistance(ctx);
+  return ctx->numLiveFaces;
+}
+
+// walks from face across the hull to the face hit by the ray from center (inside the hull) through the
+// point. Returns NO_INDEX if the face is not found within maxSteps, which can happen with rounding errors.
+// The number of faces visited is added to ioNumSteps
+int locateFace(const HullContext* ctx, int face, const float* center, const float* point, const int maxSteps, int* ioNumSteps) {
+  float direction[] = {0.f,0.f,0.f};
+  float a[] = {0.f,0.f,0.f};
+  float b[] = {0.f,0.f,0.f};
+  float edgeNormal[] = {0.f,0.f,0.f};
+
+  sub(direction, point, center);
+
+  for (int step = 0; step < maxSteps; step++) {
+    const int* indices = ctx->faceIndices + face*POINTS_PER_FACE;
+    (*ioNumSteps)++;
+    float mostOutside = 0.f;
+    int exitEdge = NO_INDEX;
+
+    // the ray is inside the face's cone when it is on the inside of the planes through center and each edge
+    for (int k = 0; k < EDGES_PER_FACE; k++) {
+      sub(a, ctx->vertices + indices[k], center);
+      sub(b, ctx->vertices + indices[(k + 1) % EDGES_PER_FACE], center);
+      cross(edgeNormal, a, b);
+
+      const float side = dot(edgeNormal, direction);
+      if (side < mostOutside) {
+        mostOutside = side;
+        exitEdge = k;
+      }
+    }
+
+    if (exitEdge == NO_INDEX) {
+      return face;
+    }
+
+    face = ctx->faceTwins[face*EDGES_PER_FACE + exitEdge]/EDGES_PER_FACE;
+  }
+
+  return NO_INDEX;
+}
+
+#define MAX_WARM_STEPS_PER_POINT (8)
+#define MIN_WARM_POINTS (64)
+
+int compareInts(const void* a, const void* b) {
+  return *(const int*)a - *(const int*)b;
+}
+
+// same as buildQuickHull(), but the hull of the seed vertices (offsets, e.g. the triangles of the previous
+// frame's hull) is built first. When the seeds are close to the final hull, most points are inside it and are
+// rejected by a single face test, instead of being moved between outside sets as the hull grows.
+// Seeds which are out of range are ignored, and if there are not enough seeds this is a normal build
+int buildQuickHullWarm(HullContext* ctx, const float* vertices, const int numVertices, const int stride, const int* seeds, const int numSeeds) {
+  const int numPoints = (numVertices + stride - 1)/stride;
+
+  if (numVertices < 12 || !reserveScratch(ctx, numSeeds)) {
+    return buildQuickHull(ctx, vertices, numVertices, stride);
+  }
+
+  // the seeds are usually triangle indices, so remove the duplicates
+  int numUnique = 0;
+  for (int i = 0; i < numSeeds; i++) {
+    if (seeds[i] >= 0 && seeds[i] < numVertices && seeds[i] % stride == 0) {
+      ctx->scratchIndices[numUnique++] = seeds[i];
+    }
+  }
+
+  qsort(ctx->scratchIndices, numUnique, sizeof(int), compareInts);
+
+  int numUniqueSeeds = 0;
+  for (int i = 0; i < numUnique; i++) {
+    if (numUniqueSeeds == 0 || ctx->scratchIndices[i] != ctx->scratchIndices[numUniqueSeeds - 1]) {
+      ctx->scratchIndices[numUniqueSeeds] = ctx->scratchIndices[i];
+      memcpy(ctx->scratchVertices + numUniqueSeeds*FLOATS_PER_VERTEX, vertices + ctx->scratchIndices[i], FLOATS_PER_VERTEX*sizeof(float));
+      numUniqueSeeds++;
+    }
+  }
+
+  int simplex[4] = {0};
+
+  if (numUniqueSeeds < 4 || calcInitialSimplex(simplex, ctx->scratchVertices, numUniqueSeeds*FLOATS_PER_VERTEX, FLOATS_PER_VERTEX) < 4) {
+    return buildQuickHull(ctx, vertices, numVertices, stride);
+  }
+
+  for (int i = 0; i < 4; i++) {
+    simplex[i] = ctx->scratchIndices[simplex[i]/FLOATS_PER_VERTEX];
+  }
+
+  clearHull(ctx);
+  ctx->vertices = vertices;
+  ctx->numVertices = numVertices;
+  ctx->stride = stride;
+  ctx->maxCoord = growMaxCoord(0.f, vertices, numVertices, stride); // the plane errors must cover all of the points
+
+  if (!reserveFaces(ctx, MIN_CONTEXT_FACES) || !reservePoints(ctx, numPoints)) {
+    return -3; // out of memory
+  }
+
+  buildSimplex(ctx, simplex);
+  gatherNewPlanes(ctx, 4);
+
+  for (int i = 0; i < numUniqueSeeds; i++) {
+    const int seed = ctx->scratchIndices[i];
+    if (seed != simplex[0] && seed != simplex[1] && seed != simplex[2] && seed != simplex[3]) {
+      assignToOutsideSet(ctx, 4, seed);
+    }
+  }
+
+  if (!expandPendingFaces(ctx)) {
+    return -3; // out of memory
+  }
+
+  // mark the vertices of the seed hull in pointNext (the outside sets are empty), so they are not assigned again
+  for (int i = 0; i < numPoints; i++) {
+    ctx->pointNext[i] = NO_INDEX;
+  }
+
+  for (int i = 0; i < ctx->numFaces*POINTS_PER_FACE; i++) {
+    if (ctx->faceIndices[i - i % POINTS_PER_FACE] != NO_INDEX) {
+      ctx->pointNext[ctx->faceIndices[i]/stride] = 0;
+    }
+  }
+
+  // the center of the simplex is inside the seed hull. Vertex buffers are usually spatially coherent, so each
+  // walk starts from the face of the previous point, and only falls back to testing every face on failure
+  float center[] = {0.f,0.f,0.f};
+  for (int i = 0; i < 4; i++) {
+    for (int axis = 0; axis < FLOATS_PER_VERTEX; axis++) {
+      center[axis] += 0.25f*vertices[simplex[i] + axis];
+    }
+  }
+
+  const int numFaces = gatherLiveFaces(ctx);
+  int face = ctx->newFaces[0];
+  int numSteps = 0;
+
+  for (int i = 0; i < numVertices; i += stride) {
+    if (ctx->pointNext[i/stride] != NO_INDEX) {
+      continue; // vertex of the seed hull
+    }
+
+    // long walks mean the points are not coherent, and a normal build will be quicker
+    if (numSteps > MAX_WARM_STEPS_PER_POINT*(i/stride + MIN_WARM_POINTS)) {
+      return buildQuickHull(ctx, vertices, numVertices, stride);
+    }
+
+    const int hitFace = locateFace(ctx, face, center, vertices + i, numFaces, &numSteps);
+    if (hitFace == NO_INDEX) {
+      assignToOutsideSet(ctx, numFaces, i);
+      continue;
+    }
+
+    // a point close to the hit face may be outside a neighbour instead, as the walk is not exact
+    const float distance = distanceToFace(ctx, hitFace, vertices + i);
+    if (isOutsideFace(ctx, hitFace, vertices + i, distance)) {
+      addToOutsideSet(ctx, hitFace, i, distance);
+    } else if (distance >= -2.f*ctx->planeErrors[hitFace]) {
+      assignToOutsideSet(ctx, numFaces, i);
+    }
+
+    face = hitFace;
+  }
+
+  return expandPendingFaces(ctx) ? ctx->numLiveFaces : -3;
+}
+
+// returns the number of indices written, POINTS_PER_FACE per live face
+int writeHullTriangles(const HullContext* ctx, int* outIndices) {
+  int numIndices = 0;
+
+  for (int face = 0; face < ctx->numFaces; face++) {
+    const int j = face*POINTS_PER_FACE;
+    if (ctx->faceIndices[j] != NO_INDEX) {
+      outIndices[numIndices++] = ctx->faceIndices[j];
+      outIndices[numIndices++] = ctx->faceIndices[j+1];
+      outIndices[numIndices++] = ctx->faceIndices[j+2];
+    }
+  }
+
+  return numIndices;
+}
+
+// writes each vertex of the current hull once, as offsets into the vertices. Returns the number written
+int writeHullVertices(HullContext* ctx, int* outIndices) {
+  int numIndices = 0;
+
+  // the outside sets are all empty once the hull is built, so pointNext is free to mark the vertices
+  for (int i = 0; i < ctx->numFaces*POINTS_PER_FACE; i++) {
+    if (ctx->faceIndices[i - i % POINTS_PER_FACE] != NO_INDEX) {
+      ctx->pointNext[ctx->faceIndices[i]/ctx->stride] = NO_INDEX;
+    }
+  }
+
+  for (int i = 0; i < ctx->numFaces*POINTS_PER_FACE; i++) {
+    const int vertex = ctx->faceIndices[i];
+    if (ctx->faceIndices[i - i % POINTS_PER_FACE] != NO_INDEX && ctx->pointNext[vertex/ctx->stride] == NO_INDEX) {
+      ctx->pointNext[vertex/ctx->stride] = 0;
+      outIndices[numIndices++] = vertex;
+    }
+  }
+
+  return numIndices;
+}
+
+// writes the current hull as a compact mesh. outPositions gets FLOATS_PER_VERTEX floats for each hull vertex, in
+// the order the triangles first use them, and outIndices gets the triangles as vertex numbers into outPositions.
+// The indices are uint16_t if there are fewer than MAX_UINT16_VERTICES hull vertices, otherwise int.
+// Returns the number of indices and sets outNumVertices to the number of hull vertices
+int writeCompactHull(HullContext* ctx, float* outPositions, void* outIndices, int* outNumVertices) {
+  const int stride = ctx->stride;
+  int numVertices = 0;
+  int numIndices = 0;
+
+  // the outside sets are all empty once the hull is built, so pointNext maps each point to its compact vertex
+  for (int i = 0; i < ctx->numFaces*POINTS_PER_FACE; i++) {
+    if (ctx->faceIndices[i - i % POINTS_PER_FACE] != NO_INDEX) {
+      ctx->pointNext[ctx->faceIndices[i]/stride] = NO_INDEX;
+    }
+  }
+
+  for (int i = 0; i < ctx->numFaces*POINTS_PER_FACE; i++) {
+    const int vertex = ctx->faceIndices[i];
+    if (ctx->faceIndices[i - i % POINTS_PER_FACE] != NO_INDEX && ctx->pointNext[vertex/stride] == NO_INDEX) {
+      memcpy(outPositions + numVertices*FLOATS_PER_VERTEX, ctx->vertices + vertex, FLOATS_PER_VERTEX*sizeof(float));
+      ctx->pointNext[vertex/stride] = numVertices++;
+    }
+  }
+
+  const bool isUint16 = numVertices < MAX_UINT16_VERTICES;
+
+  for (int i = 0; i < ctx->numFaces*POINTS_PER_FACE; i++) {
+    if (ctx->faceIndices[i - i % POINTS_PER_FACE] != NO_INDEX) {
+      const int index = ctx->pointNext[ctx->faceIndices[i]/stride];
+      if (isUint16) {
+        ((uint16_t*)outIndices)[numIndices++] = (uint16_t)index;
+      } else {
+        ((int*)outIndices)[numIndices++] = index;
+      }
+    }
+  }
+
+  *outNumVertices = numVertices;
+  return numIndices;
+}
+
+// same as generateHullTrianglesWithContext(), but writes a compact mesh with only the hull vertices, see
+// writeCompactHull(). outPositions must have room for numVertices floats, and outIndices for
+// POINTS_PER_FACE*(2*numVertices/stride - 4) ints
+EMSCRIPTEN_KEEPALIVE
+int generateCompactHull(HullContext* ctx, float* outPositions, void* outIndices, int* outNumVertices, const float* vertices, const int numVertices, const int stride) {
+  *outNumVertices = 0;
+  const int result = buildQuickHull(ctx, vertices, numVertices, stride);
+  return result < 0 ? result : writeCompactHull(ctx, outPositions, outIndices, outNumVertices);
+}
+
+// same as generateHullTriangles(), but the working memory comes from ctx and is kept for the next call.
+// outIndices must have room for POINTS_PER_FACE*(2*numVertices/stride - 4) indices
+EMSCRIPTEN_KEEPALIVE
+int generateHullTrianglesWithContext(HullContext* ctx, int* outIndices, const float* vertices, const int numVertices, const int stride) {
+  const int result = buildQuickHull(ctx, vertices, numVertices, stride);
+  return result < 0 ? result : writeHullTriangles(ctx, outIndices);
+}
+
+// same as generateHullTrianglesWithContext(), but the hull has at most maxVertices vertices and maxFaces faces
+// (either can be 0 for no limit), made from the farthest points first, see buildQuickHullBudget().
+// outMaxDistance gets the largest distance of any vertex in front of the hull, 0 if none are outside it.
+// Coplanar vertices keep to the same limits: the polygon has at most maxVertices corners and its two fans at
+// most maxFaces triangles, and outMaxDistance is how far the dropped corners are outside it
+EMSCRIPTEN_KEEPALIVE
+int generateHullTrianglesBudget(HullContext* ctx, int* outIndices, float* outMaxDistance, const float* vertices, const int numVertices, const int stride, const int maxVertices, const int maxFaces) {
+  const int maxFaceVertices = maxFaces > 0 ? (maxFaces + 4)/2 : INT_MAX;
+  const int maxHullVertices = maxVertices > 0 && maxVertices < maxFaceVertices ? maxVertices : maxFaceVertices;
+  const int result = buildQuickHullBudget(ctx, outMaxDistance, vertices, numVertices, stride, maxHullVertices);
+  return result < 0 ? result : writeHullTriangles(ctx, outIndices);
+}
+
+// same as generateHullTrianglesWithContext(), but warm started from the previous hull of these vertices (e.g.
+// the previous frame of an animation), see buildQuickHullWarm(). prevIndices are the offsets returned by the
+// previous build, and the result has the same vertices as a normal build
+EMSCRIPTEN_KEEPALIVE
+int generateHullTrianglesWarm(HullContext* ctx, int* outIndices, const float* vertices, const int numVertices, const int stride, const int* prevIndices, const int numPrevIndices) {
+  const int result = buildQuickHullWarm(ctx, vertices, numVertices, stride, prevIndices, numPrevIndices);
+  return result < 0 ? result : writeHullTriangles(ctx, outIndices);
+}
+
+// writes the triangles of the hull of the vertices (numVertices floats, stride apart) to outIndices as offsets
+// into vertices, with room for calcMaxHullIndices(). Returns the number of indices, or -1 if there are not
+// enough vertices, -2 if all the vertices are collinear and -3 if out of memory
+EMSCRIPTEN_KEEPALIVE
+int generateHullTriangles(int* outIndices, const float* vertices, const int numVertices, const int stride) {
+  HullContext* ctx = hullContextCreate(0, 0);
+  if (ctx == NULL) {
+    return -3; // out of memory
+  }
+
+  const int result = generateHullTrianglesWithContext(ctx, outIndices, vertices, numVertices, stride);
+  hullContextDestroy(ctx);
+  return result;
+}
+
+// Polygon output
+// The faces of the hull are merged into convex polygons in two passes. First each set of connected, exactly
+// coplanar faces becomes one polygon, which is convex as it is a face of the hull, by walking around the
+// boundary of the set. Then, if maxAngle is more than 0, each polygon absorbs the neighbouring polygons whose
+// normals are within maxAngle of its own, as long as they share a single chain of edges and the result is
+// still convex. A polygon keeps the plane of its first face, so the whole hull is always behind it.
+// Once the hull is built the per face storage for expanding it is spare, and holds the polygons instead.
+// polygonOf (newFaces) is the first face of each face's coplanar set, the boundary loops are half-edges
+// linked through outEdges, and mergedInto (pendingFaces) links each polygon to the one that absorbed it.
+
+int nextHalfEdge(const int edge) {
+  return edge - edge % EDGES_PER_FACE + (edge + 1) % EDGES_PER_FACE;
+}
+
+// true if the boundary turns left (or goes straight) from edge to nextEdge, when seen along normal
+bool isConvexCorner(const HullContext* ctx, const int edge, const int nextEdge, const float* normal) {
+  const float* v = ctx->vertices;
+  float in[] = {0.f,0.f,0.f};
+  float out[] = {0.f,0.f,0.f};
+  float turn[] = {0.f,0.f,0.f};
+
+  sub(in, v + ctx->faceIndices[nextEdge], v + ctx->faceIndices[edge]);
+  sub(out, v + ctx->faceIndices[nextHalfEdge(nextEdge)], v + ctx->faceIndices[nextEdge]);
+  return dot(cross(turn, in, out), normal) >= 0.f;
+}
+
+int findPolygon(int* mergedInto, int polygon) {
+  while (mergedInto[polygon] != polygon) {
+    mergedInto[polygon] = mergedInto[mergedInto[polygon]];
+    polygon = mergedInto[polygon];
+  }
+  return polygon;
+}
+
+// finds each set of connected, exactly coplanar faces and the loop of half-edges around it. Returns the number
+// of sets, whose first faces are written to visibleFaces in increasing order
+int buildCoplanarPolygons(HullContext* ctx) {
+  int* polygonOf = ctx->newFaces;
+  int* queue = ctx->horizonStack;
+  int* loopNext = ctx->outEdges;
+  int* loopPrev = ctx->outEdges + ctx->faceCapacity*EDGES_PER_FACE;
+  int* loopStarts = ctx->horizon;
+  int* loopSizes = ctx->horizon + ctx->faceCapacity;
+  int numPolygons = 0;
+
+  for (int face = 0; face < ctx->numFaces; face++) {
+    polygonOf[face] = NO_INDEX;
+  }
+
+  for (int seed = 0; seed < ctx->numFaces; seed++) {
+    const int* seedIndices = ctx->faceIndices + seed*POINTS_PER_FACE;
+    if (seedIndices[0] == NO_INDEX || polygonOf[seed] != NO_INDEX) {
+      continue;
+    }
+
+    const float* a = ctx->vertices + seedIndices[0];
+    const float* b = ctx->vertices + seedIndices[1];
+    const float* c = ctx->vertices + seedIndices[2];
+    int boundaryEdge = NO_INDEX;
+    int numQueue = 0;
+
+    polygonOf[seed] = seed;
+    queue[numQueue++] = seed;
+
+    for (int i = 0; i < numQueue; i++) {
+      for (int k = 0; k < EDGES_PER_FACE; k++) {
+        const int edge = queue[i]*EDGES_PER_FACE + k;
+        const int twin = ctx->faceTwins[edge];
+        const int neighbour = twin/EDGES_PER_FACE;
+        const int opposite = ctx->faceIndices[nextHalfEdge(nextHalfEdge(twin))];
+
+        if (polygonOf[neighbour] == seed) {
+          continue;
+        }
+
+        // the faces on the other side of a planar hull are coplanar too, but face the other way. Otherwise
+        // coplanar neighbours always face the same way, even if the float normal of a sliver is 0
+        const float facing = ctx->planes.nx[seed]*ctx->planes.nx[neighbour] + ctx->planes.ny[seed]*ctx->planes.ny[neighbour] + ctx->planes.nz[seed]*ctx->planes.nz[neighbour];
+        if (polygonOf[neighbour] == NO_INDEX && (facing > 0.f || !ctx->isPlanar) && orient3d(a, b, c, ctx->vertices + opposite) == 0.) {
+          polygonOf[neighbour] = seed;
+          queue[numQueue++] = neighbour;
+        } else {
+          boundaryEdge = edge;
+        }
+      }
+    }
+
+    // the next boundary edge starts at the end of this one, so turn around that vertex inside the set
+    int numLoop = 0;
+    int edge = boundaryEdge;
+    do {
+      int next = nextHalfEdge(edge);
+      while (polygonOf[ctx->faceTwins[next]/EDGES_PER_FACE] == seed) {
+        next = nextHalfEdge(ctx->faceTwins[next]);
+      }
+
+      loopNext[edge] = next;
+      loopPrev[next] = edge;
+      numLoop++;
+      edge = next;
+    } while (edge != boundaryEdge);
+
+    loopStarts[seed] = boundaryEdge;
+    loopSizes[seed] = numLoop;
+    ctx->visibleFaces[numPolygons++] = seed;
+  }
+
+  return numPolygons;
+}
+
+// merges other into polygon, where edge is an edge of polygon which borders other. Returns false if they share
+// more than one chain of edges, or the result would not be convex when seen along normal
+bool mergePolygons(HullContext* ctx, const int polygon, const int other, const int edge, const float* normal) {
+  const int* polygonOf = ctx->newFaces;
+  int* mergedInto = ctx->pendingFaces;
+  int* loopNext = ctx->outEdges;
+  int* loopPrev = ctx->outEdges + ctx->faceCapacity*EDGES_PER_FACE;
+  int* loopStarts = ctx->horizon;
+  int* loopSizes = ctx->horizon + ctx->faceCapacity;
+  const int size = loopSizes[polygon];
+  int first = edge;
+  int last = edge;
+  int numChain = 1;
+  int numShared = 0;
+
+  while (numChain < size && findPolygon(mergedInto, polygonOf[ctx->faceTwins[loopPrev[first]]/EDGES_PER_FACE]) == other) {
+    first = loopPrev[first];
+    numChain++;
+  }
+
+  while (numChain < size && findPolygon(mergedInto, polygonOf[ctx->faceTwins[loopNext[last]]/EDGES_PER_FACE]) == other) {
+    last = loopNext[last];
+    numChain++;
+  }
+
+  for (int i = 0, e = first; i < size; i++, e = loopNext[e]) {
+    numShared += findPolygon(mergedInto, polygonOf[ctx->faceTwins[e]/EDGES_PER_FACE]) == other;
+  }
+
+  if (numShared != numChain || numChain >= size || numChain >= loopSizes[other]) {
+    return false;
+  }
+
+  // the chain runs the other way around other, from the twin of last to the twin of first
+  const int before = loopPrev[first];
+  const int after = loopNext[last];
+  const int otherBefore = loopPrev[ctx->faceTwins[last]];
+  const int otherAfter = loopNext[ctx->faceTwins[first]];
+
+  if (!isConvexCorner(ctx, before, otherAfter, normal) || !isConvexCorner(ctx, otherBefore, after, normal)) {
+    return false;
+  }
+
+  loopNext[before] = otherAfter;
+  loopPrev[otherAfter] = before;
+  loopNext[otherBefore] = after;
+  loopPrev[after] = otherBefore;
+  loopStarts[polygon] = before;
+  loopSizes[polygon] += loopSizes[other] - 2*numChain;
+  mergedInto[other] = polygon;
+  return true;
+}
+
+// each polygon in turn absorbs the later polygons around it with normals within minCosine of its own
+void mergeNearlyCoplanarPolygons(HullContext* ctx, const int numPolygons, const float minCosine) {
+  const int* polygonOf = ctx->newFaces;
+  int* mergedInto = ctx->pendingFaces;
+  const int* loopNext = ctx->outEdges;
+  const int* loopStarts = ctx->horizon;
+  const int* loopSizes = ctx->horizon + ctx->faceCapacity;
+
+  for (int i = 0; i < numPolygons; i++) {
+    mergedInto[ctx->visibleFaces[i]] = ctx->visibleFaces[i];
+  }
+
+  for (int i = 0; i < numPolygons; i++) {
+    const int polygon = ctx->visibleFaces[i];
+    if (mergedInto[polygon] != polygon) {
+      continue;
+    }
+
+    const float normal[] = { ctx->planes.nx[polygon], ctx->planes.ny[polygon], ctx->planes.nz[polygon] };
+    bool isMerged = true;
+
+    while (isMerged) {
+      isMerged = false;
+
+      for (int j = 0, edge = loopStarts[polygon]; !isMerged && j < loopSizes[polygon]; j++, edge = loopNext[edge]) {
+        // earlier polygons have had their turn, and may have absorbed polygons which are not close to this one
+        const int other = findPolygon(mergedInto, polygonOf[ctx->faceTwins[edge]/EDGES_PER_FACE]);
+        if (other <= polygon) {
+          continue;
+        }
+
+        const float otherNormal[] = { ctx->planes.nx[other], ctx->planes.ny[other], ctx->planes.nz[other] };
+        isMerged = dot(normal, otherNormal) >= minCosine && mergePolygons(ctx, polygon, other, edge, normal);
+      }
+    }
+  }
+}
+
+// writes the current hull as convex polygons, see above. outIndices gets the vertex offsets of each polygon,
+// counter-clockwise when seen from outside, outFaceSizes the number of vertices in each polygon and outPlanes 4
+// floats per polygon, (nx, ny, nz, d) where n.p - d is the distance of p in front of the polygon. Returns the
+// number of indices and sets outNumFaces to the number of polygons
+int writeHullPolygons(HullContext* ctx, int* outIndices, int* outFaceSizes, float* outPlanes, int* outNumFaces, const float maxAngle) {
+  const int numPolygons = buildCoplanarPolygons(ctx);
+  int numIndices = 0;
+  int numFaces = 0;
+
+  if (maxAngle > 0.f) {
+    mergeNearlyCoplanarPolygons(ctx, numPolygons, cosf(maxAngle));
+  }
+
+  for (int i = 0; i < numPolygons; i++) {
+    const int polygon = ctx->visibleFaces[i];
+    if (maxAngle > 0.f && ctx->pendingFaces[polygon] != polygon) {
+      continue; // merged into another polygon
+    }
+
+    const int size = ctx->horizon[ctx->faceCapacity + polygon];
+    for (int j = 0, edge = ctx->horizon[polygon]; j < size; j++, edge = ctx->outEdges[edge]) {
+      outIndices[numIndices++] = ctx->faceIndices[edge];
+    }
+
+    float* plane = outPlanes + numFaces*4;
+    plane[0] = ctx->planes.nx[polygon];
+    plane[1] = ctx->planes.ny[polygon];
+    plane[2] = ctx->planes.nz[polygon];
+    plane[3] = ctx->planes.d[polygon];
+    outFaceSizes[numFaces++] = size;
+  }
+
+  *outNumFaces = numFaces;
+  return numIndices;
+}
+
+// builds the hull and writes it as convex polygons, see writeHullPolygons(). maxAngle is in radians, 0 to only
+// merge exactly coplanar faces. outIndices must have room for POINTS_PER_FACE*(2*numVertices/stride - 4) ints,
+// outFaceSizes for 2*numVertices/stride - 4 ints and outPlanes for 4 floats per face. Returns the number of
+// indices, or the same negative results as generateHullTriangles()
+EMSCRIPTEN_KEEPALIVE
+int generateHullPolygons(HullContext* ctx, int* outIndices, int* outFaceSizes, float* outPlanes, int* outNumFaces, const float* vertices, const int numVertices, const int stride, const float maxAngle) {
+  *outNumFaces = 0;
+  const int result = buildQuickHull(ctx, vertices, numVertices, stride);
+  return result < 0 ? result : writeHullPolygons(ctx, outIndices, outFaceSizes, outPlanes, outNumFaces, maxAngle);
+}
+
+// Minimal hull
+// Quickhull only adds points which are strictly outside the hull, but a point added early on can end up inside
+// a face or an edge once later points are added around it, e.g. on a lattice, where whole rows of points are
+// coplanar. A vertex is a corner of the hull exactly when it is not collinear with its neighbours on the
+// boundary of one of the coplanar polygons (see buildCoplanarPolygons()), and then it is a corner of every
+// polygon it is on. So once the outside sets are empty, any hull with a polygon of more than one face is
+// rebuilt as a fan of triangles over the corners of each polygon, and the other vertices are dropped.
+// corners (horizonStack) holds the corners of each polygon in turn and numCorners (pendingFaces) their number.
+// The half-edges of the fans are linked into a list for each start vertex, through edgeHeads (pointNext, indexed
+// by vertex number) and edgeNext (outEdges), to find their twins.
+
+// true if any two neighbouring faces are exactly coplanar. The float planes rule out almost every pair
+bool hasCoplanarNeighbours(const HullContext* ctx) {
+  for (int face = 0; face < ctx->numFaces; face++) {
+    const int* indices = ctx->faceIndices + face*POINTS_PER_FACE;
+    if (indices[0] == NO_INDEX) {
+      continue;
+    }
+
+    for (int k = 0; k < EDGES_PER_FACE; k++) {
+      const int twin = ctx->faceTwins[face*EDGES_PER_FACE + k];
+      const float* opposite = ctx->vertices + ctx->faceIndices[nextHalfEdge(nextHalfEdge(twin))];
+
+      if (fabsf(distanceToFace(ctx, face, opposite)) <= ctx->planeErrors[face] &&
+        orient3d(ctx->vertices + indices[0], ctx->vertices + indices[1], ctx->vertices + indices[2], opposite) == 0.) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+// rebuilds the hull from the corners of its coplanar polygons, see above. The outside sets must be empty
+void simplifyHull(HullContext* ctx) {
+  // the planar hull is built from its corners already
+  if (ctx->isPlanar || !hasCoplanarNeighbours(ctx)) {
+    return;
+  }
+
+  const int numPolygons = buildCoplanarPolygons(ctx);
+
+  const int* loopNext = ctx->outEdges;
+  const int* loopStarts = ctx->horizon;
+  const int* loopSizes = ctx->horizon + ctx->faceCapacity;
+  int* corners = ctx->horizonStack;
+  int* numCorners = ctx->pendingFaces;
+  int* edgeHeads = ctx->pointNext;
+  int* edgeNext = ctx->outEdges;
+  const float offset = ctx->maxCoord + 1.f;
+  int numTotal = 0;
+
+  for (int i = 0; i < numPolygons; i++) {
+    const int polygon = ctx->visibleFaces[i];
+    numCorners[i] = 0;
+
+    for (int j = 0, edge = loopStarts[polygon]; j < loopSizes[polygon]; j++, edge = loopNext[edge]) {
+      const int vertex = ctx->faceIndices[loopNext[edge]];
+      const float* p = ctx->vertices + vertex;
+      const float* prev = ctx->vertices + ctx->faceIndices[edge];
+      const float* next = ctx->vertices + ctx->faceIndices[loopNext[loopNext[edge]]];
+
+      // the float normal of a sliver can be 0, so test against a point off p along each axis instead (towards
+      // the origin, so it can't overflow). All three are only coplanar with prev, p and next if those are collinear
+      const float apexes[3][3] = {
+        { p[0] - copysignf(offset, p[0]), p[1], p[2] },
+        { p[0], p[1] - copysignf(offset, p[1]), p[2] },
+        { p[0], p[1], p[2] - copysignf(offset, p[2]) },
+      };
+      if (orient3d(prev, p, next, apexes[0]) != 0. || orient3d(prev, p, next, apexes[1]) != 0. || orient3d(prev, p, next, apexes[2]) != 0.) {
+        corners[numTotal++] = vertex;
+        edgeHeads[vertex/ctx->stride] = NO_INDEX;
+        numCorners[i]++;
+      }
+    }
+  }
+
+  ctx->stats.numFacesDestroyed += ctx->numLiveFaces;
+  ctx->numFaces = 0;
+  ctx->numLiveFaces = 0;
+  ctx->numFreeFaces = 0;
+
+  for (int i = 0, first = 0; i < numPolygons; first += numCorners[i++]) {
+    for (int j = 1; j + 1 < numCorners[i]; j++) {
+      addQuickHullFace(ctx, corners[first], corners[first + j], corners[first + j + 1]);
+    }
+  }
+
+  for (int edge = 0; edge < ctx->numFaces*EDGES_PER_FACE; edge++) {
+    const int vertex = ctx->faceIndices[edge]/ctx->stride;
+    edgeNext[edge] = edgeHeads[vertex];
+    edgeHeads[vertex] = edge;
+  }
+
+  // the twin of the half-edge from a to b is the half-edge from b to a
+  for (int edge = 0; edge < ctx->numFaces*EDGES_PER_FACE; edge++) {
+    const int start = ctx->faceIndices[edge];
+    int twin = edgeHeads[ctx->faceIndices[nextHalfEdge(edge)]/ctx->stride];
+
+    while (ctx->faceIndices[nextHalfEdge(twin)] != start) {
+      twin = edgeNext[twin];
+    }
+
+    ctx->faceTwins[edge] = twin;
+  }
+}
+
+// Hull queries
+// A HullQuery keeps the planes of a hull's polygons (see writeHullPolygons()), so many points or rays can be
+// tested against the hull in one call. The planes are padded to a multiple of HULL_SIMD_WIDTH with copies of
+// the first plane, so the kernels test HULL_SIMD_WIDTH planes at a time with no scalar tail, and a point stops
+// at the first block with a plane it is in front of.
+
+typedef struct HullQuery {
+  HullPlanes planes;
+  int numPlanes;
+  int numPaddedPlanes;
+} HullQuery;
+
+EMSCRIPTEN_KEEPALIVE
+void hullQueryDestroy(HullQuery* query) {
+  if (query == NULL) {
+    return;
+  }
+
+  free(query->planes.nx);
+  free(query);
+}
+
+// planes are packed as nx, ny, nz, d with unit normals, e.g. the outPlanes of generateHullPolygons(). Returns
+// NULL if there are no planes, or if out of memory
+EMSCRIPTEN_KEEPALIVE
+HullQuery* hullQueryCreate(const float* planes, const int numPlanes) {
+  if (numPlanes <= 0) {
+    return NULL;
+  }
+
+  const int numPaddedPlanes = (numPlanes + HULL_SIMD_WIDTH - 1)/HULL_SIMD_WIDTH*HULL_SIMD_WIDTH;
+  HullQuery* query = calloc(1, sizeof(HullQuery));
+  float* buffer = malloc(numPaddedPlanes*4*sizeof(float));
+  if (query == NULL || buffer == NULL) {
+    free(query);
+    free(buffer);
+    return NULL;
+  }
+
+  query->planes = (HullPlanes){ buffer, buffer + numPaddedPlanes, buffer + 2*numPaddedPlanes, buffer + 3*numPaddedPlanes };
+  query->numPlanes = numPlanes;
+  query->numPaddedPlanes = numPaddedPlanes;
+
+  for (int i = 0; i < numPaddedPlanes; i++) {
+    const float* plane = planes + (i < numPlanes ? i : 0)*4;
+    query->planes.nx[i] = plane[0];
+    query->planes.ny[i] = plane[1];
+    query->planes.nz[i] = plane[2];
+    query->planes.d[i] = plane[3];
+  }
+
+  return query;
+}
+
+// builds the hull of the vertices and a query for it, with one plane per polygon of generateHullPolygons()
+// with a maxAngle of 0, so the faces of hullRaycast() are the polygons in that order. Returns NULL if there is
+// no hull, or if out of memory
+EMSCRIPTEN_KEEPALIVE
+HullQuery* generateHullQuery(HullContext* ctx, const float* vertices, const int numVertices, const int stride) {
+  if (buildQuickHull(ctx, vertices, numVertices, stride) < 0) {
+    return NULL;
+  }
+
+  const int numPolygons = buildCoplanarPolygons(ctx);
+  float* planes = malloc(numPolygons*4*sizeof(float));
+  if (planes == NULL) {
+    return NULL;
+  }
+
+  for (int i = 0; i < numPolygons; i++) {
+    const int polygon = ctx->visibleFaces[i];
+    planes[i*4] = ctx->planes.nx[polygon];
+    planes[i*4 + 1] = ctx->planes.ny[polygon];
+    planes[i*4 + 2] = ctx->planes.nz[polygon];
+    planes[i*4 + 3] = ctx->planes.d[polygon];
+  }
+
+  HullQuery* query = hullQueryCreate(planes, numPolygons);
+  free(planes);
+  return query;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int hullQueryNumPlanes(const HullQuery* query) {
+  return query->numPlanes;
+}
+
+#if HULL_SIMD_WIDTH > 1
+// dot products of the direction with the normals of planes i to i + HULL_SIMD_WIDTH - 1
+simdFloat simdPlaneDots(const HullPlanes* planes, const int i, const simdFloat dx, const simdFloat dy, const simdFloat dz) {
+  const simdFloat xy = simdAdd( simdMul(simdLoad(planes->nx + i), dx), simdMul(simdLoad(planes->ny + i), dy) );
+  return simdAdd( xy, simdMul(simdLoad(planes->nz + i), dz) );
+}
+#endif
+
+bool isInsideQuery(const HullQuery* query, const float* point) {
+#if HULL_SIMD_WIDTH > 1
+  const simdFloat px = simdSplat(point[0]);
+  const simdFloat py = simdSplat(point[1]);
+  const simdFloat pz = simdSplat(point[2]);
+  const simdFloat zero = simdSplat(0.f);
+
+  for (int i = 0; i < query->numPaddedPlanes; i += HULL_SIMD_WIDTH) {
+    if (simdGreaterMask( simdPlaneDistances(&query->planes, i, px, py, pz), zero )) {
+      return false;
+    }
+  }
+#else
+  for (int i = 0; i < query->numPlanes; i++) {
+    if (planeDistance(&query->planes, i, point) > 0.f) {
+      return false;
+    }
+  }
+#endif
+
+  return true;
+}
+
+// points are packed x, y, z. outMask gets 1 for each point inside or on the hull, 0 otherwise. Returns the
+// number of points inside
+EMSCRIPTEN_KEEPALIVE
+int hullContainsPoints(const HullQuery* query, const float* points, const int numPoints, uint8_t* outMask) {
+  int numInside = 0;
+
+  for (int i = 0; i < numPoints; i++) {
+    outMask[i] = isInsideQuery(query, points + i*3);
+    numInside += outMask[i];
+  }
+
+  return numInside;
+}
+
+#if HULL_SIMD_WIDTH > 1
+// the t where the ray crosses planes i to i + HULL_SIMD_WIDTH - 1, replaced with -FLT_MAX for the planes it
+// leaves through, or is parallel to
+simdFloat simdEnterDistances(const HullPlanes* planes, const int i, const simdFloat* origin, const simdFloat* direction) {
+  const simdFloat zero = simdSplat(0.f);
+  const simdFloat dots = simdPlaneDots(planes, i, direction[0], direction[1], direction[2]);
+  const simdFloat t = simdDiv( simdPlaneDistances(planes, i, origin[0], origin[1], origin[2]), simdSub(zero, dots) );
+  return simdSelectLess(dots, zero, t, simdSplat(-FLT_MAX));
+}
+
+float horizontalMax(const simdFloat a) {
+  float lanes[HULL_SIMD_WIDTH];
+  float result = -FLT_MAX;
+  simdStore(lanes, a);
+  for (int lane = 0; lane < HULL_SIMD_WIDTH; lane++) {
+    result = fmaxf(result, lanes[lane]);
+  }
+  return result;
+}
+
+float horizontalMin(const simdFloat a) {
+  float lanes[HULL_SIMD_WIDTH];
+  float result = FLT_MAX;
+  simdStore(lanes, a);
+  for (int lane = 0; lane < HULL_SIMD_WIDTH; lane++) {
+    result = fminf(result, lanes[lane]);
+  }
+  return result;
+}
+#endif
+
+// rays are packed origin x, y, z then direction x, y, z, and t is in lengths of the direction. outT gets the
+// t where each ray enters the hull, and outFace the plane it enters through. A ray which starts inside the
+// hull gets a t of 0 and a face of -1, and a ray which misses gets -1 for both. Returns the number of hits
+// Each ray is clipped to the slab behind every plane, the ray enters the hull at the largest t of the planes
+// it heads into, and leaves at the smallest t of the planes it heads away from.
+EMSCRIPTEN_KEEPALIVE
+int hullRaycast(const HullQuery* query, const float* rays, const int numRays, float* outT, int* outFace) {
+  const HullPlanes* planes = &query->planes;
+  int numHits = 0;
+
+  for (int r = 0; r < numRays; r++) {
+    const float* origin = rays + r*6;
+    const float* direction = origin + 3;
+    float enter = 0.f;
+    float exit = FLT_MAX;
+    int face = NO_INDEX;
+    bool isHit = true;
+
+#if HULL_SIMD_WIDTH > 1
+    const simdFloat o[3] = { simdSplat(origin[0]), simdSplat(origin[1]), simdSplat(origin[2]) };
+    const simdFloat d[3] = { simdSplat(direction[0]), simdSplat(direction[1]), simdSplat(direction[2]) };
+    const simdFloat zero = simdSplat(0.f);
+    simdFloat enters = zero;
+    simdFloat exits = simdSplat(FLT_MAX);
+
+    for (int i = 0; isHit && i < query->numPaddedPlanes; i += HULL_SIMD_WIDTH) {
+      const simdFloat distances = simdPlaneDistances(planes, i, o[0], o[1], o[2]);
+      const simdFloat dots = simdPlaneDots(planes, i, d[0], d[1], d[2]);
+
+      // in front of a plane and not heading towards it, the common miss
+      isHit = !(simdGreaterMask(distances, zero) & simdGreaterEqualMask(dots, zero));
+
+      const simdFloat t = simdDiv( distances, simdSub(zero, dots) );
+      enters = simdMax( enters, simdSelectLess(dots, zero, t, simdSplat(-FLT_MAX)) );
+      exits = simdMin( exits, simdSelectLess(zero, dots, t, simdSplat(FLT_MAX)) );
+    }
+
+    enter = horizontalMax(enters);
+    exit = horizontalMin(exits);
+    isHit = isHit && enter <= exit;
+
+    // the first plane with the entering t, the same arithmetic gives the same t
+    if (isHit && enter > 0.f) {
+      const simdFloat threshold = simdSplat(enter);
+      for (int i = 0; face == NO_INDEX && i < query->numPaddedPlanes; i += HULL_SIMD_WIDTH) {
+        const int mask = simdGreaterEqualMask( simdEnterDistances(planes, i, o, d), threshold );
+        face = mask ? i + __builtin_ctz(mask) : NO_INDEX;
+      }
+    }
+#else
+    for (int i = 0; isHit && i < query->numPlanes; i++) {
+      const float distance = planeDistance(planes, i, origin);
+      const float dotProduct = planes->nx[i]*direction[0] + planes->ny[i]*direction[1] + planes->nz[i]*direction[2];
+      const float t = distance/-dotProduct;
+
+      if (dotProduct < 0.f && t > enter) {
+        enter = t;
+        face = i;
+      } else if (dotProduct > 0.f) {
+        exit = fminf(exit, t);
+      }
+
+      isHit = !(distance > 0.f && dotProduct >= 0.f) && enter <= exit;
+    }
+#endif
+
+    outT[r] = isHit ? enter : -1.f;
+    outFace[r] = isHit ? face : NO_INDEX;
+    numHits += isHit;
+  }
+
+  return numHits;
+}
+
+// Bounding volumes
+// Tight boxes and spheres for culling and broadphases, from the vertices of a hull (the triangles of
+// generateHullTriangles()), which are usually a small fraction of the points. Only the distinct vertices are
+// looked at, and the final extents are measured over all of them, so the volume always contains the hull.
+//
+// The oriented box is the smallest one with a face on a face of the hull. It tries one direction per distinct
+// face normal (coplanar triangles are one face, and opposite faces give the same direction). The vertices are
+// projected onto the plane of the face, and rotating calipers over the edges of the projected polygon find its
+// smallest rectangle, so the box also has a side along an edge of its silhouette. A minimum volume box always
+// has two adjacent faces which each hold an edge of the hull (O'Rourke), so this only misses it when no face of
+// the best box holds a whole face of the hull, as edge directions are not tried. The axis aligned box is tried
+// too, so the result is never bigger than that. For each direction the depth is found by climbing the edges
+// from the extreme vertices of the last one, and only the vertices of the silhouette are sorted, from the edges
+// between faces that face it and faces that don't, so the time is O(faces*edges) of the hull.
+//
+// The sphere is Welzl's algorithm in its move to front form, without recursion: a point outside the sphere of
+// the points before it is on the boundary of the new sphere, which is grown over the points before it with
+// that point fixed, and so on for up to 4 fixed points. The points are shuffled first (with a fixed seed, so
+// the result is repeatable), which makes the expected time linear. The spheres are solved in doubles.
+
+#define SPHERE_TOLERANCE (1e-6) // relative to the radius squared, points this close don't grow the sphere
+#define MIN_PARALLEL_DOT (1.f - 1e-6f) // face normals closer than this give the same box direction
+#define MIN_SIDE_ON_DOT (1e-4f) // faces closer than this to side on are on the silhouette from both sides
+#define MIN_CORNER_DISTANCE (1e-6f) // relative to the size of a projected polygon, closer corners are merged
+
+// writes the distinct vertices of the triangles (offsets) to outOffsets, with room for numIndices. Returns the
+// number of vertices
+int collectHullVertices(int* outOffsets, const int* indices, const int numIndices) {
+  memcpy(outOffsets, indices, numIndices*sizeof(int));
+  qsort(outOffsets, numIndices, sizeof(int), compareInts);
+
+  int numUnique = 0;
+  for (int i = 0; i < numIndices; i++) {
+    if (numUnique == 0 || outOffsets[i] != outOffsets[numUnique - 1]) {
+      outOffsets[numUnique++] = outOffsets[i];
+    }
+  }
+  return numUnique;
+}
+
+// writes the smallest and largest projections of the vertices onto each of the 3 axes
+void calcBoxExtents(float* outMin, float* outMax, const float* axes, const float* vertices, const int* offsets, const int numOffsets) {
+  for (int k = 0; k < 3; k++) {
+    outMin[k] = FLT_MAX;
+    outMax[k] = -FLT_MAX;
+  }
+
+  for (int i = 0; i < numOffsets; i++) {
+    for (int k = 0; k < 3; k++) {
+      const float projection = dot(axes + k*3, vertices + offsets[i]);
+      outMin[k] = fminf(outMin[k], projection);
+      outMax[k] = fmaxf(outMax[k], projection);
+    }
+  }
+}
+
+// the distances of p along the side (su, sv) from origin, and away from it to the left
+float calcDistanceAlong(const PlanarPoint* p, const PlanarPoint* origin, const float su, const float sv) {
+  return (p->u - origin->u)*su + (p->v - origin->v)*sv;
+}
+
+float calcDistanceAway(const PlanarPoint* p, const PlanarPoint* origin, const float su, const float sv) {
+  return (p->v - origin->v)*su - (p->u - origin->u)*sv;
+}
+
+// drops the corners of the convex polygon which are within MIN_CORNER_DISTANCE of the one before (and the last
+// if it is that close to the first), as the calipers below stop at them. Returns the number of corners left
+int mergeCloseCorners(PlanarPoint* polygon, const int numCorners) {
+  float minU = FLT_MAX, maxU = -FLT_MAX, minV = FLT_MAX, maxV = -FLT_MAX;
+  for (int i = 0; i < numCorners; i++) {
+    minU = fminf(minU, polygon[i].u);
+    maxU = fmaxf(maxU, polygon[i].u);
+    minV = fminf(minV, polygon[i].v);
+    maxV = fmaxf(maxV, polygon[i].v);
+  }
+
+  const float minDistance = fmaxf(maxU - minU, maxV - minV)*MIN_CORNER_DISTANCE;
+  int numKept = numCorners > 0 ? 1 : 0;
+  for (int i = 1; i < numCorners; i++) {
+    const PlanarPoint* last = polygon + numKept - 1;
+    if (fabsf(polygon[i].u - last->u) > minDistance || fabsf(polygon[i].v - last->v) > minDistance) {
+      polygon[numKept++] = polygon[i];
+    }
+  }
+
+  const bool isLastClose = numKept > 1 && fabsf(polygon[numKept - 1].u - polygon[0].u) <= minDistance &&
+    fabsf(polygon[numKept - 1].v - polygon[0].v) <= minDistance;
+  return isLastClose ? numKept - 1 : numKept;
+}
+
+// the smallest rectangle around the convex polygon (counter-clockwise in (u, v)) by rotating calipers, one side
+// of it is on an edge of the polygon. Writes the direction of that side to outSide, and the width along it and
+// the height away from it to outSize. Returns the area, or 0 if no rectangle has a positive, finite area
+float calcMinAreaRectangle(float* outSide, float* outSize, const PlanarPoint* polygon, const int numCorners) {
+  float bestArea = FLT_MAX;
+  int right = NO_INDEX, top = NO_INDEX, left = NO_INDEX; // the farthest corners along the side, away from it, and back
+
+  outSide[0] = 1.f, outSide[1] = 0.f;
+  outSize[0] = outSize[1] = 0.f;
+
+  for (int i = 0; i < numCorners && numCorners >= 2; i++) {
+    const PlanarPoint* a = polygon + i;
+    const PlanarPoint* b = polygon + (i + 1) % numCorners;
+    const float length = sqrtf(sqr(b->u - a->u) + sqr(b->v - a->v));
+    if (length == 0.f) {
+      continue;
+    }
+
+    // as the side turns each farthest corner only moves forward, so they are found by stepping on from where
+    // they were for the last side. For the first side each starts from the one before
+    const float su = (b->u - a->u)/length, sv = (b->v - a->v)/length;
+    right = right == NO_INDEX ? (i + 1) % numCorners : right;
+    while (calcDistanceAlong(polygon + (right + 1) % numCorners, a, su, sv) > calcDistanceAlong(polygon + right, a, su, sv)) {
+      right = (right + 1) % numCorners;
+    }
+    top = top == NO_INDEX ? right : top;
+    while (calcDistanceAway(polygon + (top + 1) % numCorners, a, su, sv) > calcDistanceAway(polygon + top, a, su, sv)) {
+      top = (top + 1) % numCorners;
+    }
+    left = left == NO_INDEX ? top : left;
+    while (calcDistanceAlong(polygon + (left + 1) % numCorners, a, su, sv) < calcDistanceAlong(polygon + left, a, su, sv)) {
+      left = (left + 1) % numCorners;
+    }
+
+    const float width = calcDistanceAlong(polygon + right, a, su, sv) - calcDistanceAlong(polygon + left, a, su, sv);
+    const float height = calcDistanceAway(polygon + top, a, su, sv);
+    if (width*height > 0.f && width*height < bestArea) {
+      bestArea = width*height;
+      outSide[0] = su, outSide[1] = sv;
+      outSize[0] = width, outSize[1] = height;
+    }
+  }
+
+  return bestArea == FLT_MAX ? 0.f : bestArea;
+}
+
+typedef struct {
+  int a, b; // vertex numbers, a < b
+  int faces[2]; // the second is NO_INDEX if the triangles are not closed
+} HullEdge;
+
+int compareHullEdges(const void* a, const void* b) {
+  const HullEdge* p = a;
+  const HullEdge* q = b;
+  return p->a != q->a ? (p->a < q->a ? -1 : 1) : p->b != q->b ? (p->b < q->b ? -1 : 1) : 0;
+}
+
+// writes each edge of the triangles once to outEdges (room for numIndices), with its two faces, where vertex
+// numbers index offsets (ascending, see collectHullVertices()). Returns the number of edges
+int collectHullEdges(HullEdge* outEdges, const int* indices, const int numIndices, const int* offsets, const int numOffsets) {
+  for (int i = 0; i < numIndices; i++) {
+    const int next = i - i % POINTS_PER_FACE + (i + 1) % POINTS_PER_FACE;
+    const int a = (int*)bsearch(indices + i, offsets, numOffsets, sizeof(int), compareInts) - offsets;
+    const int b = (int*)bsearch(indices + next, offsets, numOffsets, sizeof(int), compareInts) - offsets;
+    outEdges[i] = (HullEdge){ a < b ? a : b, a < b ? b : a, { i/POINTS_PER_FACE, NO_INDEX } };
+  }
+
+  qsort(outEdges, numIndices, sizeof(HullEdge), compareHullEdges);
+
+  int numEdges = 0;
+  for (int i = 0; i < numIndices; i++) {
+    if (numEdges > 0 && compareHullEdges(outEdges + numEdges - 1, outEdges + i) == 0 && outEdges[numEdges - 1].faces[1] == NO_INDEX) {
+      outEdges[numEdges - 1].faces[1] = outEdges[i].faces[0];
+    } else {
+      outEdges[numEdges++] = outEdges[i];
+    }
+  }
+  return numEdges;
+}
+
+typedef struct {
+  float area;
+  int face; // the first face of a set of coplanar faces
+} BoxDirection;
+
+// larger areas first, then lower faces
+int compareBoxDirections(const void* a, const void* b) {
+  const BoxDirection* p = a;
+  const BoxDirection* q = b;
+  return p->area != q->area ? (p->area > q->area ? -1 : 1) : p->face != q->face ? (p->face < q->face ? -1 : 1) : 0;
+}
+
+// writes the neighbours of each vertex, from the edges, to outNeighbours as lists starting at outStarts (room
+// for numVertices + 1)
+void collectHullNeighbours(int* outStarts, int* outNeighbours, const HullEdge* edges, const int numEdges, const int numVertices) {
+  memset(outStarts, 0, (numVertices + 1)*sizeof(int));
+  for (int i = 0; i < numEdges; i++) {
+    outStarts[edges[i].a + 1]++;
+    outStarts[edges[i].b + 1]++;
+  }
+  for (int i = 0; i < numVertices; i++) {
+    outStarts[i + 1] += outStarts[i];
+  }
+  for (int i = 0; i < numEdges; i++) {
+    outNeighbours[outStarts[edges[i].a]++] = edges[i].b;
+    outNeighbours[outStarts[edges[i].b]++] = edges[i].a;
+  }
+  for (int i = numVertices; i > 0; i--) {
+    outStarts[i] = outStarts[i - 1];
+  }
+  outStarts[0] = 0;
+}
+
+// the vertex farthest along direction, by stepping from start to any neighbour that is farther until none is.
+// On a convex hull there are no other local maxima
+int climbToExtremeVertex(const float* direction, int start, const float* vertices, const int* offsets, const int* starts, const int* neighbours) {
+  float best = dot(vertices + offsets[start], direction);
+  for (bool moved = true; moved;) {
+    moved = false;
+    for (int i = starts[start]; i < starts[start + 1]; i++) {
+      const float projection = dot(vertices + offsets[neighbours[i]], direction);
+      if (projection > best) {
+        best = projection;
+        start = neighbours[i];
+        moved = true;
+        break;
+      }
+    }
+  }
+  return start;
+}
+
+// writes the oriented box of the hull's vertices to outBox as center (3 floats), axes (3 unit vectors, right
+// handed) and half extents along each axis (3 floats), see above. vertices are the ones the triangles were built
+// from, and indices are offsets into them. Returns 0, -1 if there are no triangles, or -3 if out of memory
+EMSCRIPTEN_KEEPALIVE
+int calcHullOrientedBox(float* outBox, const float* vertices, const int* indices, const int numIndices) {
+  if (numIndices < POINTS_PER_FACE) {
+    return -1;
+  }
+
+  const int numFaces = numIndices/POINTS_PER_FACE;
+  int* offsets = malloc(numIndices*4*sizeof(int)); // then the direction each vertex was last projected for, and neighbours
+  int* groups = malloc((numFaces + numIndices + 1)*sizeof(int)); // the set of each face, then where neighbours start
+  float* normals = malloc(numFaces*4*sizeof(float)); // then which side of the direction each face is on
+  BoxDirection* directions = malloc(numFaces*sizeof(BoxDirection));
+  HullEdge* edges = malloc(numIndices*sizeof(HullEdge));
+  PlanarPoint* points = malloc((2*numIndices + 1)*sizeof(PlanarPoint));
+  if (offsets == NULL || groups == NULL || normals == NULL || directions == NULL || edges == NULL || points == NULL) {
+    free(offsets);
+    free(groups);
+    free(normals);
+    free(directions);
+    free(edges);
+    free(points);
+    return -3;
+  }
+
+  const int numVertices = collectHullVertices(offsets, indices, numIndices);
+  const int numEdges = collectHullEdges(edges, indices, numIndices - numIndices % POINTS_PER_FACE, offsets, numVertices);
+  int* projected = offsets + numVertices;
+  int* neighbours = projected + numVertices;
+  int* neighbourStarts = groups + numFaces;
+  float* sides = normals + numFaces*3;
+  PlanarPoint* polygon = points + numVertices;
+  float min[3], max[3];
+
+  collectHullNeighbours(neighbourStarts, neighbours, edges, numEdges, numVertices);
+  for (int face = 0; face < numFaces; face++) {
+    const int* triangle = indices + face*POINTS_PER_FACE;
+    setFromCoplanarPoints(normals + face*3, vertices + triangle[0], vertices + triangle[1], vertices + triangle[2]);
+    groups[face] = face;
+    directions[face] = (BoxDirection){ 0.f, face };
+  }
+  for (int i = 0; i < numVertices; i++) {
+    projected[i] = NO_INDEX;
+  }
+
+  // neighbouring faces with the same normal are one face of the hull, whose area is the sum of theirs
+  for (int i = 0; i < numEdges; i++) {
+    const int* faces = edges[i].faces;
+    if (faces[1] != NO_INDEX && dot(normals + faces[0]*3, normals + faces[1]*3) >= MIN_PARALLEL_DOT) {
+      const int a = findPolygon(groups, faces[0]), b = findPolygon(groups, faces[1]);
+      groups[a > b ? a : b] = a < b ? a : b;
+    }
+  }
+  for (int face = 0; face < numFaces; face++) {
+    const int* triangle = indices + face*POINTS_PER_FACE;
+    float ab[3], ac[3], n[3];
+    sub(ab, vertices + triangle[1], vertices + triangle[0]);
+    sub(ac, vertices + triangle[2], vertices + triangle[0]);
+    cross(n, ab, ac);
+    directions[findPolygon(groups, face)].area += sqrtf(dot(n, n))*.5f;
+  }
+
+  int numDirections = 0;
+  for (int face = 0; face < numFaces; face++) {
+    const float* normal = normals + face*3;
+    if (groups[face] == face && dot(normal, normal) > .5f) { // not degenerate
+      directions[numDirections++] = directions[face];
+    }
+  }
+  qsort(directions, numDirections, sizeof(BoxDirection), compareBoxDirections);
+
+  // the axis aligned box to start with, and the surface area decides between boxes of the same volume, e.g.
+  // the flat boxes of a planar hull
+  float axes[9] = { 1.f,0.f,0.f, 0.f,1.f,0.f, 0.f,0.f,1.f };
+  calcBoxExtents(min, max, axes, vertices, offsets, numVertices);
+  float bestVolume = (max[0] - min[0])*(max[1] - min[1])*(max[2] - min[2]);
+  float bestArea = (max[0] - min[0])*(max[1] - min[1]) + (max[1] - min[1])*(max[2] - min[2]) + (max[2] - min[2])*(max[0] - min[0]);
+  int top = 0, bottom = 0; // the farthest vertices along and against the last direction
+
+  for (int d = 0; d < numDirections; d++) {
+    const int face = directions[d].face;
+    const float* normal = normals + face*3;
+    bool isNew = true; // opposite faces give the same direction
+    for (int i = 0; i < d && isNew; i++) {
+      isNew = fabsf(dot(normal, normals + directions[i].face*3)) < MIN_PARALLEL_DOT;
+    }
+    if (!isNew) {
+      continue;
+    }
+
+    // a basis for the plane, from the axis the normal is least along
+    const float absNormal[] = { fabsf(normal[0]), fabsf(normal[1]), fabsf(normal[2]) };
+    const int axis = absNormal[0] <= absNormal[1] && absNormal[0] <= absNormal[2] ? 0 : absNormal[1] <= absNormal[2] ? 1 : 2;
+    float e1[3] = { 0.f, 0.f, 0.f }, e2[3], against[3];
+    e1[axis] = 1.f;
+    normalize(e1, cross(e1, normal, e1));
+    cross(e2, normal, e1);
+
+    multiplyScalar(against, normal, -1.f);
+    top = climbToExtremeVertex(normal, top, vertices, offsets, neighbourStarts, neighbours);
+    bottom = climbToExtremeVertex(against, bottom, vertices, offsets, neighbourStarts, neighbours);
+    const float depth = dot(vertices + offsets[top], normal) - dot(vertices + offsets[bottom], normal);
+
+    // only the vertices of the silhouette, the edges between faces which face the direction and faces which
+    // don't, can be corners of the projection. Faces almost side on count as both
+    for (int i = 0; i < numFaces; i++) {
+      const float facing = dot(normal, normals + i*3);
+      sides[i] = facing > MIN_SIDE_ON_DOT ? 1.f : facing < -MIN_SIDE_ON_DOT ? -1.f : 0.f;
+    }
+
+    int numPoints = 0;
+    for (int i = 0; i < numEdges; i++) {
+      const HullEdge* edge = edges + i;
+      const float side = sides[edge->faces[0]];
+      if (edge->faces[1] != NO_INDEX && side != 0.f && sides[edge->faces[1]] == side) {
+        continue;
+      }
+
+      for (int j = 0; j < 2; j++) {
+        const int vertex = j == 0 ? edge->a : edge->b;
+        if (projected[vertex] != d) {
+          const float* p = vertices + offsets[vertex];
+          projected[vertex] = d;
+          points[numPoints++] = (PlanarPoint){ dot(p, e1), dot(p, e2), vertex };
+        }
+      }
+    }
+
+    float side[2], size[2];
+    const int numCorners = mergeCloseCorners(polygon, calcPlanarChain(polygon, points, numPoints));
+    const float rectangleArea = calcMinAreaRectangle(side, size, polygon, numCorners);
+    const float volume = rectangleArea*depth;
+    const float area = size[0]*size[1] + size[1]*depth + depth*size[0];
+
+    // a polygon with no area gives no rectangle, and a flat hull gives a flat box
+    if (rectangleArea > 0.f && isfinite(volume) && (volume < bestVolume || (volume == bestVolume && area < bestArea))) {
+      bestVolume = volume;
+      bestArea = area;
+      for (int k = 0; k < 3; k++) {
+        axes[k] = e1[k]*side[0] + e2[k]*side[1];
+        axes[3 + k] = e2[k]*side[0] - e1[k]*side[1];
+        axes[6 + k] = normal[k];
+      }
+    }
+  }
+
+  calcBoxExtents(min, max, axes, vertices, offsets, numVertices);
+  memset(outBox, 0, 3*sizeof(float));
+  for (int k = 0; k < 3; k++) {
+    scaleAndAdd(outBox, outBox, axes + k*3, (min[k] + max[k])*.5f);
+    outBox[12 + k] = (max[k] - min[k])*.5f;
+  }
+  memcpy(outBox + 3, axes, 9*sizeof(float));
+
+  free(offsets);
+  free(groups);
+  free(normals);
+  free(directions);
+  free(edges);
+  free(points);
+  return 0;
+}
+
+// sphere is center and radius squared
+bool isInSphere(const double* sphere, const float* point) {
+  const double dx = point[0] - sphere[0], dy = point[1] - sphere[1], dz = point[2] - sphere[2];
+  return dx*dx + dy*dy + dz*dz <= sphere[3]*(1. + SPHERE_TOLERANCE);
+}
+
+// the smallest sphere through a and b
+void calcDiametralSphere(double* outSphere, const float* a, const float* b) {
+  for (int k = 0; k < 3; k++) {
+    outSphere[k] = ((double)a[k] + b[k])*.5;
+  }
+  outSphere[3] = 0.;
+  for (int k = 0; k < 3; k++) {
+    outSphere[3] += ((double)a[k] - outSphere[k])*((double)a[k] - outSphere[k]);
+  }
+}
+
+// the smallest sphere through a, b and c, centered on their circumcircle, or around the farthest two if they
+// are collinear
+void calcCircumsphere3(double* outSphere, const float* a, const float* b, const float* c) {
+  const double ab[] = { (double)b[0] - a[0], (double)b[1] - a[1], (double)b[2] - a[2] };
+  const double ac[] = { (double)c[0] - a[0], (double)c[1] - a[1], (double)c[2] - a[2] };
+  const double n[] = { ab[1]*ac[2] - ab[2]*ac[1], ab[2]*ac[0] - ab[0]*ac[2], ab[0]*ac[1] - ab[1]*ac[0] };
+  const double abSq = ab[0]*ab[0] + ab[1]*ab[1] + ab[2]*ab[2];
+  const double acSq = ac[0]*ac[0] + ac[1]*ac[1] + ac[2]*ac[2];
+  const double nSq = n[0]*n[0] + n[1]*n[1] + n[2]*n[2];
+
+  if (nSq <= DBL_EPSILON*abSq*acSq) {
+    double candidate[4];
+    calcDiametralSphere(outSphere, a, b);
+    calcDiametralSphere(candidate, a, c);
+    memcpy(outSphere, candidate[3] > outSphere[3] ? candidate : outSphere, sizeof(candidate));
+    calcDiametralSphere(candidate, b, c);
+    memcpy(outSphere, candidate[3] > outSphere[3] ? candidate : outSphere, sizeof(candidate));
+    return;
+  }
+
+  // center = a + (acSq*(n x ab) + abSq*(ac x n))/(2*nSq)
+  const double nab[] = { n[1]*ab[2] - n[2]*ab[1], n[2]*ab[0] - n[0]*ab[2], n[0]*ab[1] - n[1]*ab[0] };
+  const double acn[] = { ac[1]*n[2] - ac[2]*n[1], ac[2]*n[0] - ac[0]*n[2], ac[0]*n[1] - ac[1]*n[0] };
+  outSphere[3] = 0.;
+  for (int k = 0; k < 3; k++) {
+    const double offset = (acSq*nab[k] + abSq*acn[k])/(2.*nSq);
+    outSphere[k] = a[k] + offset;
+    outSphere[3] += offset*offset;
+  }
+}
+
+// the sphere through a, b, c and d. If they are coplanar it is the smallest sphere around them instead, which is
+// through 2 or 3 of them
+void calcCircumsphere4(double* outSphere, const float* a, const float* b, const float* c, const float* d) {
+  const float* points[] = { a, b, c, d };
+  double rows[3][3], rhs[3];
+  for (int i = 0; i < 3; i++) {
+    rhs[i] = 0.;
+    for (int k = 0; k < 3; k++) {
+      rows[i][k] = (double)points[i + 1][k] - a[k];
+      rhs[i] += rows[i][k]*rows[i][k]*.5;
+    }
+  }
+
+  // Cramer's rule for rows*offset = rhs
+  const double det = rows[0][0]*(rows[1][1]*rows[2][2] - rows[1][2]*rows[2][1]) - rows[0][1]*(rows[1][0]*rows[2][2] - rows[1][2]*rows[2][0]) + rows[0][2]*(rows[1][0]*rows[2][1] - rows[1][1]*rows[2][0]);
+  const double scale = (rhs[0] + rhs[1] + rhs[2])*2.;
+
+  if (fabs(det) > DBL_EPSILON*scale*sqrt(scale)) {
+    outSphere[3] = 0.;
+    for (int k = 0; k < 3; k++) {
+      double m[3][3];
+      memcpy(m, rows, sizeof(m));
+      for (int i = 0; i < 3; i++) {
+        m[i][k] = rhs[i];
+      }
+      const double offset = (m[0][0]*(m[1][1]*m[2][2] - m[1][2]*m[2][1]) - m[0][1]*(m[1][0]*m[2][2] - m[1][2]*m[2][0]) + m[0][2]*(m[1][0]*m[2][1] - m[1][1]*m[2][0]))/det;
+      outSphere[k] = a[k] + offset;
+      outSphere[3] += offset*offset;
+    }
+    return;
+  }
+
+  // the smallest of the spheres through each pair and triple which holds all 4
+  const int subsets[][3] = { {0,1,NO_INDEX}, {0,2,NO_INDEX}, {0,3,NO_INDEX}, {1,2,NO_INDEX}, {1,3,NO_INDEX}, {2,3,NO_INDEX}, {0,1,2}, {0,1,3}, {0,2,3}, {1,2,3} };
+  outSphere[3] = DBL_MAX;
+  for (int i = 0; i < 10; i++) {
+    const int* subset = subsets[i];
+    double candidate[4];
+    if (subset[2] == NO_INDEX) {
+      calcDiametralSphere(candidate, points[subset[0]], points[subset[1]]);
+    } else {
+      calcCircumsphere3(candidate, points[subset[0]], points[subset[1]], points[subset[2]]);
+    }
+
+    if (candidate[3] < outSphere[3] && isInSphere(candidate, a) && isInSphere(candidate, b) && isInSphere(candidate, c) && isInSphere(candidate, d)) {
+      memcpy(outSphere, candidate, sizeof(candidate));
+    }
+  }
+}
+
+// writes the smallest sphere around the hull's vertices to outSphere as center (3 floats) and radius, see
+// above. vertices are the ones the triangles were built from, and indices are offsets into them. Returns 0, -1
+// if there are no triangles, or -3 if out of memory
+EMSCRIPTEN_KEEPALIVE
+int calcHullBoundingSphere(float* outSphere, const float* vertices, const int* indices, const int numIndices) {
+  if (numIndices < POINTS_PER_FACE) {
+    return -1;
+  }
+
+  int* offsets = malloc(numIndices*sizeof(int));
+  if (offsets == NULL) {
+    return -3;
+  }
+
+  const int numVertices = collectHullVertices(offsets, indices, numIndices);
+  uint32_t random = 0x9e3779b9u;
+  for (int i = numVertices - 1; i > 0; i--) {
+    random ^= random << 13, random ^= random >> 17, random ^= random << 5; // xorshift32
+    const int j = random % (i + 1);
+    const int offset = offsets[i];
+    offsets[i] = offsets[j];
+    offsets[j] = offset;
+  }
+
+  double sphere[4];
+  calcDiametralSphere(sphere, vertices + offsets[0], vertices + offsets[0]);
+
+  for (int i = 1; i < numVertices; i++) {
+    const float* p = vertices + offsets[i];
+    if (isInSphere(sphere, p)) {
+      continue;
+    }
+
+    calcDiametralSphere(sphere, p, p);
+    for (int j = 0; j < i; j++) {
+      const float* q = vertices + offsets[j];
+      if (isInSphere(sphere, q)) {
+        continue;
+      }
+
+      calcDiametralSphere(sphere, p, q);
+      for (int k = 0; k < j; k++) {
+        const float* r = vertices + offsets[k];
+        if (isInSphere(sphere, r)) {
+          continue;
+        }
+
+        calcCircumsphere3(sphere, p, q, r);
+        for (int l = 0; l < k; l++) {
+          if (!isInSphere(sphere, vertices + offsets[l])) {
+            calcCircumsphere4(sphere, p, q, r, vertices + offsets[l]);
+          }
+        }
+      }
+    }
+  }
+
+  // measure the radius in floats, so every vertex is inside
+  float maxDistanceSq = 0.f;
+  for (int k = 0; k < 3; k++) {
+    outSphere[k] = (float)sphere[k];
+  }
+  for (int i = 0; i < numVertices; i++) {
+    float offset[3];
+    sub(offset, vertices + offsets[i], outSphere);
+    maxDistanceSq = fmaxf(maxDistanceSq, dot(offset, offset));
+  }
+  outSphere[3] = sqrtf(maxDistanceSq);
+
+  free(offsets);
+  return 0;
+}
+
+// Thread pool
+// runHullTasks() calls fn(user, task, thread) for every task in [0, numTasks), spread over the pool's threads.
+// The calling thread takes part as thread 0, and each thread has its own HullContext for scratch memory.
+// Threads are only used when built with HULL_THREADS (native, link with -pthread) or Emscripten's -pthread,
+// otherwise every task runs on the calling thread.
+
+typedef void (*HullTaskFn)(void* user, const int task, const int thread);
+
+typedef struct HullThreadPool {
+  int numThreads;
+  HullContext** contexts; // one per thread
+
+#ifdef HULL_USE_THREADS
+  pthread_t* threads; // numThreads - 1 workers, the caller is thread 0
+  int numWorkers; // workers started
+  pthread_mutex_t mutex;
+  pthread_cond_t wake;
+  pthread_cond_t done;
+  HullTaskFn fn;
+  void* user;
+  int numTasks;
+  int nextTask;
+  int numCompleted;
+  int generation; // incremented for each call to runHullTasks()
+  bool quit;
+#endif
+} HullThreadPool;
+
+#ifdef HULL_USE_THREADS
+typedef struct {
+  HullThreadPool* pool;
+  int thread;
+} HullWorker;
+
+// must be called with the mutex locked, and returns with it locked
+void runAvailableTasks(HullThreadPool* pool, const int thread) {
+  while (pool->nextTask < pool->numTasks) {
+    const int task = pool->nextTask++;
+
+    pthread_mutex_unlock(&pool->mutex);
+    pool->fn(pool->user, task, thread);
+    pthread_mutex_lock(&pool->mutex);
+
+    if (++pool->numCompleted == pool->numTasks) {
+      pthread_cond_broadcast(&pool->done);
+    }
+  }
+}
+
+void* hullWorkerMain(void* data) {
+  HullWorker* worker = data;
+  HullThreadPool* pool = worker->pool;
+  int generation = 0;
+
+  pthread_mutex_lock(&pool->mutex);
+
+  for (;;) {
+    while (!pool->quit && pool->generation == generation) {
+      pthread_cond_wait(&pool->wake, &pool->mutex);
+    }
+
+    if (pool->quit) {
+      break;
+    }
+
+    generation = pool->generation;
+    runAvailableTasks(pool, worker->thread);
+  }
+
+  pthread_mutex_unlock(&pool->mutex);
+  free(worker);
+  return NULL;
+}
+#endif
+
+EMSCRIPTEN_KEEPALIVE
+void hullThreadPoolDestroy(HullThreadPool* pool) {
+  if (pool == NULL) {
+    return;
+  }
+
+#ifdef HULL_USE_THREADS
+  if (pool->threads) {
+    pthread_mutex_lock(&pool->mutex);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < pool->numWorkers; i++) {
+      pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->done);
+    free(pool->threads);
+  }
+#endif
+
+  if (pool->contexts) {
+    for (int i = 0; i < pool->numThreads; i++) {
+      hullContextDestroy(pool->contexts[i]);
+    }
+  }
+
+  free(pool->contexts);
+  free(pool);
+}
+
+// numThreads includes the calling thread, and is 1 when threads are not available. Returns NULL if out of
+// memory, or if the threads could not be started
+EMSCRIPTEN_KEEPALIVE
+HullThreadPool* hullThreadPoolCreate(const int numThreads) {
+  HullThreadPool* pool = calloc(1, sizeof(HullThreadPool));
+  if (pool == NULL) {
+    return NULL;
+  }
+
+#ifdef HULL_USE_THREADS
+  pool->numThreads = numThreads < 1 ? 1 : numThreads;
+#else
+  (void)numThreads;
+  pool->numThreads = 1;
+#endif
+
+  pool->contexts = calloc(pool->numThreads, sizeof(HullContext*));
+  if (pool->contexts == NULL) {
+    hullThreadPoolDestroy(pool);
+    return NULL;
+  }
+
+  for (int i = 0; i < pool->numThreads; i++) {
+    pool->contexts[i] = hullContextCreate(0, 0);
+    if (pool->contexts[i] == NULL) {
+      hullThreadPoolDestroy(pool);
+      return NULL;
+    }
+  }
+
+#ifdef HULL_USE_THREADS
+  const int numWorkers = pool->numThreads - 1;
+  pool->threads = calloc(numWorkers > 0 ? numWorkers : 1, sizeof(pthread_t));
+  if (pool->threads == NULL) {
+    hullThreadPoolDestroy(pool);
+    return NULL;
+  }
+
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->wake, NULL);
+  pthread_cond_init(&pool->done, NULL);
+
+  for (int i = 0; i < numWorkers; i++) {
+    HullWorker* worker = malloc(sizeof(HullWorker));
+    if (worker != NULL) {
+      worker->pool = pool;
+      worker->thread = i + 1;
+    }
+
+    if (worker == NULL || pthread_create(&pool->threads[i], NULL, hullWorkerMain, worker) != 0) {
+      free(worker);
+      pool->numWorkers = i; // only join the workers which started
+      hullThreadPoolDestroy(pool);
+      return NULL;
+    }
+  }
+
+  pool->numWorkers = numWorkers;
+#endif
+
+  return pool;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int hullThreadPoolSize(const HullThreadPool* pool) {
+  return pool->numThreads;
+}
+
+// blocks until fn has been called for every task
+void runHullTasks(HullThreadPool* pool, HullTaskFn fn, void* user, const int numTasks) {
+#ifdef HULL_USE_THREADS
+  if (pool->numThreads > 1) {
+    pthread_mutex_lock(&pool->mutex);
+    pool->fn = fn;
+    pool->user = user;
+    pool->numTasks = numTasks;
+    pool->nextTask = 0;
+    pool->numCompleted = 0;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+
+    runAvailableTasks(pool, 0);
+
+    while (pool->numCompleted < pool->numTasks) {
+      pthread_cond_wait(&pool->done, &pool->mutex);
+    }
+
+    pthread_mutex_unlock(&pool->mutex);
+    return;
+  }
+#else
+  (void)pool;
+#endif
+
+  for (int task = 0; task < numTasks; task++) {
+    fn(user, task, 0);
+  }
+}
+
+
+// Parallel hull
+// The points are split into one partition per thread and each partition is hulled concurrently. Only the hull
+// vertices of the partitions can be on the final hull, so the final hull is built from just those vertices.
+
+#define MIN_PARTITION_POINTS (4096)
+
+typedef struct {
+  HullThreadPool* pool;
+  const float* vertices;
+  int stride;
+  int flags;
+  int numPoints;
+  int numPartitions;
+  int* candidates; // the hull vertices of partition p start at the index of its first point
+  int* numCandidates; // per partition
+} PartitionHulls;
+
+void buildPartitionHull(void* user, const int partition, const int thread) {
+  PartitionHulls* partitions = user;
+  HullContext* ctx = partitions->pool->contexts[thread];
+  const int stride = partitions->stride;
+  const int firstPoint = (int)( (long long)partitions->numPoints*partition/partitions->numPartitions );
+  const int lastPoint = (int)( (long long)partitions->numPoints*(partition + 1)/partitions->numPartitions );
+  const int offset = firstPoint*stride;
+  int* candidates = partitions->candidates + firstPoint;
+  int numCandidates = 0;
+
+  hullContextSetFlags(ctx, partitions->flags);
+
+  if (buildQuickHull(ctx, partitions->vertices + offset, (lastPoint - firstPoint)*stride, stride) > 0) {
+    numCandidates = writeHullVertices(ctx, candidates);
+    for (int i = 0; i < numCandidates; i++) {
+      candidates[i] += offset;
+    }
+  } else {
+    // too few points, coplanar or out of memory, so keep every point for the final hull
+    for (int i = firstPoint; i < lastPoint; i++) {
+      candidates[numCandidates++] = i*stride;
+    }
+  }
+
+  partitions->numCandidates[partition] = numCandidates;
+}
+
+// same as generateHullTrianglesWithContext(), but the work is spread over the threads of the pool. ctx is used
+// for the final merge and the pool's contexts for the partitions, with the flags of ctx. The result has the same
+// vertices as the serial build, though the triangles may differ where faces are coplanar
+EMSCRIPTEN_KEEPALIVE
+int generateHullTrianglesParallel(HullThreadPool* pool, HullContext* ctx, int* outIndices, const float* vertices, const int numVertices, const int stride) {
+  const int numPoints = numVertices/stride;
+  int numPartitions = numPoints/MIN_PARTITION_POINTS;
+  numPartitions = numPartitions > pool->numThreads ? pool->numThreads : numPartitions;
+
+  if (numPartitions <= 1) {
+    return generateHullTrianglesWithContext(ctx, outIndices, vertices, numVertices, stride);
+  }
+
+  // the candidates of each partition, then the number of them
+  if (!reserveScratch(ctx, numPoints + numPartitions)) {
+    return -3; // out of memory
+  }
+
+  int* partitionCounts = ctx->scratchIndices + numPoints;
+  PartitionHulls partitions = { pool, vertices, stride, ctx->flags, numPoints, numPartitions, ctx->scratchIndices, partitionCounts };
+  runHullTasks(pool, buildPartitionHull, &partitions, numPartitions);
+
+  // pack the candidates and their positions, then hull them
+  int numCandidates = 0;
+  for (int partition = 0; partition < numPartitions; partition++) {
+    const int firstPoint = (int)( (long long)numPoints*partition/numPartitions );
+
+    for (int i = 0; i < partitionCounts[partition]; i++) {
+      const int vertex = ctx->scratchIndices[firstPoint + i];
+      ctx->scratchIndices[numCandidates] = vertex;
+      memcpy(ctx->scratchVertices + numCandidates*FLOATS_PER_VERTEX, vertices + vertex, FLOATS_PER_VERTEX*sizeof(float));
+      numCandidates++;
+    }
+  }
+
+  const int result = generateHullTrianglesWithContext(ctx, outIndices, ctx->scratchVertices, numCandidates*FLOATS_PER_VERTEX, FLOATS_PER_VERTEX);
+
+  // remap from the packed candidates to the original vertices
+  for (int i = 0; i < result; i++) {
+    outIndices[i] = ctx->scratchIndices[outIndices[i]/FLOATS_PER_VERTEX];
+  }
+
+  return result;
+}
+
+
+// Welding
+// Scanned points are often duplicated, or jittered by much less than the detail that matters, and every one of
+// them is tested against the hull while the near duplicates make sliver faces. Welding snaps each point to a
+// grid of cellSize and keeps only the first point in each cell, in one pass over the strided input with an open
+// addressing hash table of the cells. The table holds the offset of each cell's point, and the cell of a table
+// entry is recalculated from that point rather than stored. A cellSize of 0 only welds identical points.
+
+#define MAX_WELD_CELL (4611686018427387904.) // 2^62, cell coordinates are clamped to stay well inside int64_t
+
+// the grid cell of the point, or its exact coordinates if invCellSize is 0
+void calcWeldCell(int64_t* outCell, const float* point, const double invCellSize) {
+  for (int axis = 0; axis < FLOATS_PER_VERTEX; axis++) {
+    if (invCellSize > 0.) {
+      const double cell = floor(point[axis]*invCellSize);
+      outCell[axis] = (int64_t)(cell > MAX_WELD_CELL ? MAX_WELD_CELL : cell < -MAX_WELD_CELL ? -MAX_WELD_CELL : cell);
+    } else {
+      const float value = point[axis] + 0.f; // -0 and 0 are the same point
+      int32_t bits = 0;
+      memcpy(&bits, &value, sizeof(bits));
+      outCell[axis] = bits;
+    }
+  }
+}
+
+uint64_t hashWeldCell(const int64_t* cell) {
+  uint64_t hash = (uint64_t)cell[0]*0x9E3779B97F4A7C15ull ^ (uint64_t)cell[1]*0xC2B2AE3D27D4EB4Full ^ (uint64_t)cell[2]*0x165667B19E3779F9ull;
+  return hash ^ (hash >> 29);
+}
+
+// the table has a power of 2 entries, at least twice numPoints so the probes stay short. Returns the number of
+// entries, or 0 if out of memory
+int reserveWeldTable(HullContext* ctx, const int numPoints) {
+  int size = 64;
+  while (size < 2*numPoints) {
+    size *= 2;
+  }
+
+  if (size > ctx->weldTableCapacity) {
+    if (!resizeBuffer((void**)&ctx->weldTable, size*sizeof(int))) {
+      return 0;
+    }
+    ctx->weldTableCapacity = size;
+  }
+
+  return size;
+}
+
+// writes the offset of the first point in each occupied cell of a grid of cellSize to outIndices (room for one per
+// point), in the order of the points. Returns the number of points kept, or -3 if out of memory
+EMSCRIPTEN_KEEPALIVE
+int weldPoints(HullContext* ctx, int* outIndices, const float* vertices, const int numVertices, const int stride, const float cellSize) {
+  const int tableSize = reserveWeldTable(ctx, (numVertices + stride - 1)/stride);
+  if (tableSize == 0) {
+    return -3; // out of memory
+  }
+
+  const double invCellSize = cellSize > 0.f ? 1./cellSize : 0.;
+  const uint64_t mask = (uint64_t)tableSize - 1;
+  int64_t cell[FLOATS_PER_VERTEX];
+  int64_t otherCell[FLOATS_PER_VERTEX];
+  int numKept = 0;
+
+  for (int i = 0; i < tableSize; i++) {
+    ctx->weldTable[i] = NO_INDEX;
+  }
+
+  for (int i = 0; i < numVertices; i += stride) {
+    calcWeldCell(cell, vertices + i, invCellSize);
+
+    // linear probing until the cell or an empty entry is found
+    uint64_t slot = hashWeldCell(cell) & mask;
+    for ( ; ctx->weldTable[slot] != NO_INDEX; slot = (slot + 1) & mask) {
+      calcWeldCell(otherCell, vertices + ctx->weldTable[slot], invCellSize);
+      if (memcmp(cell, otherCell, sizeof(cell)) == 0) {
+        break;
+      }
+    }
+
+    if (ctx->weldTable[slot] == NO_INDEX) {
+      ctx->weldTable[slot] = i;
+      outIndices[numKept++] = i;
+    }
+  }
+
+  return numKept;
+}
+
+// same as generateHullTrianglesWithContext(), but the points are welded to a grid of cellSize first (see
+// weldPoints()), so the hull only uses the first point in each cell. The indices are offsets into vertices
+EMSCRIPTEN_KEEPALIVE
+int generateHullTrianglesWelded(HullContext* ctx, int* outIndices, const float* vertices, const int numVertices, const int stride, const float cellSize) {
+  const int numPoints = (numVertices + stride - 1)/stride;
+  if (!reserveScratch(ctx, numPoints)) {
+    return -3; // out of memory
+  }
+
+  const int numKept = weldPoints(ctx, ctx->scratchIndices, vertices, numVertices, stride, cellSize);
+  if (numKept < 0) {
+    return numKept;
+  }
+
+  for (int i = 0; i < numKept; i++) {
+    memcpy(ctx->scratchVertices + i*FLOATS_PER_VERTEX, vertices + ctx->scratchIndices[i], FLOATS_PER_VERTEX*sizeof(float));
+  }
+
+  const int result = generateHullTrianglesWithContext(ctx, outIndices, ctx->scratchVertices, numKept*FLOATS_PER_VERTEX, FLOATS_PER_VERTEX);
+
+  // remap from the packed points to the original vertices
+  for (int i = 0; i < result; i++) {
+    outIndices[i] = ctx->scratchIndices[outIndices[i]/FLOATS_PER_VERTEX];
+  }
+
+  return result;
+}
+
+// Batch
+// Builds the hulls of many meshes in one call, one task per mesh on the thread pool. The meshes share a packed
+// vertex buffer, and meshTable holds (first vertex, number of vertices) per mesh, both as float offsets.
+
+typedef struct {
+  HullThreadPool* pool;
+  int* outIndices;
+  int* outResults;
+  const float* vertices;
+  const int* meshTable;
+  int stride;
+  int flags;
+} BatchHulls;
+
+// space for the worst case hull of the mesh, see generateHullTrianglesWithContext()
+int calcMaxHullIndices(const int numVertices, const int stride) {
+  const int numPoints = numVertices/stride;
+  return numPoints < 4 ? 0 : POINTS_PER_FACE*(2*numPoints - 4);
+}
+
+void buildBatchHull(void* user, const int mesh, const int thread) {
+  BatchHulls* batch = user;
+  HullContext* ctx = batch->pool->contexts[thread];
+  const int firstVertex = batch->meshTable[mesh*2];
+  const int numVertices = batch->meshTable[mesh*2 + 1];
+
+  hullContextSetFlags(ctx, batch->flags);
+  batch->outResults[mesh*2 + 1] = generateHullTrianglesWithContext(ctx, batch->outIndices + batch->outResults[mesh*2], batch->vertices + firstVertex, numVertices, batch->stride);
+}
+
+// returns the number of indices needed in the outIndices of generateHullTrianglesBatch()
+EMSCRIPTEN_KEEPALIVE
+int calcBatchIndexCapacity(const int* meshTable, const int numMeshes, const int stride) {
+  int capacity = 0;
+  for (int mesh = 0; mesh < numMeshes; mesh++) {
+    capacity += calcMaxHullIndices(meshTable[mesh*2 + 1], stride);
+  }
+  return capacity;
+}
+
+// builds the hull of each mesh in meshTable, using flags (e.g. HULL_CULL_INTERIOR) for every mesh. The hulls are
+// packed one after the other into outIndices, which must hold calcBatchIndexCapacity() indices, and the indices
+// of each hull are relative to the first vertex of its mesh. outResults holds (first index, number of indices) per
+// mesh, where the number of indices is the same as the result of generateHullTriangles() for that mesh (so
+// negative on error, and then the mesh has no indices). Returns the total number of indices written
+EMSCRIPTEN_KEEPALIVE
+int generateHullTrianglesBatch(HullThreadPool* pool, int* outIndices, int* outResults, const float* vertices, const int* meshTable, const int numMeshes, const int stride, const int flags) {
+  // each mesh writes to its own worst case region, then the results are packed down
+  int capacity = 0;
+  for (int mesh = 0; mesh < numMeshes; mesh++) {
+    outResults[mesh*2] = capacity;
+    capacity += calcMaxHullIndices(meshTable[mesh*2 + 1], stride);
+  }
+
+  BatchHulls batch = { pool, outIndices, outResults, vertices, meshTable, stride, flags };
+  runHullTasks(pool, buildBatchHull, &batch, numMeshes);
+
+  int numIndices = 0;
+  for (int mesh = 0; mesh < numMeshes; mesh++) {
+    const int count = outResults[mesh*2 + 1] > 0 ? outResults[mesh*2 + 1] : 0;
+    if (count > 0 && outResults[mesh*2] != numIndices) {
+      memmove(outIndices + numIndices, outIndices + outResults[mesh*2], count*sizeof(int));
+    }
+
+    outResults[mesh*2] = numIndices;
+    numIndices += count;
+  }
+
+  return numIndices;
+}
+
+
+// Incremental hull
+// A Hull keeps its own copy of every point inserted, and once the first solid hull is built, each insert only
+// assigns the new points to outside sets and expands the faces they are outside of. Points inside the current
+// hull are never looked at again. While every point is coplanar each insert rebuilds the planar hull. Triangle
+// indices are offsets into hullGetVertices(), FLOATS_PER_VERTEX per point in insertion order.
+//
+// hullCompact() drops the points inside the hull, so a stream of points larger than memory can be hulled a
+// chunk at a time, holding only the hull vertices and the current chunk.
+
+#define MAX_INSERT_TESTS_PER_POINT (256) // inserts with more plane tests than this per point held are rebuilt instead
+
+typedef struct Hull {
+  HullContext* ctx;
+  float* vertices;
+  int numVertices;
+  int vertexCapacity; // floats
+  float maxCoord; // for the plane errors, which grow with the points
+  int result; // result of the last insert, the hull exists once this is positive
+} Hull;
+
+EMSCRIPTEN_KEEPALIVE
+void hullDestroy(Hull* hull) {
+  if (hull == NULL) {
+    return;
+  }
+
+  hullContextDestroy(hull->ctx);
+  free(hull->vertices);
+  free(hull);
+}
+
+// flags are the same as hullContextSetFlags(). Returns NULL if out of memory
+EMSCRIPTEN_KEEPALIVE
+Hull* hullCreate(const int flags) {
+  Hull* hull = calloc(1, sizeof(Hull));
+  if (hull == NULL) {
+    return NULL;
+  }
+
+  hull->ctx = hullContextCreate(0, 0);
+  if (hull->ctx == NULL) {
+    hullDestroy(hull);
+    return NULL;
+  }
+
+  hullContextSetFlags(hull->ctx, flags);
+  hull->result = -1; // not enough vertices
+  return hull;
+}
+
+// adds the points from firstVertex onwards to the existing hull
+bool insertIntoHull(Hull* hull, const int firstVertex) {
+  HullContext* ctx = hull->ctx;
+  const int numPoints = hull->numVertices/FLOATS_PER_VERTEX;
+
+  ctx->vertices = hull->vertices;
+  ctx->numVertices = hull->numVertices;
+
+  if (!reservePoints(ctx, numPoints)) {
+    return false;
+  }
+
+  // the new points can be farther from the origin than the ones the plane errors were calculated for
+  if (hull->maxCoord > ctx->maxCoord) {
+    ctx->maxCoord = hull->maxCoord;
+
+    for (int face = 0; face < ctx->numFaces; face++) {
+      const int* indices = ctx->faceIndices + face*POINTS_PER_FACE;
+      if (indices[0] != NO_INDEX) {
+        ctx->planeErrors[face] = calcPlaneError(hull->vertices + indices[0], hull->vertices + indices[1], hull->vertices + indices[2], ctx->maxCoord);
+      }
+    }
+  }
+
+  const int numFaces = gatherLiveFaces(ctx);
+
+  for (int i = firstVertex; i < hull->numVertices; i += FLOATS_PER_VERTEX) {
+    assignToOutsideSet(ctx, numFaces, i);
+  }
+
+  return expandPendingFaces(ctx);
+}
+
+// adds the points to the hull. Returns the number of triangles in the hull, or (like generateHullTriangles())
+// -1 if there are not enough points yet, -2 if all the points so far are collinear and -3 if out of memory, in
+// which case the hull should be destroyed
+EMSCRIPTEN_KEEPALIVE
+int hullInsertPoints(Hull* hull, const float* vertices, const int numVertices, const int stride) {
+  const int numPoints = numVertices/stride;
+  const int firstVertex = hull->numVertices;
+  const int numHullVertices = firstVertex + numPoints*FLOATS_PER_VERTEX;
+
+  if (numHullVertices > hull->vertexCapacity) {
+    int capacity = hull->vertexCapacity < 64*FLOATS_PER_VERTEX ? 64*FLOATS_PER_VERTEX : hull->vertexCapacity;
+    while (capacity < numHullVertices) {
+      capacity *= 2;
+    }
+
+    if (!resizeBuffer((void**)&hull->vertices, capacity*sizeof(float))) {
+      return hull->result = -3; // out of memory
+    }
+
+    hull->vertexCapacity = capacity;
+  }
+
+  for (int i = 0; i < numPoints; i++) {
+    memcpy(hull->vertices + firstVertex + i*FLOATS_PER_VERTEX, vertices + i*stride, FLOATS_PER_VERTEX*sizeof(float));
+  }
+
+  hull->numVertices = numHullVertices;
+  hull->maxCoord = growMaxCoord(hull->maxCoord, hull->vertices + firstVertex, numPoints*FLOATS_PER_VERTEX, FLOATS_PER_VERTEX);
+
+  // each new point is tested against every face, so a large insert into a large hull is quicker to rebuild
+  const long long numInsertTests = (long long)numPoints*hull->ctx->numLiveFaces;
+  const bool isRebuildQuicker = numInsertTests > (long long)MAX_INSERT_TESTS_PER_POINT*(numHullVertices/FLOATS_PER_VERTEX);
+
+  if (hull->result > 0 && !hull->ctx->isPlanar && !isRebuildQuicker) {
+    hull->result = insertIntoHull(hull, firstVertex) ? hull->ctx->numLiveFaces : -3;
+  } else if (hull->result != -3) {
+    // no hull yet, a planar hull which may miss new points in its plane, or a large insert, so build from
+    // everything so far
+    hull->result = buildQuickHull(hull->ctx, hull->vertices, hull->numVertices, FLOATS_PER_VERTEX);
+  }
+
+  return hull->result;
+}
+
+// the number of indices hullGetTriangles() will write, 0 if there is no hull yet
+EMSCRIPTEN_KEEPALIVE
+int hullNumIndices(const Hull* hull) {
+  return hull->result > 0 ? hull->ctx->numLiveFaces*POINTS_PER_FACE : 0;
+}
+
+// writes the triangles of the current hull. Returns the number of indices written
+EMSCRIPTEN_KEEPALIVE
+int hullGetTriangles(const Hull* hull, int* outIndices) {
+  return hull->result > 0 ? writeHullTriangles(hull->ctx, outIndices) : 0;
+}
+
+// every point inserted so far, FLOATS_PER_VERTEX floats per point. Only valid until the next insert
+EMSCRIPTEN_KEEPALIVE
+const float* hullGetVertices(const Hull* hull) {
+  return hull->vertices;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int hullNumVertices(const Hull* hull) {
+  return hull->numVertices;
+}
+
+// drops every point which is not a vertex of the current hull, so a stream of inserts only holds the hull and
+// the latest points. While the points are collinear only the two ends of the line are kept. The triangles
+// are renumbered to match, but keep the same order. Returns the number of points kept
+EMSCRIPTEN_KEEPALIVE
+int hullCompact(Hull* hull) {
+  HullContext* ctx = hull->ctx;
+  const int numPoints = hull->numVertices/FLOATS_PER_VERTEX;
+
+  if (hull->result == -1 || hull->result == -3 || !reservePoints(ctx, numPoints)) {
+    return numPoints;
+  }
+
+  int* keep = ctx->pointNext; // the outside sets are all empty between inserts
+  for (int i = 0; i < numPoints; i++) {
+    keep[i] = NO_INDEX;
+  }
+
+  if (hull->result > 0) {
+    for (int i = 0; i < ctx->numFaces*POINTS_PER_FACE; i++) {
+      if (ctx->faceIndices[i - i % POINTS_PER_FACE] != NO_INDEX) {
+        keep[ctx->faceIndices[i]/FLOATS_PER_VERTEX] = 0;
+      }
+    }
+  } else {
+    // the segment between the extremes of the widest axis holds every other point
+    int lo = 0, hi = 0;
+    float extent = -1.f;
+    for (int axis = 0; axis < 3; axis++) {
+      int axisLo = 0, axisHi = 0;
+      for (int i = 1; i < numPoints; i++) {
+        const float x = hull->vertices[i*FLOATS_PER_VERTEX + axis];
+        axisLo = x < hull->vertices[axisLo*FLOATS_PER_VERTEX + axis] ? i : axisLo;
+        axisHi = x > hull->vertices[axisHi*FLOATS_PER_VERTEX + axis] ? i : axisHi;
+      }
+
+      const float axisExtent = hull->vertices[axisHi*FLOATS_PER_VERTEX + axis] - hull->vertices[axisLo*FLOATS_PER_VERTEX + axis];
+      if (axisExtent > extent) {
+        lo = axisLo, hi = axisHi, extent = axisExtent;
+      }
+    }
+
+    keep[lo] = keep[hi] = 0;
+  }
+
+  // in order, so each point moves down over points which are already done
+  int numKept = 0;
+  for (int i = 0; i < numPoints; i++) {
+    if (keep[i] != NO_INDEX) {
+      memmove(hull->vertices + numKept*FLOATS_PER_VERTEX, hull->vertices + i*FLOATS_PER_VERTEX, FLOATS_PER_VERTEX*sizeof(float));
+      keep[i] = numKept++*FLOATS_PER_VERTEX;
+    }
+  }
+
+  if (hull->result > 0) {
+    for (int i = 0; i < ctx->numFaces*POINTS_PER_FACE; i++) {
+      if (ctx->faceIndices[i - i % POINTS_PER_FACE] != NO_INDEX) {
+        ctx->faceIndices[i] = keep[ctx->faceIndices[i]/FLOATS_PER_VERTEX];
+      }
+    }
+  }
+
+  hull->numVertices = numKept*FLOATS_PER_VERTEX;
+  ctx->numVertices = hull->numVertices;
+  return numKept;
+}
+
+
+// Hull cache
+// Instanced meshes give the same vertices over and over, so a HullCache keeps the triangles of recent builds,
+// keyed by a hash of the vertex bytes, the stride and the context flags. The hash is XXH64, whose four lanes
+// are independent so each 32 byte stripe keeps several multipliers busy. Once the cache holds more than
+// maxBytes, the least recently used entries are dropped. The inputs are not kept, so two inputs with the same
+// 64 bit hash would share a hull. Only the flags which change the triangles (HULL_OUTPUT_FLAGS) are part of
+// the key, so e.g. collecting stats still hits.
+//
+// A serialized cache is a little-endian header (HULL_CACHE_MAGIC, HULL_CACHE_VERSION, number of entries)
+// followed by each entry from the least to the most recently used: the key as two uint32s (low first),
+// numVertices, stride, flags, result, then the indices if the result is positive, all as 32 bit ints. Loading
+// skips entries which could not come from a build, e.g. with more indices than calcMaxHullIndices() or indices
+// which are not offsets of vertices, so a corrupt cache can't make a hit write or point past the buffers.
+
+#define HULL_CACHE_MAGIC (0x434c5548) // "HULC"
+#define HULL_CACHE_VERSION (1)
+#define HULL_CACHE_HEADER_INTS (3)
+#define HULL_CACHE_ENTRY_INTS (6)
+#define MIN_CACHE_BUCKETS (64)
+#define HULL_OUTPUT_FLAGS (HULL_CULL_INTERIOR) // the context flags which change the triangles
+
+#define XXH_PRIME64_1 (0x9E3779B185EBCA87ull)
+#define XXH_PRIME64_2 (0xC2B2AE3D27D4EB4Full)
+#define XXH_PRIME64_3 (0x165667B19E3779F9ull)
+#define XXH_PRIME64_4 (0x85EBCA77C2B2AE63ull)
+#define XXH_PRIME64_5 (0x27D4EB2F165667C5ull)
+
+typedef struct {
+  uint64_t key;
+  int numVertices;
+  int stride;
+  int flags;
+  int result; // number of indices, or the negative result of the build
+  int* indices;
+  int next; // next entry in the same bucket
+  int newer, older; // neighbours in the order of use, NO_INDEX at the ends
+} HullCacheEntry;
+
+typedef struct HullCache {
+  HullCacheEntry* entries; // packed, numEntries of entryCapacity
+  int numEntries;
+  int entryCapacity;
+  int* buckets; // first entry in each bucket, NO_INDEX if empty
+  int numBuckets; // power of 2
+  size_t numBytes; // entries and indices held
+  size_t maxBytes;
+  int newest, oldest; // ends of the list of entries in the order of use, NO_INDEX if empty
+  int hits;
+  int misses;
+} HullCache;
+
+uint64_t rotateLeft64(const uint64_t x, const int bits) {
+  return (x << bits) | (x >> (64 - bits));
+}
+
+uint64_t read64(const uint8_t* bytes) {
+  uint64_t x;
+  memcpy(&x, bytes, sizeof(x));
+  return x;
+}
+
+uint32_t read32(const uint8_t* bytes) {
+  uint32_t x;
+  memcpy(&x, bytes, sizeof(x));
+  return x;
+}
+
+uint64_t xxh64Round(uint64_t acc, const uint64_t input) {
+  acc += input*XXH_PRIME64_2;
+  return rotateLeft64(acc, 31)*XXH_PRIME64_1;
+}
+
+uint64_t xxh64MergeRound(uint64_t acc, const uint64_t lane) {
+  acc ^= xxh64Round(0, lane);
+  return acc*XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+// XXH64 of numBytes, reading the bytes as little-endian
+uint64_t xxh64(const void* data, const size_t numBytes, const uint64_t seed) {
+  const uint8_t* p = data;
+  const uint8_t* end = p + numBytes;
+  uint64_t h;
+
+  if (numBytes >= 32) {
+    uint64_t v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+    uint64_t v2 = seed + XXH_PRIME64_2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - XXH_PRIME64_1;
+
+    for (; p + 32 <= end; p += 32) {
+      v1 = xxh64Round(v1, read64(p));
+      v2 = xxh64Round(v2, read64(p + 8));
+      v3 = xxh64Round(v3, read64(p + 16));
+      v4 = xxh64Round(v4, read64(p + 24));
+    }
+
+    h = rotateLeft64(v1, 1) + rotateLeft64(v2, 7) + rotateLeft64(v3, 12) + rotateLeft64(v4, 18);
+    h = xxh64MergeRound(h, v1);
+    h = xxh64MergeRound(h, v2);
+    h = xxh64MergeRound(h, v3);
+    h = xxh64MergeRound(h, v4);
+  } else {
+    h = seed + XXH_PRIME64_5;
+  }
+
+  h += numBytes;
+
+  for (; p + 8 <= end; p += 8) {
+    h ^= xxh64Round(0, read64(p));
+    h = rotateLeft64(h, 27)*XXH_PRIME64_1 + XXH_PRIME64_4;
+  }
+
+  if (p + 4 <= end) {
+    h ^= read32(p)*XXH_PRIME64_1;
+    h = rotateLeft64(h, 23)*XXH_PRIME64_2 + XXH_PRIME64_3;
+    p += 4;
+  }
+
+  for (; p < end; p++) {
+    h ^= *p*XXH_PRIME64_5;
+    h = rotateLeft64(h, 11)*XXH_PRIME64_1;
+  }
+
+  h ^= h >> 33;
+  h *= XXH_PRIME64_2;
+  h ^= h >> 29;
+  h *= XXH_PRIME64_3;
+  h ^= h >> 32;
+  return h;
+}
+
+size_t calcCacheEntryBytes(const HullCacheEntry* entry) {
+  return sizeof(HullCacheEntry) + (entry->result > 0 ? entry->result*sizeof(int) : 0);
+}
+
+EMSCRIPTEN_KEEPALIVE
+void hullCacheClear(HullCache* cache) {
+  for (int i = 0; i < cache->numEntries; i++) {
+    free(cache->entries[i].indices);
+  }
+
+  for (int i = 0; i < cache->numBuckets; i++) {
+    cache->buckets[i] = NO_INDEX;
+  }
+
+  cache->numEntries = 0;
+  cache->numBytes = 0;
+  cache->newest = cache->oldest = NO_INDEX;
+}
+
+EMSCRIPTEN_KEEPALIVE
+void hullCacheDestroy(HullCache* cache) {
+  if (cache == NULL) {
+    return;
+  }
+
+  hullCacheClear(cache);
+  free(cache->entries);
+  free(cache->buckets);
+  free(cache);
+}
+
+// the cache holds at most maxBytes of entries and indices. Returns NULL if out of memory
+EMSCRIPTEN_KEEPALIVE
+HullCache* hullCacheCreate(const int maxBytes) {
+  HullCache* cache = calloc(1, sizeof(HullCache));
+  if (cache == NULL) {
+    return NULL;
+  }
+
+  cache->buckets = malloc(MIN_CACHE_BUCKETS*sizeof(int));
+  if (cache->buckets == NULL) {
+    hullCacheDestroy(cache);
+    return NULL;
+  }
+
+  cache->numBuckets = MIN_CACHE_BUCKETS;
+  cache->maxBytes = maxBytes > 0 ? maxBytes : 0;
+  hullCacheClear(cache);
+  return cache;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int hullCacheHits(const HullCache* cache) {
+  return cache->hits;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int hullCacheMisses(const HullCache* cache) {
+  return cache->misses;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int hullCacheBytes(const HullCache* cache) {
+  return (int)cache->numBytes;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int hullCacheNumEntries(const HullCache* cache) {
+  return cache->numEntries;
+}
+
+uint64_t calcCacheKey(const float* vertices, const int numVertices, const int stride, const int flags) {
+  return xxh64(vertices, numVertices*sizeof(float), (uint64_t)(uint32_t)stride << 32 | (uint32_t)flags);
+}
+
+// returns the entry, or NO_INDEX
+int findCacheEntry(const HullCache* cache, const uint64_t key, const int numVertices, const int stride, const int flags) {
+  for (int i = cache->buckets[key & (cache->numBuckets - 1)]; i != NO_INDEX; i = cache->entries[i].next) {
+    const HullCacheEntry* entry = cache->entries + i;
+    if (entry->key == key && entry->numVertices == numVertices && entry->stride == stride && entry->flags == flags) {
+      return i;
+    }
+  }
+
+  return NO_INDEX;
+}
+
+void unlinkCacheEntry(HullCache* cache, const int i) {
+  int* link = cache->buckets + (cache->entries[i].key & (cache->numBuckets - 1));
+  while (*link != i) {
+    link = &cache->entries[*link].next;
+  }
+  *link = cache->entries[i].next;
+}
+
+void linkCacheEntry(HullCache* cache, const int i) {
+  int* bucket = cache->buckets + (cache->entries[i].key & (cache->numBuckets - 1));
+  cache->entries[i].next = *bucket;
+  *bucket = i;
+}
+
+// takes the entry out of the order of use
+void detachCacheEntry(HullCache* cache, const int i) {
+  const HullCacheEntry* entry = cache->entries + i;
+  *(entry->newer == NO_INDEX ? &cache->newest : &cache->entries[entry->newer].older) = entry->older;
+  *(entry->older == NO_INDEX ? &cache->oldest : &cache->entries[entry->older].newer) = entry->newer;
+}
+
+// puts the entry first in the order of use
+void attachCacheEntry(HullCache* cache, const int i) {
+  HullCacheEntry* entry = cache->entries + i;
+  entry->newer = NO_INDEX;
+  entry->older = cache->newest;
+  *(cache->newest == NO_INDEX ? &cache->oldest : &cache->entries[cache->newest].newer) = i;
+  cache->newest = i;
+}
+
+// drops the least recently used entries until numBytes more fit
+void evictCacheEntries(HullCache* cache, const size_t numBytes) {
+  while (cache->numEntries > 0 && cache->numBytes + numBytes > cache->maxBytes) {
+    const int oldest = cache->oldest;
+    detachCacheEntry(cache, oldest);
+    unlinkCacheEntry(cache, oldest);
+    cache->numBytes -= calcCacheEntryBytes(cache->entries + oldest);
+    free(cache->entries[oldest].indices);
+
+    // keep the entries packed, and point the neighbours of the moved one at where it went
+    const int last = --cache->numEntries;
+    if (oldest != last) {
+      unlinkCacheEntry(cache, last);
+      cache->entries[oldest] = cache->entries[last];
+      linkCacheEntry(cache, oldest);
+
+      const HullCacheEntry* entry = cache->entries + oldest;
+      *(entry->newer == NO_INDEX ? &cache->newest : &cache->entries[entry->newer].older) = oldest;
+      *(entry->older == NO_INDEX ? &cache->oldest : &cache->entries[entry->older].newer) = oldest;
+    }
+  }
+}
+
+// copies the result into a new entry, evicting old entries to make room. Returns false if it doesn't fit or
+// if out of memory, and the cache is unchanged apart from any evictions
+bool addCacheEntry(HullCache* cache, const uint64_t key, const int numVertices, const int stride, const int flags, const int* indices, const int result) {
+  const HullCacheEntry newEntry = { key, numVertices, stride, flags, result, NULL, NO_INDEX, NO_INDEX, NO_INDEX };
+  const size_t numBytes = calcCacheEntryBytes(&newEntry);
+  if (numBytes > cache->maxBytes) {
+    return false;
+  }
+
+  evictCacheEntries(cache, numBytes);
+
+  if (cache->numEntries >= cache->entryCapacity) {
+    const int capacity = cache->entryCapacity < MIN_CACHE_BUCKETS ? MIN_CACHE_BUCKETS : cache->entryCapacity*2;
+    if (!resizeBuffer((void**)&cache->entries, capacity*sizeof(HullCacheEntry))) {
+      return false;
+    }
+    cache->entryCapacity = capacity;
+  }
+
+  // at most one entry per bucket on average
+  if (cache->numEntries >= cache->numBuckets) {
+    if (!resizeBuffer((void**)&cache->buckets, cache->numBuckets*2*sizeof(int))) {
+      return false;
+    }
+
+    cache->numBuckets *= 2;
+    for (int i = 0; i < cache->numBuckets; i++) {
+      cache->buckets[i] = NO_INDEX;
+    }
+    for (int i = 0; i < cache->numEntries; i++) {
+      linkCacheEntry(cache, i);
+    }
+  }
+
+  HullCacheEntry* entry = cache->entries + cache->numEntries;
+  *entry = newEntry;
+
+  if (result > 0) {
+    entry->indices = malloc(result*sizeof(int));
+    if (entry->indices == NULL) {
+      return false;
+    }
+    memcpy(entry->indices, indices, result*sizeof(int));
+  }
+
+  linkCacheEntry(cache, cache->numEntries);
+  attachCacheEntry(cache, cache->numEntries++);
+  cache->numBytes += numBytes;
+  return true;
+}
+
+// same as generateHullTrianglesWithContext(), but returns a copy of the triangles if the cache already holds
+// the hull of these vertices, stride and context flags, and otherwise builds the hull and adds it to the cache
+EMSCRIPTEN_KEEPALIVE
+int generateHullTrianglesCached(HullCache* cache, HullContext* ctx, int* outIndices, const float* vertices, const int numVertices, const int stride) {
+  const int flags = ctx->flags & HULL_OUTPUT_FLAGS;
+  const uint64_t key = calcCacheKey(vertices, numVertices, stride, flags);
+  const int i = findCacheEntry(cache, key, numVertices, stride, flags);
+
+  if (i != NO_INDEX) {
+    HullCacheEntry* entry = cache->entries + i;
+    if (entry->result > 0) {
+      memcpy(outIndices, entry->indices, entry->result*sizeof(int));
+    }
+    detachCacheEntry(cache, i);
+    attachCacheEntry(cache, i);
+    cache->hits++;
+    return entry->result;
+  }
+
+  cache->misses++;
+  const int result = generateHullTrianglesWithContext(ctx, outIndices, vertices, numVertices, stride);
+  if (result != -3) {
+    addCacheEntry(cache, key, numVertices, stride, flags, outIndices, result);
+  }
+
+  return result;
+}
+
+// the number of bytes hullCacheSerialize() will write
+EMSCRIPTEN_KEEPALIVE
+int hullCacheSerializedBytes(const HullCache* cache) {
+  size_t numInts = HULL_CACHE_HEADER_INTS;
+  for (int i = 0; i < cache->numEntries; i++) {
+    const int result = cache->entries[i].result;
+    numInts += HULL_CACHE_ENTRY_INTS + (result > 0 ? result : 0);
+  }
+
+  return (int)(numInts*sizeof(int32_t));
+}
+
+void writeInt32(uint8_t** p, const int32_t value) {
+  const uint32_t bits = (uint32_t)value;
+  for (int i = 0; i < 4; i++) {
+    *(*p)++ = (uint8_t)(bits >> 8*i);
+  }
+}
+
+int32_t readInt32(const uint8_t** p) {
+  uint32_t bits = 0;
+  for (int i = 0; i < 4; i++) {
+    bits |= (uint32_t)*(*p)++ << 8*i;
+  }
+  return (int32_t)bits;
+}
+
+// writes every entry to outBytes, which must have room for hullCacheSerializedBytes(). Returns the number of
+// bytes written
+EMSCRIPTEN_KEEPALIVE
+int hullCacheSerialize(const HullCache* cache, uint8_t* outBytes) {
+  uint8_t* p = outBytes;
+  writeInt32(&p, HULL_CACHE_MAGIC);
+  writeInt32(&p, HULL_CACHE_VERSION);
+  writeInt32(&p, cache->numEntries);
+
+  // oldest first, so loading them in order gives the same recency
+  for (int i = cache->oldest; i != NO_INDEX; i = cache->entries[i].newer) {
+    const HullCacheEntry* entry = cache->entries + i;
+    writeInt32(&p, (int32_t)(uint32_t)entry->key);
+    writeInt32(&p, (int32_t)(uint32_t)(entry->key >> 32));
+    writeInt32(&p, entry->numVertices);
+    writeInt32(&p, entry->stride);
+    writeInt32(&p, entry->flags);
+    writeInt32(&p, entry->result);
+
+    for (int j = 0; j < entry->result; j++) {
+      writeInt32(&p, entry->indices[j]);
+    }
+  }
+
+  return (int)(p - outBytes);
+}
+
+// true if a build of numVertices floats with this stride and flags could give the result and indices
+bool isValidCacheEntry(const int numVertices, const int stride, const int flags, const int result, const int* indices) {
+  if (numVertices < 0 || stride <= 0 || (flags & ~HULL_OUTPUT_FLAGS) != 0 || result < -2 ||
+      result > calcMaxHullIndices(numVertices, stride) || (result > 0 && result % POINTS_PER_FACE != 0)) {
+    return false;
+  }
+
+  for (int i = 0; i < result; i++) {
+    if (indices[i] < 0 || indices[i] >= numVertices || indices[i] % stride != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// adds the entries of a serialized cache, as the most recently used. Entries which are already in the cache,
+// or which are not valid (see above), are skipped. Returns the number of entries added, -1 if the bytes are not a serialized cache of this version,
+// or -3 if out of memory
+EMSCRIPTEN_KEEPALIVE
+int hullCacheDeserialize(HullCache* cache, const uint8_t* bytes, const int numBytes) {
+  const uint8_t* p = bytes;
+  const uint8_t* end = bytes + numBytes;
+  int numAdded = 0;
+
+  if (numBytes < HULL_CACHE_HEADER_INTS*4 || readInt32(&p) != HULL_CACHE_MAGIC || readInt32(&p) != HULL_CACHE_VERSION) {
+    return -1; // not a serialized cache
+  }
+
+  const int numEntries = readInt32(&p);
+  int* indices = NULL;
+  int indicesCapacity = 0;
+
+  for (int i = 0; i < numEntries; i++) {
+    if (end - p < HULL_CACHE_ENTRY_INTS*4) {
+      free(indices);
+      return -1; // truncated
+    }
+
+    const uint32_t keyLow = (uint32_t)readInt32(&p);
+    const uint64_t key = (uint64_t)(uint32_t)readInt32(&p) << 32 | keyLow;
+    const int numVertices = readInt32(&p);
+    const int stride = readInt32(&p);
+    const int flags = readInt32(&p);
+    const int result = readInt32(&p);
+    const int numIndices = result > 0 ? result : 0;
+
+    if ((end - p)/4 < numIndices) {
+      free(indices);
+      return -1; // truncated
+    }
+
+    if (numIndices > indicesCapacity) {
+      if (!resizeBuffer((void**)&indices, numIndices*sizeof(int))) {
+        free(indices);
+        return -3; // out of memory
+      }
+      indicesCapacity = numIndices;
+    }
+
+    for (int j = 0; j < numIndices; j++) {
+      indices[j] = readInt32(&p);
+    }
+
+    if (isValidCacheEntry(numVertices, stride, flags, result, indices) && findCacheEntry(cache, key, numVertices, stride, flags) == NO_INDEX) {
+      numAdded += addCacheEntry(cache, key, numVertices, stride, flags, indices, result) ? 1 : 0;
+    }
+  }
+
+  free(indices);
+  return numAdded;
+}
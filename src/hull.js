@@ -5,6 +5,8 @@ import * as vertex3 from "./vertex3.js"
  * @typedef {{x: number, y: number, z: number}} VecXYZ
  * @typedef {{x: number, y: number, z: number, w: number}} QuatXYZW
  * @typedef {number[] | Float32Array} Vertices
+ * @typedef {{numPlanes: number, containsPoints: (points: Float32Array) => Uint8Array, raycast: (rays: Float32Array) => {t: Float32Array, faces: Int32Array}, destroy: () => void}} HullQuery
+ * @typedef {{box: {center: Float32Array, axes: Float32Array, halfExtents: Float32Array}, sphere: {center: Float32Array, radius: number}}} HullBounds
  */
 
 export function generateHullTriangles(vertices, stride = 3) {
@@ -143,22 +145,340 @@ export function generateHullTriangles(vertices, stride = 3) {
   return hullFaces.flatMap(face => [face.ai, face.bi, face.ci])
 }
 
-// export const c = hullCModule()
-// const cGenerateHullTriangles = c.cwrap('generateHullTriangles', 'number', ['number', 'array', 'number', 'number'])
+/**
+ * Converts the result of generateHullTriangles() into a compact mesh, with only the hull's vertices in positions
+ * (in the order the triangles first use them) and the triangles as vertex numbers into positions. The indices
+ * are a Uint16Array if there are fewer than 65536 hull vertices, otherwise a Uint32Array
+ * @type {(vertices: Vertices, indices: ArrayLike<number>, stride?: number) => {positions: Float32Array, indices: Uint16Array | Uint32Array}}
+ */
+export function compactHullTriangles(vertices, indices, stride = 3) {
+  /** @type {Map<number, number>} */
+  const remap = new Map()
+
+  for (let i = 0; i < indices.length; i++) {
+    if (!remap.has(indices[i])) {
+      remap.set(indices[i], remap.size)
+    }
+  }
+
+  const positions = new Float32Array(remap.size*3)
+  for (let [offset, vertex] of remap) {
+    positions[vertex*3] = vertices[offset]
+    positions[vertex*3 + 1] = vertices[offset + 1]
+    positions[vertex*3 + 2] = vertices[offset + 2]
+  }
+
+  const compactIndices = remap.size < 65536 ? new Uint16Array(indices.length) : new Uint32Array(indices.length)
+  for (let i = 0; i < indices.length; i++) {
+    compactIndices[i] = remap.get(indices[i])
+  }
+
+  return { positions, indices: compactIndices }
+}
+
+// the fields of HullStats in hull.c, in order
+const HULL_STAT_NAMES = [
+  "extremesSeconds", "seedSeconds", "visibilitySeconds", "horizonSeconds", "rebuildSeconds",
+  "numPoints", "numCulledPoints", "numDroppedPoints", "numExpansions", "numFacesCreated", "numFacesDestroyed",
+  "peakLiveFaces", "numVisibleFaces", "numHorizonEdges", "maxHorizonEdges",
+]
+const HULL_COLLECT_STATS = 2
+
+/**
+ * Binding to the WebAssembly build of hull.c (see the build-c script), which keeps its vertex and index buffers
+ * in the wasm heap between calls. Write the vertices straight into the view from getVertices(), then call
+ * generateHullTriangles(). The views are only valid until the next call to the binding, as the buffers (and the
+ * heap) may grow. With cacheBytes, generateHullTriangles() keeps up to that many bytes of recent hulls, keyed
+ * by a hash of the vertices, so instances of the same mesh are only built once
+ *
+ * @param {any} c the instantiated module e.g. await hullCModule()
+ * @param {number} cacheBytes size of the hull cache, 0 for no cache
+ */
+export function createHullBinding(c, cacheBytes = 0) {
+  const ctx = c._hullContextCreate(0, 0)
+  const cache = cacheBytes > 0 ? c._hullCacheCreate(cacheBytes) : 0
+  let verticesPtr = 0
+  let verticesCapacity = 0 // floats
+  let indicesPtr = 0
+  let indicesCapacity = 0 // ints
+  let positionsPtr = 0
+  let positionsCapacity = 0 // floats
+  const numHullVerticesPtr = c._malloc(4)
+  const boundsPtr = c._malloc(19*4) // the box then the sphere
+
+  if (!ctx || !numHullVerticesPtr || !boundsPtr || (cacheBytes > 0 && !cache)) {
+    throw Error("out of memory")
+  }
+
+  /** @type {(ptr: number, capacity: number, count: number) => number} */
+  function reserve(ptr, capacity, count) {
+    if (count <= capacity) {
+      return ptr
+    }
+    c._free(ptr)
+    const newPtr = c._malloc(count*4)
+    if (!newPtr) {
+      throw Error("out of memory")
+    }
+    return newPtr
+  }
+
+  /** @type {(numVertices: number) => Float32Array} */
+  function getVertices(numVertices) {
+    if (numVertices > verticesCapacity) {
+      const capacity = Math.max(numVertices, verticesCapacity*2, 1024)
+      verticesPtr = reserve(verticesPtr, verticesCapacity, capacity)
+      verticesCapacity = capacity
+    }
+    return new Float32Array(c.HEAPU8.buffer, verticesPtr, numVertices)
+  }
+
+  /** @type {(vertices: Vertices) => Float32Array} */
+  function setVertices(vertices) {
+    const view = getVertices(vertices.length)
+    view.set(vertices)
+    return view
+  }
+
+  /** @type {(numVertices: number, stride: number) => void} */
+  function reserveIndices(numVertices, stride) {
+    const numPoints = Math.floor(numVertices/stride)
+    const maxIndices = numPoints < 4 ? 0 : 3*(2*numPoints - 4)
+
+    if (maxIndices > indicesCapacity) {
+      const capacity = Math.max(maxIndices, indicesCapacity*2, 1024)
+      indicesPtr = reserve(indicesPtr, indicesCapacity, capacity)
+      indicesCapacity = capacity
+    }
+  }
+
+  /**
+   * builds the hull from the first numVertices floats of getVertices(). Returns a view of the indices (or a copy
+   * which owns its buffer, so it can be transferred), or undefined if there are too few vertices or they are
+   * collinear. Coplanar vertices give a flat hull, with a fan of triangles on each side
+   * @type {(numVertices: number, stride?: number, copy?: boolean) => Int32Array | undefined}
+   */
+  function generateHullTriangles(numVertices, stride = 3, copy = false) {
+    reserveIndices(numVertices, stride)
+
+    const numIndices = cache ?
+      c._generateHullTrianglesCached(cache, ctx, indicesPtr, verticesPtr, numVertices, stride) :
+      c._generateHullTrianglesWithContext(ctx, indicesPtr, verticesPtr, numVertices, stride)
+    if (numIndices === -3) {
+      throw Error("out of memory")
+    } else if (numIndices < 0) {
+      return undefined // too few vertices or all collinear
+    }
+
+    const indices = new Int32Array(c.HEAPU8.buffer, indicesPtr, numIndices)
+    return copy ? indices.slice() : indices
+  }
+
+  /**
+   * same as generateHullTriangles(), but the result is a compact mesh (see compactHullTriangles()) and the
+   * indices are a Uint16Array if there are fewer than 65536 hull vertices, otherwise an Int32Array
+   * @type {(numVertices: number, stride?: number, copy?: boolean) => {positions: Float32Array, indices: Uint16Array | Int32Array} | undefined}
+   */
+  function generateCompactHull(numVertices, stride = 3, copy = false) {
+    reserveIndices(numVertices, stride)
+
+    if (numVertices > positionsCapacity) {
+      const capacity = Math.max(numVertices, positionsCapacity*2, 1024)
+      positionsPtr = reserve(positionsPtr, positionsCapacity, capacity)
+      positionsCapacity = capacity
+    }
+
+    const numIndices = c._generateCompactHull(ctx, positionsPtr, indicesPtr, numHullVerticesPtr, verticesPtr, numVertices, stride)
+    if (numIndices === -3) {
+      throw Error("out of memory")
+    } else if (numIndices < 0) {
+      return undefined // too few vertices or all collinear
+    }
+
+    const numHullVertices = new Int32Array(c.HEAPU8.buffer, numHullVerticesPtr, 1)[0]
+    const positions = new Float32Array(c.HEAPU8.buffer, positionsPtr, numHullVertices*3)
+    const indices = numHullVertices < 65536 ? new Uint16Array(c.HEAPU8.buffer, indicesPtr, numIndices) : new Int32Array(c.HEAPU8.buffer, indicesPtr, numIndices)
+    return copy ? { positions: positions.slice(), indices: indices.slice() } : { positions, indices }
+  }
 
-// export function generateHullTriangles2(vertices, stride = 3) {
-//   const verticesTyped = vertices.buffer ? vertices : Float32Array.from(vertices)
+  /**
+   * times the phases of the following builds for getStats(), the counts are always kept
+   * @type {(enabled: boolean) => void}
+   */
+  function setCollectStats(enabled) {
+    const flags = c._hullContextGetFlags(ctx)
+    c._hullContextSetFlags(ctx, enabled ? flags | HULL_COLLECT_STATS : flags & ~HULL_COLLECT_STATS)
+  }
+
+  /**
+   * what the last build did, see HullStats in hull.c. A cache hit leaves the stats of the last real build
+   * @type {() => {[name: string]: number}}
+   */
+  function getStats() {
+    const statsPtr = c._hullContextGetStats(ctx)
+    const view = new Float64Array(c.HEAPU8.buffer, statsPtr, HULL_STAT_NAMES.length)
+    return Object.fromEntries(HULL_STAT_NAMES.map((name, i) => [name, view[i]]))
+  }
+
+  /**
+   * counters for the hull cache, all 0 if there is no cache
+   * @type {() => {hits: number, misses: number, bytes: number, entries: number}}
+   */
+  function getCacheStats() {
+    return cache ?
+      { hits: c._hullCacheHits(cache), misses: c._hullCacheMisses(cache), bytes: c._hullCacheBytes(cache), entries: c._hullCacheNumEntries(cache) } :
+      { hits: 0, misses: 0, bytes: 0, entries: 0 }
+  }
+
+  /**
+   * the hull cache as bytes for loadCache(), e.g. to store with the built assets
+   * @type {() => Uint8Array}
+   */
+  function saveCache() {
+    if (!cache) {
+      throw Error("no hull cache")
+    }
+
+    const numBytes = c._hullCacheSerializedBytes(cache)
+    const ptr = c._malloc(numBytes)
+    if (!ptr || c._hullCacheSerialize(cache, ptr) < 0) {
+      c._free(ptr)
+      throw Error("out of memory")
+    }
+
+    const bytes = c.HEAPU8.slice(ptr, ptr + numBytes)
+    c._free(ptr)
+    return bytes
+  }
+
+  /**
+   * adds the hulls from saveCache() to the cache. Returns the number of hulls added
+   * @type {(bytes: Uint8Array) => number}
+   */
+  function loadCache(bytes) {
+    if (!cache) {
+      throw Error("no hull cache")
+    }
+
+    const ptr = c._malloc(bytes.length)
+    if (!ptr) {
+      throw Error("out of memory")
+    }
+
+    c.HEAPU8.set(bytes, ptr)
+    const numAdded = c._hullCacheDeserialize(cache, ptr, bytes.length)
+    c._free(ptr)
+
+    if (numAdded === -1) {
+      throw Error("not a hull cache")
+    } else if (numAdded < 0) {
+      throw Error("out of memory")
+    }
+    return numAdded
+  }
+
+  /**
+   * a query for batches of point and ray tests against the hull of the first numVertices floats of
+   * getVertices(), with one plane per polygon of the hull. Returns undefined if there is no hull. The results
+   * are views which are only valid until the next call to the query or the binding, and the query must be
+   * destroyed once it is no longer needed
+   * @type {(numVertices: number, stride?: number) => HullQuery | undefined}
+   */
+  function createQuery(numVertices, stride = 3) {
+    const query = c._generateHullQuery(ctx, verticesPtr, numVertices, stride)
+    if (!query) {
+      return undefined
+    }
 
-//   const verticesUint8 = new Uint8Array(verticesTyped.buffer, 0, verticesTyped.byteLength)
-//   const outIndicesPtr = c._malloc(1024*3*4); // offset into c.HEAPU8.buffer
+    let inputPtr = 0
+    let inputCapacity = 0 // floats
+    let outputPtr = 0
+    let outputCapacity = 0 // ints
 
-//   const numIndices = cGenerateHullTriangles(outIndicesPtr, verticesUint8, vertices.length, stride)
-//   const indices = numIndices > 0 ? new Int32Array(c.HEAPU8.buffer, outIndicesPtr, numIndices) : []
-//   c._free(outIndicesPtr)
+    /** @type {(input: Float32Array, numOutputs: number) => void} */
+    function setInput(input, numOutputs) {
+      if (input.length > inputCapacity) {
+        inputPtr = reserve(inputPtr, inputCapacity, input.length)
+        inputCapacity = input.length
+      }
+      if (numOutputs > outputCapacity) {
+        outputPtr = reserve(outputPtr, outputCapacity, numOutputs)
+        outputCapacity = numOutputs
+      }
+      new Float32Array(c.HEAPU8.buffer, inputPtr, input.length).set(input)
+    }
 
-//   if (numIndices < 0) {
-//     console.error("cGenerateHullTriangles failed: ", numIndices)
-//   }
+    /**
+     * points are packed x, y, z. Returns 1 for each point inside or on the hull, 0 otherwise
+     * @type {(points: Float32Array) => Uint8Array}
+     */
+    function containsPoints(points) {
+      const numPoints = Math.floor(points.length/3)
+      setInput(points, Math.ceil(numPoints/4))
+      c._hullContainsPoints(query, inputPtr, numPoints, outputPtr)
+      return new Uint8Array(c.HEAPU8.buffer, outputPtr, numPoints)
+    }
+
+    /**
+     * rays are packed origin x, y, z then direction x, y, z. t is where each ray enters the hull in lengths of
+     * its direction, and faces the plane it enters through. Rays which start inside get a t of 0 and a face
+     * of -1, and rays which miss get -1 for both
+     * @type {(rays: Float32Array) => {t: Float32Array, faces: Int32Array}}
+     */
+    function raycast(rays) {
+      const numRays = Math.floor(rays.length/6)
+      setInput(rays, numRays*2)
+      c._hullRaycast(query, inputPtr, numRays, outputPtr, outputPtr + numRays*4)
+      return { t: new Float32Array(c.HEAPU8.buffer, outputPtr, numRays), faces: new Int32Array(c.HEAPU8.buffer, outputPtr + numRays*4, numRays) }
+    }
 
-//   return indices
-// }
+    function destroyQuery() {
+      c._free(inputPtr)
+      c._free(outputPtr)
+      c._hullQueryDestroy(query)
+      inputPtr = outputPtr = inputCapacity = outputCapacity = 0
+    }
+
+    return { numPlanes: c._hullQueryNumPlanes(query), containsPoints, raycast, destroy: destroyQuery }
+  }
+
+  /**
+   * the smallest oriented box with a face on a face of the hull, and the smallest sphere around the hull, of the
+   * first numVertices floats of getVertices(), see Bounding volumes in hull.c. The box is center + axes[k]*t for each of its 3 unit axes
+   * (packed x, y, z) with t from -halfExtents[k] to halfExtents[k]. The results are copies. Returns undefined if
+   * there is no hull
+   * @type {(numVertices: number, stride?: number) => HullBounds | undefined}
+   */
+  function calcBounds(numVertices, stride = 3) {
+    const indices = generateHullTriangles(numVertices, stride)
+    if (!indices) {
+      return undefined
+    }
+
+    if (c._calcHullOrientedBox(boundsPtr, verticesPtr, indicesPtr, indices.length) < 0 ||
+        c._calcHullBoundingSphere(boundsPtr + 15*4, verticesPtr, indicesPtr, indices.length) < 0) {
+      throw Error("out of memory")
+    }
+
+    const bounds = new Float32Array(c.HEAPU8.buffer, boundsPtr, 19)
+    return {
+      box: { center: bounds.slice(0, 3), axes: bounds.slice(3, 12), halfExtents: bounds.slice(12, 15) },
+      sphere: { center: bounds.slice(15, 18), radius: bounds[18] },
+    }
+  }
+
+  function destroy() {
+    c._free(verticesPtr)
+    c._free(indicesPtr)
+    c._free(positionsPtr)
+    c._free(numHullVerticesPtr)
+    c._free(boundsPtr)
+    c._hullContextDestroy(ctx)
+    if (cache) {
+      c._hullCacheDestroy(cache)
+    }
+    verticesPtr = indicesPtr = positionsPtr = verticesCapacity = indicesCapacity = positionsCapacity = 0
+  }
+
+  return { getVertices, setVertices, generateHullTriangles, generateCompactHull, createQuery, calcBounds, setCollectStats, getStats, getCacheStats, saveCache, loadCache, destroy }
+}
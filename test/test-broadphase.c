@@ -0,0 +1,281 @@
+#include <math.h>
+#include <string.h>
+#include "../../munit/munit.h"
+#include "../../munit/munit.c"
+#include "../src/broadphase.c"
+
+static const float CUBE[] = {
+  -1.f,-1.f,-1.f, 1.f,-1.f,-1.f, -1.f,1.f,-1.f, 1.f,1.f,-1.f,
+  -1.f,-1.f,1.f, 1.f,-1.f,1.f, -1.f,1.f,1.f, 1.f,1.f,1.f,
+};
+
+// boxes up to maxSize wide, inside a cube of width range
+static void randomBounds(float* bounds, const int numBodies, const float range, const float maxSize) {
+  for (int i = 0; i < numBodies*FLOATS_PER_BOUNDS; i += FLOATS_PER_BOUNDS) {
+    for (int j = 0; j < 3; j++) {
+      bounds[i + j] = munit_rand_double()*range;
+      bounds[i + j + 3] = bounds[i + j] + munit_rand_double()*maxSize;
+    }
+  }
+}
+
+static void moveBounds(float* bounds, const int numBodies, const float maxStep) {
+  for (int i = 0; i < numBodies*FLOATS_PER_BOUNDS; i += FLOATS_PER_BOUNDS) {
+    for (int j = 0; j < 3; j++) {
+      const float step = (munit_rand_double()*2.f - 1.f)*maxStep;
+      bounds[i + j] += step;
+      bounds[i + j + 3] += step;
+    }
+  }
+}
+
+static int comparePairs(const void* a, const void* b) {
+  const int* pairA = a;
+  const int* pairB = b;
+  return pairA[0] != pairB[0] ? pairA[0] - pairB[0] : pairA[1] - pairB[1];
+}
+
+// the pairs found by bp are the pairs found by testing every pair
+static void assertPairs(Broadphase* bp, const float* bounds, const int numBodies, int* pairs, int* expected, const int maxPairs) {
+  int numExpected = 0;
+  for (int i = 0; i < numBodies; i++) {
+    for (int j = i + 1; j < numBodies; j++) {
+      if (isBoundsOverlapping(bounds + i*FLOATS_PER_BOUNDS, bounds + j*FLOATS_PER_BOUNDS)) {
+        munit_assert_int(numExpected, <, maxPairs);
+        expected[numExpected*2] = i;
+        expected[numExpected*2 + 1] = j;
+        numExpected++;
+      }
+    }
+  }
+
+  const int numPairs = broadphaseFindPairs(bp, pairs, maxPairs);
+  munit_assert_int(numPairs, ==, numExpected);
+
+  qsort(pairs, numPairs, 2*sizeof(int), comparePairs);
+  munit_assert_memory_equal(numPairs*2*sizeof(int), pairs, expected);
+}
+
+static MunitResult
+test_broadphaseCreate(const MunitParameter params[], void* data) {
+  Broadphase* bvh = broadphaseCreate(BROADPHASE_BVH);
+  Broadphase* sap = broadphaseCreate(BROADPHASE_SAP);
+  int pairs[2];
+
+  munit_assert_not_null(bvh);
+  munit_assert_not_null(sap);
+  munit_assert_null(broadphaseCreate(2));
+
+  // nothing set yet
+  munit_assert_int(broadphaseFindPairs(bvh, pairs, 1), ==, 0);
+  munit_assert_int(broadphaseFindPairs(sap, pairs, 1), ==, 0);
+
+  broadphaseDestroy(bvh);
+  broadphaseDestroy(sap);
+  broadphaseDestroy(NULL);
+
+  return MUNIT_OK;
+}
+
+static void assertNodeBounds(const Broadphase* bp, const float* outerMin, const float* outerMax, const float* min, const float* max) {
+  for (int i = 0; i < 3; i++) {
+    munit_assert_float(outerMin[i], <=, min[i]);
+    munit_assert_float(outerMax[i], >=, max[i]);
+  }
+}
+
+static MunitResult
+test_broadphaseSetBounds(const MunitParameter params[], void* data) {
+  const int NUM_BODIES = 1000;
+  float* bounds = malloc(NUM_BODIES*FLOATS_PER_BOUNDS*sizeof(float));
+  int* seen = calloc(NUM_BODIES, sizeof(int));
+  Broadphase* bp = broadphaseCreate(BROADPHASE_BVH);
+
+  randomBounds(bounds, NUM_BODIES, 100.f, 5.f);
+  munit_assert_int(broadphaseSetBounds(bp, bounds, NUM_BODIES), ==, 0);
+  munit_assert_int(bp->numBuilds, ==, 1);
+
+  // small steps refit the tree, which still bounds every body
+  for (int step = 0; step < 5; step++) {
+    moveBounds(bounds, NUM_BODIES, .5f);
+    munit_assert_int(broadphaseSetBounds(bp, bounds, NUM_BODIES), ==, 0);
+  }
+  munit_assert_int(bp->numBuilds, ==, 1);
+
+  for (int i = 0; i < bp->numNodes; i++) {
+    const BvhNode* node = bp->nodes + i;
+    if (node->count > 0) {
+      munit_assert_int(node->count, <=, MAX_LEAF_BODIES);
+      for (int j = node->index; j < node->index + node->count; j++) {
+        const float* body = bounds + bp->order[j]*FLOATS_PER_BOUNDS;
+        assertNodeBounds(bp, node->min, node->max, body, body + 3);
+        seen[bp->order[j]]++;
+      }
+    } else {
+      munit_assert_int(node->index, >, i + 1);
+      assertNodeBounds(bp, node->min, node->max, node[1].min, node[1].max);
+      assertNodeBounds(bp, node->min, node->max, bp->nodes[node->index].min, bp->nodes[node->index].max);
+    }
+  }
+
+  for (int i = 0; i < NUM_BODIES; i++) {
+    munit_assert_int(seen[i], ==, 1);
+  }
+
+  // scattering the bodies makes the refit tree much worse, so it is rebuilt
+  randomBounds(bounds, NUM_BODIES, 100.f, 5.f);
+  munit_assert_int(broadphaseSetBounds(bp, bounds, NUM_BODIES), ==, 0);
+  munit_assert_int(bp->numBuilds, ==, 2);
+
+  // as does a different number of bodies, or asking for it
+  munit_assert_int(broadphaseSetBounds(bp, bounds, NUM_BODIES/2), ==, 0);
+  munit_assert_int(bp->numBuilds, ==, 3);
+  broadphaseRebuild(bp);
+  munit_assert_int(broadphaseSetBounds(bp, bounds, NUM_BODIES/2), ==, 0);
+  munit_assert_int(bp->numBuilds, ==, 4);
+
+  // bodies all in the same place are split in half
+  for (int i = 0; i < NUM_BODIES*FLOATS_PER_BOUNDS; i++) {
+    bounds[i] = i % FLOATS_PER_BOUNDS < 3 ? 0.f : 1.f;
+  }
+  munit_assert_int(broadphaseSetBounds(bp, bounds, NUM_BODIES), ==, 0);
+  munit_assert_int(bp->numNodes, ==, 2*256 - 1);
+
+  broadphaseDestroy(bp);
+  free(seen);
+  free(bounds);
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_broadphaseFindPairs(const MunitParameter params[], void* data) {
+  const int NUM_BODIES = 2000;
+  const int MAX_PAIRS = 20000;
+  float* bounds = malloc(NUM_BODIES*FLOATS_PER_BOUNDS*sizeof(float));
+  int* pairs = malloc(MAX_PAIRS*2*sizeof(int));
+  int* expected = malloc(MAX_PAIRS*2*sizeof(int));
+
+  for (int mode = BROADPHASE_BVH; mode <= BROADPHASE_SAP; mode++) {
+    Broadphase* bp = broadphaseCreate(mode);
+
+    // moving bodies, including some that jump across the scene
+    randomBounds(bounds, NUM_BODIES, 100.f, 8.f);
+    for (int step = 0; step < 10; step++) {
+      munit_assert_int(broadphaseSetBounds(bp, bounds, NUM_BODIES), ==, 0);
+      assertPairs(bp, bounds, NUM_BODIES, pairs, expected, MAX_PAIRS);
+      moveBounds(bounds, NUM_BODIES, 1.f);
+      randomBounds(bounds + step*FLOATS_PER_BOUNDS, 1, 100.f, 8.f);
+    }
+
+    // the count of pairs is returned, but no more than maxPairs are written
+    const int numPairs = broadphaseFindPairs(bp, pairs, MAX_PAIRS);
+    munit_assert_int(numPairs, >, 10);
+    pairs[10] = -1;
+    munit_assert_int(broadphaseFindPairs(bp, pairs, 5), ==, numPairs);
+    munit_assert_int(pairs[10], ==, -1);
+
+    // a flat scene, and touching bounds overlap
+    randomBounds(bounds, NUM_BODIES, 1000.f, 10.f);
+    for (int i = 0; i < NUM_BODIES; i++) {
+      bounds[i*FLOATS_PER_BOUNDS + 1] = 0.f;
+      bounds[i*FLOATS_PER_BOUNDS + 4] = 1.f;
+    }
+    memcpy(bounds + FLOATS_PER_BOUNDS, bounds, FLOATS_PER_BOUNDS*sizeof(float));
+    bounds[FLOATS_PER_BOUNDS] = bounds[3];
+    bounds[FLOATS_PER_BOUNDS + 3] = bounds[3] + 1.f;
+    munit_assert_int(broadphaseSetBounds(bp, bounds, NUM_BODIES), ==, 0);
+    assertPairs(bp, bounds, NUM_BODIES, pairs, expected, MAX_PAIRS);
+
+    // bodies so large that every split of a node holding one costs infinity, and each overlaps every body
+    randomBounds(bounds, 200, 100.f, 8.f);
+    for (int i = 0; i < 200; i += 10) {
+      for (int j = 0; j < 3; j++) {
+        bounds[i*FLOATS_PER_BOUNDS + j] = -1e20f;
+        bounds[i*FLOATS_PER_BOUNDS + j + 3] = 1e20f;
+      }
+    }
+    munit_assert_int(broadphaseSetBounds(bp, bounds, 200), ==, 0);
+    assertPairs(bp, bounds, 200, pairs, expected, MAX_PAIRS);
+
+    // one and two bodies
+    munit_assert_int(broadphaseSetBounds(bp, bounds, 1), ==, 0);
+    munit_assert_int(broadphaseFindPairs(bp, pairs, MAX_PAIRS), ==, 0);
+    memcpy(bounds + FLOATS_PER_BOUNDS, bounds, FLOATS_PER_BOUNDS*sizeof(float));
+    munit_assert_int(broadphaseSetBounds(bp, bounds, 2), ==, 0);
+    munit_assert_int(broadphaseFindPairs(bp, pairs, MAX_PAIRS), ==, 1);
+    munit_assert_int(pairs[0], ==, 0);
+    munit_assert_int(pairs[1], ==, 1);
+
+    broadphaseDestroy(bp);
+  }
+
+  free(expected);
+  free(pairs);
+  free(bounds);
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_broadphaseSetShapes(const MunitParameter params[], void* data) {
+  HullContext* ctx = hullContextCreate(0, 0);
+  ConvexShape* cube = convexShapeCreate(ctx, CUBE, sizeof(CUBE)/sizeof(float), 3);
+  const ConvexShape* shapes[3] = { cube, cube, cube };
+  float transforms[3*16] = {0};
+  Broadphase* bp = broadphaseCreate(BROADPHASE_BVH);
+  int pairs[6];
+
+  munit_assert_float(cube->bounds[0], ==, -1.f);
+  munit_assert_float(cube->bounds[5], ==, 1.f);
+
+  // rotated 45 degrees about z and scaled 2 in z, the corners reach sqrt(2) along x and y
+  const float c = cosf((float)M_PI/4), s = sinf((float)M_PI/4);
+  const float offsets[3] = { 0.f, 2.5f, 5.2f };
+  for (int i = 0; i < 3; i++) {
+    float* transform = transforms + i*16;
+    transform[0] = c, transform[1] = s;
+    transform[4] = -s, transform[5] = c;
+    transform[10] = 2.f;
+    transform[12] = offsets[i], transform[15] = 1.f;
+  }
+
+  munit_assert_int(broadphaseSetShapes(bp, shapes, transforms, 3), ==, 0);
+  munit_assert_float(fabsf(bp->bounds[0] + sqrtf(2.f)), <, 1e-5f);
+  munit_assert_float(fabsf(bp->bounds[4] - sqrtf(2.f)), <, 1e-5f);
+  munit_assert_float(fabsf(bp->bounds[5] - 2.f), <, 1e-5f);
+
+  // 0 and 1 overlap, 1 and 2 overlap, 0 and 2 are too far apart
+  munit_assert_int(broadphaseFindPairs(bp, pairs, 3), ==, 2);
+  qsort(pairs, 2, 2*sizeof(int), comparePairs);
+  munit_assert_int(pairs[0], ==, 0);
+  munit_assert_int(pairs[1], ==, 1);
+  munit_assert_int(pairs[2], ==, 1);
+  munit_assert_int(pairs[3], ==, 2);
+
+  broadphaseDestroy(bp);
+  convexShapeDestroy(cube);
+  hullContextDestroy(ctx);
+
+  return MUNIT_OK;
+}
+
+static MunitTest test_suite_tests[] = {
+  {(char*)"broadphaseCreate", test_broadphaseCreate, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"broadphaseSetBounds", test_broadphaseSetBounds, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"broadphaseFindPairs", test_broadphaseFindPairs, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"broadphaseSetShapes", test_broadphaseSetShapes, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+};
+
+static const MunitSuite test_suite = {
+  (char*)"",
+  test_suite_tests,
+  NULL,
+  1,
+  MUNIT_SUITE_OPTION_NONE
+};
+
+int main(int argc, char* argv[MUNIT_ARRAY_PARAM(argc + 1)]) {
+  return munit_suite_main(&test_suite, (void*)"unit", argc, argv);
+}
@@ -0,0 +1,291 @@
+#include <math.h>
+#include <string.h>
+#include "../../munit/munit.h"
+#include "../../munit/munit.c"
+#include "../src/collision.c"
+
+static const float CUBE[] = {
+  -1.f,-1.f,-1.f, 1.f,-1.f,-1.f, -1.f,1.f,-1.f, 1.f,1.f,-1.f,
+  -1.f,-1.f,1.f, 1.f,-1.f,1.f, -1.f,1.f,1.f, 1.f,1.f,1.f,
+};
+
+// column-major, rotation of angle about z then a translation
+static void setTransform(float* out, const float angle, const float x, const float y, const float z) {
+  memset(out, 0, 16*sizeof(float));
+  out[0] = cosf(angle), out[1] = sinf(angle);
+  out[4] = -sinf(angle), out[5] = cosf(angle);
+  out[10] = 1.f;
+  out[12] = x, out[13] = y, out[14] = z, out[15] = 1.f;
+}
+
+static void randomSpherePoints(float* verts, const int numPoints) {
+  for (int i = 0; i < numPoints*3; i += 3) {
+    do {
+      verts[i] = munit_rand_double()*2.f - 1.f;
+      verts[i+1] = munit_rand_double()*2.f - 1.f;
+      verts[i+2] = munit_rand_double()*2.f - 1.f;
+    } while (dot(verts + i, verts + i) > 1.f || dot(verts + i, verts + i) < .01f);
+    multiplyScalar(verts + i, verts + i, 1.f/sqrtf(dot(verts + i, verts + i)));
+  }
+}
+
+static MunitResult
+test_convexShapeCreate(const MunitParameter params[], void* data) {
+  HullContext* ctx = hullContextCreate(0, 0);
+  ConvexShape* cube = convexShapeCreate(ctx, CUBE, sizeof(CUBE)/sizeof(float), 3);
+
+  // 12 triangles have 18 edges, so 36 neighbours, and each neighbour shares an edge
+  munit_assert_not_null(cube);
+  munit_assert_int(convexShapeNumVertices(cube), ==, 8);
+  munit_assert_int(cube->neighbourStarts[8], ==, 36);
+
+  for (int i = 0; i < 8; i++) {
+    const float* v = convexShapeGetVertices(cube) + i*3;
+    munit_assert_int(cube->neighbourStarts[i + 1] - cube->neighbourStarts[i], >=, 3);
+
+    for (int j = cube->neighbourStarts[i]; j < cube->neighbourStarts[i + 1]; j++) {
+      const float* neighbour = convexShapeGetVertices(cube) + cube->neighbours[j]*3;
+      munit_assert_int(cube->neighbours[j], !=, i);
+      munit_assert_true((v[0] == neighbour[0]) + (v[1] == neighbour[1]) + (v[2] == neighbour[2]) >= 1);
+    }
+  }
+
+  // not enough points, or collinear
+  const float line[] = { 0.f,0.f,0.f, 1.f,0.f,0.f, 2.f,0.f,0.f, 3.f,0.f,0.f };
+  munit_assert_null(convexShapeCreate(ctx, CUBE, 3*3, 3));
+  munit_assert_null(convexShapeCreate(ctx, line, sizeof(line)/sizeof(float), 3));
+
+  convexShapeDestroy(cube);
+  convexShapeDestroy(NULL);
+  hullContextDestroy(ctx);
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_calcSupportVertex(const MunitParameter params[], void* data) {
+  const int NUM_POINTS = 2000;
+  float* verts = malloc(NUM_POINTS*3*sizeof(float));
+  randomSpherePoints(verts, NUM_POINTS);
+
+  HullContext* ctx = hullContextCreate(0, 0);
+  ConvexShape* sphere = convexShapeCreate(ctx, verts, NUM_POINTS*3, 3);
+  munit_assert_not_null(sphere);
+  munit_assert_int(convexShapeNumVertices(sphere), ==, NUM_POINTS);
+
+  // climbing from anywhere finds the same vertex as a scan
+  int start = 0;
+  for (int i = 0; i < 200; i++) {
+    float direction[3] = { munit_rand_double() - .5f, munit_rand_double() - .5f, munit_rand_double() - .5f };
+    int best = 0;
+    for (int j = 0; j < NUM_POINTS; j++) {
+      if (dot(sphere->positions + j*3, direction) > dot(sphere->positions + best*3, direction)) {
+        best = j;
+      }
+    }
+
+    start = calcSupportVertex(sphere, direction, start);
+    munit_assert_float(dot(sphere->positions + start*3, direction), ==, dot(sphere->positions + best*3, direction));
+  }
+
+  convexShapeDestroy(sphere);
+  hullContextDestroy(ctx);
+  free(verts);
+
+  return MUNIT_OK;
+}
+
+// the points of a grid in eighths inside both the cube and a sphere of radius 1.2, so the hull has a flat disc on
+// each side of the cube, with many grid points inside each disc, and a curved band with many vertices between them
+static int gridBallPoints(float* verts) {
+  int numVerts = 0;
+  for (int x = -8; x <= 8; x++) {
+    for (int y = -8; y <= 8; y++) {
+      for (int z = -8; z <= 8; z++) {
+        if (x*x + y*y + z*z <= 92) {
+          verts[numVerts++] = x/8.f;
+          verts[numVerts++] = y/8.f;
+          verts[numVerts++] = z/8.f;
+        }
+      }
+    }
+  }
+  return numVerts;
+}
+
+static MunitResult
+test_calcSupportVertexGrid(const MunitParameter params[], void* data) {
+  float* verts = malloc(17*17*17*3*sizeof(float));
+  const int numVerts = gridBallPoints(verts);
+  const float directions[] = { 1.f,0.f,0.f, -1.f,0.f,0.f, 0.f,1.f,0.f, 0.f,-1.f,0.f, 0.f,0.f,1.f, 0.f,0.f,-1.f, 1.f,1.f,0.f, 1.f,1.f,1.f };
+
+  HullContext* ctx = hullContextCreate(0, 0);
+  ConvexShape* shape = convexShapeCreate(ctx, verts, numVerts, 3);
+  munit_assert_not_null(shape);
+  munit_assert_int(convexShapeNumVertices(shape), >, MAX_SCAN_VERTICES);
+
+  // the climb reaches the best distance from every start, even where many grid points tie on a flat side
+  for (int i = 0; i < (int)(sizeof(directions)/sizeof(float)); i += 3) {
+    float bestDistance = -INFINITY;
+    for (int j = 0; j < shape->numVertices; j++) {
+      bestDistance = fmaxf(bestDistance, dot(shape->positions + j*3, directions + i));
+    }
+
+    for (int start = 0; start < shape->numVertices; start++) {
+      const int support = calcSupportVertex(shape, directions + i, start);
+      munit_assert_float(dot(shape->positions + support*3, directions + i), ==, bestDistance);
+    }
+  }
+
+  // the flat sides just touch, whichever vertices are cached
+  float transformA[16], transformB[16];
+  setTransform(transformA, 0.f, 0.f, 0.f, 0.f);
+
+  for (int start = 0; start < shape->numVertices; start++) {
+    ConvexCache cache = { start, start, {0.f,0.f,0.f} };
+    setTransform(transformB, 0.f, 1.99f, 0.f, 0.f);
+    munit_assert_true(convexOverlap(shape, transformA, shape, transformB, &cache));
+
+    cache = (ConvexCache){ start, start, {0.f,0.f,0.f} };
+    setTransform(transformB, 0.f, 2.01f, 0.f, 0.f);
+    munit_assert_false(convexOverlap(shape, transformA, shape, transformB, &cache));
+  }
+
+  convexShapeDestroy(shape);
+  hullContextDestroy(ctx);
+  free(verts);
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_convexOverlap(const MunitParameter params[], void* data) {
+  HullContext* ctx = hullContextCreate(0, 0);
+  ConvexShape* cube = convexShapeCreate(ctx, CUBE, sizeof(CUBE)/sizeof(float), 3);
+  ConvexCache cache = {0};
+  float transformA[16], transformB[16];
+
+  setTransform(transformA, 0.f, 0.f, 0.f, 0.f);
+
+  // a cube rotated 45 degrees reaches sqrt(2) along x
+  setTransform(transformB, (float)M_PI/4, 2.3f, 0.f, 0.f);
+  munit_assert_true(convexOverlap(cube, transformA, cube, transformB, &cache));
+  setTransform(transformB, (float)M_PI/4, 2.5f, 0.f, 0.f);
+  munit_assert_false(convexOverlap(cube, transformA, cube, transformB, &cache));
+
+  // the separating axis is kept, from a to b
+  munit_assert_float(cache.axis[0], >, 0.f);
+
+  // without a cache
+  setTransform(transformB, .3f, 1.f, 1.f, 1.f);
+  munit_assert_true(convexOverlap(cube, transformA, cube, transformB, NULL));
+  setTransform(transformB, .3f, 0.f, 0.f, -2.1f);
+  munit_assert_false(convexOverlap(cube, transformA, cube, transformB, NULL));
+
+  convexShapeDestroy(cube);
+  hullContextDestroy(ctx);
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_convexDistance(const MunitParameter params[], void* data) {
+  HullContext* ctx = hullContextCreate(0, 0);
+  ConvexShape* cube = convexShapeCreate(ctx, CUBE, sizeof(CUBE)/sizeof(float), 3);
+  ConvexCache cache = {0};
+  ConvexContact contact;
+  float transformA[16], transformB[16];
+
+  // faces 0.5 apart along y
+  setTransform(transformA, 0.f, 0.f, 0.f, 0.f);
+  setTransform(transformB, 0.f, .2f, 2.5f, -.3f);
+  munit_assert_float(fabsf(convexDistance(cube, transformA, cube, transformB, &cache, &contact) - .5f), <, 1e-5f);
+  munit_assert_float(fabsf(contact.normal[1] - 1.f), <, 1e-5f);
+  munit_assert_float(fabsf(contact.pointA[1] - 1.f), <, 1e-5f);
+  munit_assert_float(fabsf(contact.pointB[1] - 1.5f), <, 1e-5f);
+
+  // a corner towards a face, the closest points are the corner and its projection
+  setTransform(transformB, (float)M_PI/4, 3.f, 0.f, 0.f);
+  munit_assert_float(fabsf(convexDistance(cube, transformA, cube, transformB, NULL, &contact) - (2.f - sqrtf(2.f))), <, 1e-5f);
+  munit_assert_float(fabsf(contact.pointA[0] - 1.f), <, 1e-5f);
+  munit_assert_float(fabsf(contact.pointB[0] - (3.f - sqrtf(2.f))), <, 1e-5f);
+  munit_assert_float(fabsf(contact.pointB[1]), <, 1e-5f);
+
+  // the cache follows the shapes as they move
+  for (int i = 0; i < 10; i++) {
+    setTransform(transformB, 0.f, 2.f + i*.1f, i*.05f, 0.f);
+    munit_assert_float(fabsf(convexDistance(cube, transformA, cube, transformB, &cache, &contact) - i*.1f), <, 1e-4f);
+  }
+
+  // overlapping
+  setTransform(transformB, 0.f, 1.f, 0.f, 0.f);
+  munit_assert_float(convexDistance(cube, transformA, cube, transformB, &cache, NULL), ==, 0.f);
+
+  // scaled, twice as wide
+  setTransform(transformB, 0.f, 4.f, 0.f, 0.f);
+  transformB[0] = 2.f;
+  munit_assert_float(fabsf(convexDistance(cube, transformA, cube, transformB, &cache, &contact) - 1.f), <, 1e-5f);
+
+  convexShapeDestroy(cube);
+  hullContextDestroy(ctx);
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_convexPenetration(const MunitParameter params[], void* data) {
+  HullContext* ctx = hullContextCreate(0, 0);
+  ConvexShape* cube = convexShapeCreate(ctx, CUBE, sizeof(CUBE)/sizeof(float), 3);
+  ConvexCache cache = {0};
+  ConvexContact contact;
+  float transformA[16], transformB[16];
+
+  // 0.25 deep along x, the simplex starts flat so it must be blown up to a tetrahedron
+  setTransform(transformA, 0.f, 0.f, 0.f, 0.f);
+  setTransform(transformB, 0.f, 1.75f, 0.f, 0.f);
+  munit_assert_true(convexPenetration(cube, transformA, cube, transformB, &cache, &contact));
+  munit_assert_float(fabsf(contact.distance + .25f), <, 1e-4f);
+  munit_assert_float(fabsf(contact.normal[0] - 1.f), <, 1e-4f);
+  munit_assert_float(fabsf(contact.pointA[0] - 1.f), <, 1e-4f);
+  munit_assert_float(fabsf(contact.pointB[0] - .75f), <, 1e-4f);
+  munit_assert_float(fabsf(cache.axis[0] - 1.f), <, 1e-4f);
+
+  // rotated and offset, shallowest along -z
+  setTransform(transformB, .4f, .3f, -.2f, -1.6f);
+  munit_assert_true(convexPenetration(cube, transformA, cube, transformB, NULL, &contact));
+  munit_assert_float(fabsf(contact.distance + .4f), <, 1e-4f);
+  munit_assert_float(fabsf(contact.normal[2] + 1.f), <, 1e-4f);
+
+  // separated is the same as convexDistance()
+  setTransform(transformB, 0.f, 2.5f, 0.f, 0.f);
+  munit_assert_false(convexPenetration(cube, transformA, cube, transformB, &cache, &contact));
+  munit_assert_float(fabsf(contact.distance - .5f), <, 1e-5f);
+  munit_assert_float(fabsf(contact.normal[0] - 1.f), <, 1e-5f);
+
+  convexShapeDestroy(cube);
+  hullContextDestroy(ctx);
+
+  return MUNIT_OK;
+}
+
+static MunitTest test_suite_tests[] = {
+  {(char*)"convexShapeCreate", test_convexShapeCreate, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"calcSupportVertex", test_calcSupportVertex, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"calcSupportVertexGrid", test_calcSupportVertexGrid, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"convexOverlap", test_convexOverlap, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"convexDistance", test_convexDistance, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"convexPenetration", test_convexPenetration, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+};
+
+static const MunitSuite test_suite = {
+  (char*)"",
+  test_suite_tests,
+  NULL,
+  1,
+  MUNIT_SUITE_OPTION_NONE
+};
+
+int main(int argc, char* argv[MUNIT_ARRAY_PARAM(argc + 1)]) {
+  return munit_suite_main(&test_suite, (void*)"unit", argc, argv);
+}
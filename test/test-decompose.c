@@ -0,0 +1,244 @@
+#include <math.h>
+#include <string.h>
+#include "../../munit/munit.h"
+#include "../../munit/munit.c"
+#include "../src/decompose.c"
+
+// triangles as offsets into vertices, counter-clockwise from outside
+static const int BOX_INDICES[] = {
+  0,6,3, 0,9,6, 12,15,18, 12,18,21, 0,3,15, 0,15,12,
+  9,18,6, 9,21,18, 0,12,21, 0,21,9, 3,6,18, 3,18,15,
+};
+
+// appends a box to the mesh, returns the number of indices
+static int addBox(float* vertices, int* indices, const int numVertices, const float* min, const float* max) {
+  const float corners[] = {
+    min[0],min[1],min[2], max[0],min[1],min[2], max[0],max[1],min[2], min[0],max[1],min[2],
+    min[0],min[1],max[2], max[0],min[1],max[2], max[0],max[1],max[2], min[0],max[1],max[2],
+  };
+  memcpy(vertices + numVertices, corners, sizeof(corners));
+  for (int i = 0; i < 36; i++) {
+    indices[i] = BOX_INDICES[i] + numVertices;
+  }
+  return 36;
+}
+
+// a U standing on the xz plane, 3 wide and 3 high, with a 1x2 gap in the middle of the top
+static int makeU(float* vertices, int* indices) {
+  const float boxes[] = {
+    0.f,0.f,0.f, 3.f,1.f,1.f,
+    0.f,1.f,0.f, 1.f,3.f,1.f,
+    2.f,1.f,0.f, 3.f,3.f,1.f,
+  };
+  int numIndices = 0;
+  for (int i = 0; i < 3; i++) {
+    numIndices += addBox(vertices, indices + numIndices, i*24, boxes + i*6, boxes + i*6 + 3);
+  }
+  return numIndices;
+}
+
+// true if the point is behind or on every triangle of the part
+static bool isInsidePart(const float* positions, const int* indices, const int* part, const float* point) {
+  const float* vertices = positions + part[0]*3;
+  for (int i = part[2]; i < part[2] + part[3]; i += 3) {
+    float ab[3], ac[3], normal[3], offset[3];
+    sub(ab, vertices + indices[i + 1]*3, vertices + indices[i]*3);
+    sub(ac, vertices + indices[i + 2]*3, vertices + indices[i]*3);
+    cross(normal, ab, ac);
+    sub(offset, point, vertices + indices[i]*3);
+    if (dot(offset, normal) > 1e-4f*sqrtf(dot(normal, normal))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static MunitResult
+test_voxelizeMesh(const MunitParameter params[], void* data) {
+  float vertices[3*24];
+  int indices[3*36];
+  const float min[] = { 0.f, 0.f, 0.f };
+  const float max[] = { 4.f, 2.f, 1.f };
+  const int numIndices = addBox(vertices, indices, 0, min, max);
+
+  // 1 unit voxels fit the box exactly, and with the padding the grid is 6x4x3
+  Decomposition d = {0};
+  d.dims[0] = 6, d.dims[1] = 4, d.dims[2] = 3;
+  d.voxelSize = 1.f;
+  d.origin[0] = d.origin[1] = d.origin[2] = -1.f;
+
+  // a triangle on a face between voxels marks the voxels both sides, but never the padding
+  munit_assert_true(voxelizeMesh(&d, vertices, indices, numIndices));
+  munit_assert_int(d.numParts, ==, 1);
+  munit_assert_int(d.parts[0].numVoxels, ==, 4*2*1);
+  munit_assert_int(d.labels[0], ==, NO_INDEX);
+  munit_assert_int(d.labels[1 + 6*(1 + 4*1)], ==, 0);
+  freeDecomposition(&d);
+
+  // half size voxels, the inside is filled
+  Decomposition half = {0};
+  half.dims[0] = 10, half.dims[1] = 6, half.dims[2] = 4;
+  half.voxelSize = .5f;
+  half.origin[0] = half.origin[1] = half.origin[2] = -.5f;
+
+  munit_assert_true(voxelizeMesh(&half, vertices, indices, numIndices));
+  munit_assert_int(half.parts[0].numVoxels, ==, 8*4*2);
+  freeDecomposition(&half);
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_calcHullVolume(const MunitParameter params[], void* data) {
+  float vertices[3*24];
+  int indices[3*36];
+  const float min[] = { 1.f, 2.f, 3.f };
+  const float max[] = { 4.f, 4.f, 4.f };
+  addBox(vertices, indices, 0, min, max);
+
+  HullContext* ctx = hullContextCreate(0, 0);
+  float projectedAreas[3];
+  munit_assert_int(buildQuickHull(ctx, vertices, 24, 3), >=, 0);
+  munit_assert_float(fabsf(calcHullVolume(ctx, projectedAreas) - 6.f), <, 1e-4f);
+  munit_assert_float(fabsf(projectedAreas[0] - 2.f), <, 1e-4f);
+  munit_assert_float(fabsf(projectedAreas[1] - 3.f), <, 1e-4f);
+  munit_assert_float(fabsf(projectedAreas[2] - 6.f), <, 1e-4f);
+
+  // planar
+  const float square[] = { 0.f,0.f,0.f, 1.f,0.f,0.f, 1.f,1.f,0.f, 0.f,1.f,0.f };
+  munit_assert_int(buildQuickHull(ctx, square, 12, 3), >=, 0);
+  munit_assert_float(calcHullVolume(ctx, projectedAreas), ==, 0.f);
+  munit_assert_float(fabsf(projectedAreas[2] - 1.f), <, 1e-4f);
+
+  hullContextDestroy(ctx);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_calcVoxelHullVolume(const MunitParameter params[], void* data) {
+  HullContext* ctx = hullContextCreate(0, 0);
+
+  // the centers of a 3x2x1 block of voxels, and an L of 3
+  const float block[] = { .5f,.5f,.5f, 1.5f,.5f,.5f, 2.5f,.5f,.5f, .5f,1.5f,.5f, 1.5f,1.5f,.5f, 2.5f,1.5f,.5f };
+  munit_assert_float(fabsf(calcVoxelHullVolume(ctx, block, 18) - 6.f), <, 1e-4f);
+  munit_assert_float(fabsf(calcVoxelHullVolume(ctx, block, 9) - 3.f), <, 1e-4f);
+  munit_assert_float(fabsf(calcVoxelHullVolume(ctx, block, 3) - 1.f), <, 1e-4f);
+
+  const float l[] = { .5f,.5f,.5f, 1.5f,.5f,.5f, .5f,1.5f,.5f };
+  munit_assert_float(fabsf(calcVoxelHullVolume(ctx, l, 9) - 3.5f), <, 1e-4f);
+
+  // a 2x2x2 block of voxels with one corner missing
+  float cube[7*3];
+  for (int i = 0; i < 7; i++) {
+    cube[i*3] = (i & 1) + .5f, cube[i*3 + 1] = (i >> 1 & 1) + .5f, cube[i*3 + 2] = (i >> 2 & 1) + .5f;
+  }
+  munit_assert_float(fabsf(calcVoxelHullVolume(ctx, cube, 21) - (8.f - 1.f/6.f)), <, 1e-4f);
+
+  hullContextDestroy(ctx);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_generateConvexDecomposition(const MunitParameter params[], void* data) {
+  const int MAX_PARTS = 8;
+  const int MAX_PART_VERTICES = 16;
+  float vertices[3*24];
+  int indices[3*36];
+  float* positions = malloc(MAX_PARTS*MAX_PART_VERTICES*3*sizeof(float));
+  int* outIndices = malloc(MAX_PARTS*3*(2*MAX_PART_VERTICES - 4)*sizeof(int));
+  int parts[8*4], otherParts[8*4];
+  HullThreadPool* pool = hullThreadPoolCreate(4);
+  HullThreadPool* single = hullThreadPoolCreate(1);
+
+  // a box is convex, and stays whole
+  const float min[] = { 0.f, 0.f, 0.f };
+  const float max[] = { 2.f, 1.f, 1.f };
+  int numIndices = addBox(vertices, indices, 0, min, max);
+  munit_assert_int(generateConvexDecomposition(pool, positions, outIndices, parts, vertices, 24, indices, numIndices, MAX_PARTS, MAX_PART_VERTICES, 32, .01f), ==, 1);
+  munit_assert_int(parts[0], ==, 0);
+  munit_assert_int(parts[1], ==, 8);
+  munit_assert_int(parts[3], ==, 36);
+  for (int i = 0; i < parts[1]*3; i++) {
+    const float expected = positions[i] > .5f ? max[i % 3] : 0.f;
+    munit_assert_float(fabsf(positions[i] - expected), <, 1e-5f);
+  }
+
+  // the hull of a U covers the gap, the parts must not
+  numIndices = makeU(vertices, indices);
+  const int numParts = generateConvexDecomposition(pool, positions, outIndices, parts, vertices, 3*24, indices, numIndices, MAX_PARTS, MAX_PART_VERTICES, 30, .01f);
+  munit_assert_int(numParts, >=, 3);
+  munit_assert_int(numParts, <=, MAX_PARTS);
+
+  const float gap[] = { 1.5f, 2.f, .5f };
+  const float inside[][3] = { {.5f,.5f,.5f}, {1.5f,.5f,.5f}, {2.5f,.5f,.5f}, {.5f,2.5f,.5f}, {2.5f,2.5f,.5f} };
+  int numVertices = 0, numPartIndices = 0;
+
+  for (int i = 0; i < numParts; i++) {
+    const int* part = parts + i*4;
+    munit_assert_int(part[0], ==, numVertices);
+    munit_assert_int(part[2], ==, numPartIndices);
+    munit_assert_int(part[1], >=, 4);
+    munit_assert_int(part[1], <=, MAX_PART_VERTICES);
+    numVertices += part[1];
+    numPartIndices += part[3];
+
+    munit_assert_false(isInsidePart(positions, outIndices, part, gap));
+    for (int j = 0; j < part[1]*3; j++) {
+      munit_assert_float(positions[part[0]*3 + j], >=, 0.f);
+      munit_assert_float(positions[part[0]*3 + j], <=, 3.f);
+    }
+  }
+
+  for (int i = 0; i < 5; i++) {
+    bool isCovered = false;
+    for (int j = 0; j < numParts; j++) {
+      isCovered = isCovered || isInsidePart(positions, outIndices, parts + j*4, inside[i]);
+    }
+    munit_assert_true(isCovered);
+  }
+
+  // the same parts whatever the number of threads
+  const int numSingleParts = generateConvexDecomposition(single, positions, outIndices, otherParts, vertices, 3*24, indices, numIndices, MAX_PARTS, MAX_PART_VERTICES, 30, .01f);
+  munit_assert_int(numSingleParts, ==, numParts);
+  munit_assert_memory_equal(numParts*4*sizeof(int), parts, otherParts);
+
+  // one part is the hull, with a vertex budget
+  munit_assert_int(generateConvexDecomposition(pool, positions, outIndices, parts, vertices, 3*24, indices, numIndices, 1, 4, 30, .01f), ==, 1);
+  munit_assert_int(parts[1], ==, 4);
+  munit_assert_int(parts[3], ==, 12);
+
+  // no triangles, an index out of range, or flat
+  munit_assert_int(generateConvexDecomposition(pool, positions, outIndices, parts, vertices, 3*24, indices, 0, MAX_PARTS, MAX_PART_VERTICES, 30, .01f), ==, -1);
+  indices[0] = 3*24;
+  munit_assert_int(generateConvexDecomposition(pool, positions, outIndices, parts, vertices, 3*24, indices, numIndices, MAX_PARTS, MAX_PART_VERTICES, 30, .01f), ==, -1);
+  const float square[] = { 0.f,0.f,0.f, 1.f,0.f,0.f, 1.f,1.f,0.f };
+  const int triangle[] = { 0, 3, 6 };
+  munit_assert_int(generateConvexDecomposition(pool, positions, outIndices, parts, square, 9, triangle, 3, MAX_PARTS, MAX_PART_VERTICES, 30, .01f), ==, -2);
+
+  hullThreadPoolDestroy(single);
+  hullThreadPoolDestroy(pool);
+  free(outIndices);
+  free(positions);
+
+  return MUNIT_OK;
+}
+
+static MunitTest test_suite_tests[] = {
+  {(char*)"voxelizeMesh", test_voxelizeMesh, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"calcHullVolume", test_calcHullVolume, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"calcVoxelHullVolume", test_calcVoxelHullVolume, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"generateConvexDecomposition", test_generateConvexDecomposition, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+};
+
+static const MunitSuite test_suite = {
+  (char*)"",
+  test_suite_tests,
+  NULL,
+  1,
+  MUNIT_SUITE_OPTION_NONE
+};
+
+int main(int argc, char* argv[MUNIT_ARRAY_PARAM(argc + 1)]) {
+  return munit_suite_main(&test_suite, (void*)"unit", argc, argv);
+}
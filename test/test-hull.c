@@ -164,6 +164,36 @@ test_areCoplanar(const MunitParameter params[], void* data) {
   return MUNIT_OK;
 }
 
+static MunitResult
+test_orient3d(const MunitParameter params[], void* data) {
+  const float a[] = {0.f,0.f,0.f};
+  const float b[] = {1.f,0.f,0.f};
+  const float c[] = {0.f,1.f,0.f};
+  const float above[] = {.3f,.3f,1e-30f};
+  const float below[] = {.3f,.3f,-1e-30f};
+  const float on[] = {.3f,.3f,0.f};
+
+  munit_assert_double( orient3d(a, b, c, above), >, 0. );
+  munit_assert_double( orient3d(a, b, c, below), <, 0. );
+  munit_assert_double( orient3d(a, b, c, on), ==, 0. );
+  munit_assert_double( orient3d(a, a, c, above), ==, 0. );
+
+  // all on the plane z = x + y, but the determinant is 1024 when calculated in double precision
+  const float d[] = {2072239.f,991498.f,3063737.f};
+  const float e[] = {2962173.f,2416612.f,5378785.f};
+  const float f[] = {1578408.f,615934.f,2194342.f};
+  const float onPlane[] = {2632261.f,3648053.f,6280314.f};
+  const float abovePlane[] = {2632261.f,3648053.f,6280315.f};
+  const float belowPlane[] = {2632261.f,3648053.f,6280313.f};
+
+  munit_assert_double( orient3d(d, e, f, onPlane), ==, 0. );
+  munit_assert_double( orient3dExact(d, e, f, onPlane), ==, 0. );
+  munit_assert_double( orient3d(d, e, f, abovePlane)*orient3d(d, e, f, belowPlane), <, 0. );
+  munit_assert_double( orient3d(d, e, f, abovePlane), ==, -orient3d(e, d, f, abovePlane) );
+
+  return MUNIT_OK;
+}
+
 static MunitResult
 test_centroidFromIndices(const MunitParameter params[], void* data) {
   const float verts[] = {1.f,2.f,3.f, 4.f,5.f,6.f, 7.f,8.f,9.f, -3.f,-2.f,-1.f};
@@ -273,8 +303,8 @@ test_calcFacingFaces(const MunitParameter params[], void* data) {
   const int NUM_FACES = 3;
 
   float centroid[] = {0.f,0.f,0.f};
-  float faceNormals[NUM_FACES*3] = {0.f};
-  int faceIndices[NUM_FACES*3] = {0};
+  float faceNormals[3*3] = {0.f};
+  int faceIndices[3*3] = {0};
   int outFaces[] = {-1,-1,-1};
 
   centroidFromIndices(centroid, verts, vertIndices, NUM_VERTS);
@@ -285,7 +315,7 @@ test_calcFacingFaces(const MunitParameter params[], void* data) {
   const int numFaces0 = calcFacingFaces(NULL, NULL, NULL, NULL, 0, NULL);
   munit_assert_int(numFaces0, ==, 0);
 
-  const float point1[] = {.5f,0.f,1.f};
+  const float point1[] = {.5f,0.f,1.f}; // on the plane of face 2
   const int numFaces1 = calcFacingFaces(outFaces, verts, faceIndices, faceNormals, NUM_FACES, point1);
   munit_assert_int(numFaces1, ==, 1);
   munit_assert_int(outFaces[0], ==, 1);
@@ -297,7 +327,48 @@ test_calcFacingFaces(const MunitParameter params[], void* data) {
 }
 
 static MunitResult
-test_generateHullTriangles(const MunitParameter params[], void* data) {
+test_planeKernels(const MunitParameter params[], void* data) {
+  const int NUM_PLANES = 11; // enough for a vector loop and a scalar tail
+  float nx[11], ny[11], nz[11], d[11];
+  HullPlanes planes = {nx, ny, nz, d};
+  int outPlanes[11];
+  float distance = 0.f;
+
+  // planes x = i facing +x, except plane 7 which is y = 20 facing +y
+  for (int i = 0; i < NUM_PLANES; i++) {
+    const float normal[] = {1.f,0.f,0.f};
+    const float point[] = {i,0.f,0.f};
+    setPlane(&planes, i, normal, point);
+  }
+  const float normal7[] = {0.f,1.f,0.f};
+  const float point7[] = {0.f,20.f,0.f};
+  setPlane(&planes, 7, normal7, point7);
+
+  const float point1[] = {5.5f,0.f,0.f};
+  const int result1[] = {0,1,2,3,4,5};
+  munit_assert_float( planeDistance(&planes, 2, point1), ==, 3.5f );
+  munit_assert_int( calcFacingPlanes(outPlanes, &planes, NUM_PLANES, point1, 0.f), ==, 6 );
+  munit_assert_memory_equal( sizeof(result1), outPlanes, result1 );
+  munit_assert_int( calcFacingPlanes(outPlanes, &planes, NUM_PLANES, point1, 2.f), ==, 4 );
+  munit_assert_int( calcFacingPlanes(outPlanes, &planes, 0, point1, 0.f), ==, 0 );
+
+  munit_assert_int( calcFarthestPlane(&distance, &planes, NUM_PLANES, point1), ==, 0 );
+  munit_assert_float( distance, ==, 5.5f );
+
+  const float point2[] = {-1.f,30.f,0.f};
+  munit_assert_int( calcFarthestPlane(&distance, &planes, NUM_PLANES, point2), ==, 7 );
+  munit_assert_float( distance, ==, 10.f );
+
+  const float point3[] = {-30.f,0.f,0.f};
+  munit_assert_int( calcFarthestPlane(&distance, &planes, NUM_PLANES, point3), ==, 7 );
+  munit_assert_float( distance, ==, -20.f );
+  munit_assert_int( calcFarthestPlane(&distance, &planes, 3, point3), ==, 0 );
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_generateHullTrianglesLegacy(const MunitParameter params[], void* data) {
   const float verts[] = {-1.f,-1.f,-1.f, -1.f,-1.f,1.f, -1.f,1.f,-1.f, -1.f,1.f,1.f, 1.f,-1.f,-1.f, 1.f,-1.f,1.f, 1.f,1.f,-1.f, 1.f,1.f,1.f};
   const int numVerts = sizeof(verts)/sizeof(float);
   float verts2[114] = {0.f};
@@ -305,7 +376,7 @@ test_generateHullTriangles(const MunitParameter params[], void* data) {
 
   int outIndices[128];
 
-  const int numIndices1 = generateHullTriangles(outIndices, verts, numVerts, 3);
+  const int numIndices1 = generateHullTrianglesLegacy(outIndices, verts, numVerts, 3);
   const int result1[] = {0,6,12,0,12,3,0,3,6,9,3,15,6,3,9,3,12,15,12,6,18,6,9,18,15,12,18,9,15,21,15,18,21,18,9,21};
   munit_assert_int(numIndices1, ==, 36);
   munit_assert_memory_equal( sizeof(result1), outIndices, result1 );
@@ -315,7 +386,7 @@ test_generateHullTriangles(const MunitParameter params[], void* data) {
   }
   memcpy(verts2 + 90, verts, sizeof(verts));
 
-  const int numIndices2 = generateHullTriangles(outIndices, verts2, numVerts2, 3);
+  const int numIndices2 = generateHullTrianglesLegacy(outIndices, verts2, numVerts2, 3);
   const int result2[] = {90,93,96,96,99,102,105,108,111};
   const int numResults2 = sizeof(result2)/sizeof(int);
   munit_assert_int(numIndices2, ==, 36);
@@ -329,6 +400,1461 @@ test_generateHullTriangles(const MunitParameter params[], void* data) {
   return MUNIT_OK;
 }
 
+static MunitResult
+test_generateHullTriangles(const MunitParameter params[], void* data) {
+  const float verts[] = {-1.f,-1.f,-1.f, -1.f,-1.f,1.f, -1.f,1.f,-1.f, -1.f,1.f,1.f, 1.f,-1.f,-1.f, 1.f,-1.f,1.f, 1.f,1.f,-1.f, 1.f,1.f,1.f};
+  const int numVerts = sizeof(verts)/sizeof(float);
+  float verts2[114] = {0.f};
+  const int numVerts2 = sizeof(verts2)/sizeof(float);
+  float verts3[64*3] = {0.f};
+  const int numVerts3 = sizeof(verts3)/sizeof(float);
+  const float plane[] = {0.f,0.f,0.f, 1.f,0.f,0.f, 0.f,1.f,0.f, 1.f,1.f,0.f, .5f,.5f,0.f};
+  const float line[] = {0.f,0.f,0.f, 1.f,1.f,1.f, 2.f,2.f,2.f, 3.f,3.f,3.f};
+
+  int outIndices[1024];
+
+  munit_assert_int(generateHullTriangles(outIndices, verts, 9, 3), ==, -1);
+  munit_assert_int(generateHullTriangles(outIndices, plane, sizeof(plane)/sizeof(float), 3), ==, 12);
+  munit_assert_int(generateHullTriangles(outIndices, line, sizeof(line)/sizeof(float), 3), ==, -2);
+
+  const int numIndices1 = generateHullTriangles(outIndices, verts, numVerts, 3);
+  const int result1[] = {0,3,6,9,12,15,18,21};
+  munit_assert_int(numIndices1, ==, 36);
+  for (int i = 0; i < numIndices1; i++) {
+    munit_assert_int(indexOfInt(result1, 8, outIndices[i]), !=, -1);
+  }
+
+  for (int i = 0; i < 90; i++) {
+    verts2[i] = munit_rand_double() - .5f;
+  }
+  memcpy(verts2 + 90, verts, sizeof(verts));
+
+  const int numIndices2 = generateHullTriangles(outIndices, verts2, numVerts2, 3);
+  const int result2[] = {90,93,96,99,102,105,108,111};
+  munit_assert_int(numIndices2, ==, 36);
+  for (int i = 0; i < numIndices2; i++) {
+    munit_assert_int(indexOfInt(result2, 8, outIndices[i]), !=, -1);
+  }
+
+  // a point far outside the cube sees the whole top of the hull
+  const float apex[] = {0.f,0.f,10.f};
+  memcpy(verts2, verts, sizeof(verts));
+  memcpy(verts2 + numVerts, apex, sizeof(apex));
+
+  const int numIndices4 = generateHullTriangles(outIndices, verts2, numVerts + 3, 3);
+  munit_assert_int(numIndices4, ==, (2*9 - 4)*3);
+  munit_assert_int(indexOfInt(outIndices, numIndices4, numVerts), !=, -1);
+
+  // every point of a sphere is on the hull, and every point must be behind every face
+  for (int i = 0; i < numVerts3; i += 3) {
+    const float y = 1.f - (i/3 + .5f)*2.f/64.f;
+    const float r = sqrtf(1.f - y*y);
+    const float theta = (i/3)*2.39996323f;
+    verts3[i] = r*cosf(theta);
+    verts3[i+1] = y;
+    verts3[i+2] = r*sinf(theta);
+  }
+
+  const int numIndices3 = generateHullTriangles(outIndices, verts3, numVerts3, 3);
+  munit_assert_int(numIndices3, ==, (2*64 - 4)*3);
+  for (int i = 0; i < numIndices3; i += 3) {
+    float normal[] = {0.f,0.f,0.f};
+    float delta[] = {0.f,0.f,0.f};
+    setFromCoplanarPoints(normal, verts3 + outIndices[i], verts3 + outIndices[i+1], verts3 + outIndices[i+2]);
+    for (int j = 0; j < numVerts3; j += 3) {
+      munit_assert_float( dot(normal, sub(delta, verts3 + j, verts3 + outIndices[i])), <, 1e-5f );
+    }
+  }
+
+  // more faces than the legacy builder can hold
+  const int NUM_SPHERE_POINTS = MAX_FACES/2 + 1000;
+  float* sphere = malloc(NUM_SPHERE_POINTS*3*sizeof(float));
+  int* sphereIndices = malloc(calcMaxHullIndices(NUM_SPHERE_POINTS*3, 3)*sizeof(int));
+  for (int i = 0; i < NUM_SPHERE_POINTS; i++) {
+    const float y = 1.f - (i + .5f)*2.f/NUM_SPHERE_POINTS;
+    const float r = sqrtf(1.f - y*y);
+    sphere[i*3] = r*cosf(i*2.39996323f);
+    sphere[i*3+1] = y;
+    sphere[i*3+2] = r*sinf(i*2.39996323f);
+  }
+  munit_assert_int(generateHullTriangles(sphereIndices, sphere, NUM_SPHERE_POINTS*3, 3), >, MAX_FACES*3);
+  free(sphere);
+  free(sphereIndices);
+
+  return MUNIT_OK;
+}
+
+// every point is on or behind every face
+static void assertPointsInsideHull(const int* indices, const int numIndices, const float* verts, const int numVerts) {
+  for (int i = 0; i < numIndices; i += 3) {
+    for (int j = 0; j < numVerts; j += 3) {
+      munit_assert_double( orient3d(verts + indices[i], verts + indices[i+1], verts + indices[i+2], verts + j), <=, 0. );
+    }
+  }
+}
+
+// every vertex is a corner of the hull, so its faces lie in at least 3 different planes
+static void assertVerticesAreCorners(const int* indices, const int numIndices, const float* verts) {
+  int planes[3];
+
+  for (int i = 0; i < numIndices; i++) {
+    int numPlanes = 0;
+
+    for (int j = 0; j < numIndices && numPlanes < 3; j += 3) {
+      const int* face = indices + j;
+      if (face[0] != indices[i] && face[1] != indices[i] && face[2] != indices[i]) {
+        continue;
+      }
+
+      bool isNewPlane = true;
+      for (int k = 0; k < numPlanes && isNewPlane; k++) {
+        const int* other = indices + planes[k];
+        isNewPlane = orient3d(verts + other[0], verts + other[1], verts + other[2], verts + face[0]) != 0. ||
+          orient3d(verts + other[0], verts + other[1], verts + other[2], verts + face[1]) != 0. ||
+          orient3d(verts + other[0], verts + other[1], verts + other[2], verts + face[2]) != 0.;
+      }
+
+      if (isNewPlane) {
+        planes[numPlanes++] = j;
+      }
+    }
+
+    munit_assert_int(numPlanes, ==, 3);
+  }
+}
+
+static int countHullVertices(const int* indices, const int numIndices) {
+  int numVertices = 0;
+  for (int i = 0; i < numIndices; i++) {
+    bool isFirst = true;
+    for (int j = 0; j < i && isFirst; j++) {
+      isFirst = indices[j] != indices[i];
+    }
+    numVertices += isFirst;
+  }
+  return numVertices;
+}
+
+// the quick hull, the warm build and the incremental hull all give the hull with only the corners as vertices
+static int assertMinimalHulls(HullContext* ctx, int* outIndices, const float* verts, const int numVerts) {
+  int* warmIndices = malloc(calcMaxHullIndices(numVerts, 3)*sizeof(int));
+  int* hullIndices = malloc(calcMaxHullIndices(numVerts, 3)*sizeof(int));
+  Hull* hull = hullCreate(0);
+
+  const int numIndices = generateHullTrianglesWithContext(ctx, outIndices, verts, numVerts, 3);
+  munit_assert_int(numIndices, >, 0);
+  assertVerticesAreCorners(outIndices, numIndices, verts);
+  assertPointsInsideHull(outIndices, numIndices, verts, numVerts);
+
+  // warm started from the hull of the first half of the points, which are not all corners of the final hull
+  const int numSeedIndices = generateHullTrianglesWithContext(ctx, warmIndices, verts, numVerts/6*3, 3);
+  munit_assert_int(generateHullTrianglesWarm(ctx, warmIndices, verts, numVerts, 3, warmIndices, numSeedIndices > 0 ? numSeedIndices : 0), ==, numIndices);
+  assertVerticesAreCorners(warmIndices, numIndices, verts);
+
+  // a few points at a time, so the earlier vertices end up inside the faces and edges of the later hull
+  for (int i = 0; i < numVerts; i += 5*3) {
+    hullInsertPoints(hull, verts + i, (numVerts - i < 5*3 ? numVerts - i : 5*3), 3);
+  }
+
+  munit_assert_int(hullGetTriangles(hull, hullIndices), ==, numIndices);
+  assertVerticesAreCorners(hullIndices, numIndices, hullGetVertices(hull));
+
+  hullDestroy(hull);
+  free(hullIndices);
+  free(warmIndices);
+  return numIndices;
+}
+
+static MunitResult
+test_degenerateHulls(const MunitParameter params[], void* data) {
+  float lattice[5*5*5*3];
+  float duplicates[8*40*3];
+  int outIndices[1024];
+
+  // a cube lattice, where most points are coplanar with a face of the hull
+  for (int i = 0; i < 5*5*5; i++) {
+    lattice[i*3] = (float)(i % 5)*.1f;
+    lattice[i*3+1] = (float)(i/5 % 5)*.1f;
+    lattice[i*3+2] = (float)(i/25)*.1f;
+  }
+
+  // every corner of a cube many times
+  for (int i = 0; i < 8*40; i++) {
+    duplicates[i*3] = i & 1 ? 1.f : -1.f;
+    duplicates[i*3+1] = i & 2 ? 1.f : -1.f;
+    duplicates[i*3+2] = i & 4 ? 1.f : -1.f;
+  }
+
+  const int numLattice = sizeof(lattice)/sizeof(float);
+  const int numDuplicates = sizeof(duplicates)/sizeof(float);
+
+  int numIndices = generateHullTriangles(outIndices, lattice, numLattice, 3);
+  munit_assert_int(numIndices, ==, 36);
+  assertPointsInsideHull(outIndices, numIndices, lattice, numLattice);
+
+  // only the corners of the box, however the hull is built
+  HullContext* ctx = hullContextCreate(0, 0);
+  munit_assert_int(assertMinimalHulls(ctx, outIndices, lattice, numLattice), ==, 36);
+  munit_assert_int(countHullVertices(outIndices, 36), ==, 8);
+
+  // random points of the lattice, where many of the vertices found along the way are inside a face or an edge
+  float points[60*3];
+  for (int trial = 0; trial < 50; trial++) {
+    const int numPoints = munit_rand_int_range(8, 60);
+    for (int i = 0; i < numPoints; i++) {
+      memcpy(points + i*3, lattice + munit_rand_int_range(0, 5*5*5 - 1)*3, 3*sizeof(float));
+    }
+
+    if (calcInitialSimplex((int[4]){0}, points, numPoints*3, 3) == 4) {
+      assertMinimalHulls(ctx, outIndices, points, numPoints*3);
+    }
+  }
+
+  hullContextDestroy(ctx);
+
+  numIndices = generateHullTriangles(outIndices, duplicates, numDuplicates, 3);
+  munit_assert_int(numIndices, ==, 36);
+  assertPointsInsideHull(outIndices, numIndices, duplicates, numDuplicates);
+
+  // the legacy builder adds points in order, so it can keep points which later become coplanar
+  numIndices = generateHullTrianglesLegacy(outIndices, lattice, numLattice, 3);
+  munit_assert_int(numIndices, >=, 36);
+  munit_assert_int(numIndices, <=, (2*5*5*5 - 4)*3);
+  assertPointsInsideHull(outIndices, numIndices, lattice, numLattice);
+
+  numIndices = generateHullTrianglesLegacy(outIndices, duplicates, numDuplicates, 3);
+  munit_assert_int(numIndices, ==, 36);
+  assertPointsInsideHull(outIndices, numIndices, duplicates, numDuplicates);
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_planarHulls(const MunitParameter params[], void* data) {
+  const int NUM_POINTS = 1000;
+  float* verts = malloc(NUM_POINTS*4*sizeof(float));
+  int* outIndices = malloc((2*NUM_POINTS - 4)*3*sizeof(int));
+  int* quickIndices = malloc((2*NUM_POINTS - 4)*3*sizeof(int));
+  int* faceSizes = malloc((2*NUM_POINTS - 4)*sizeof(int));
+  float* planes = malloc((2*NUM_POINTS - 4)*4*sizeof(float));
+  int numFaces = 0;
+
+  // stride of 4, on the tilted plane z = x + 2y with coordinates in eighths, so every point is exactly coplanar
+  for (int i = 0; i < NUM_POINTS*4; i += 4) {
+    verts[i] = (munit_rand_int_range(-32, 32))/8.f;
+    verts[i+1] = (munit_rand_int_range(-32, 32))/8.f;
+    verts[i+2] = verts[i] + 2.f*verts[i+1];
+    verts[i+3] = -1.f;
+  }
+
+  const int numIndices = generateHullTrianglesLegacy(outIndices, verts, NUM_POINTS*4, 4);
+  const int numLoop = numIndices/6 + 2;
+
+  // a fan on each side of the polygon, which the quick hull builds in the same order
+  munit_assert_int(numIndices, >, 0);
+  munit_assert_int(generateHullTriangles(quickIndices, verts, NUM_POINTS*4, 4), ==, numIndices);
+  munit_assert_memory_equal(numIndices*sizeof(int), quickIndices, outIndices);
+
+  // the corners of the front fan turn the same way, without any collinear corners, and every point is on the
+  // inside of every edge. The plane is not vertical, so the turns can be found from x and y
+  int* loop = faceSizes;
+  loop[0] = outIndices[0];
+  for (int i = 0; i < numLoop - 2; i++) {
+    loop[i + 1] = outIndices[i*3 + 1];
+    loop[i + 2] = outIndices[i*3 + 2];
+  }
+
+  float side = 0.f;
+  for (int i = 0; i < numLoop; i++) {
+    const float* a = verts + loop[i];
+    const float* b = verts + loop[(i + 1) % numLoop];
+    const float* c = verts + loop[(i + 2) % numLoop];
+    const float turn = (b[0] - a[0])*(c[1] - a[1]) - (b[1] - a[1])*(c[0] - a[0]);
+    side = i == 0 ? turn : side;
+    munit_assert_float(turn*side, >, 0.f);
+
+    for (int j = 0; j < NUM_POINTS*4; j += 4) {
+      const float* p = verts + j;
+      munit_assert_float(((b[0] - a[0])*(p[1] - a[1]) - (b[1] - a[1])*(p[0] - a[0]))*side, >=, 0.f);
+    }
+  }
+
+  // the back fan is the front fan turned over
+  for (int i = 0; i < numIndices/2; i += 3) {
+    munit_assert_int(outIndices[numIndices/2 + i], ==, outIndices[i]);
+    munit_assert_int(outIndices[numIndices/2 + i + 1], ==, outIndices[i + 2]);
+    munit_assert_int(outIndices[numIndices/2 + i + 2], ==, outIndices[i + 1]);
+  }
+
+  // one polygon for each side
+  HullContext* ctx = hullContextCreate(0, 0);
+  munit_assert_int(generateHullPolygons(ctx, outIndices, faceSizes, planes, &numFaces, verts, NUM_POINTS*4, 4, 0.f), ==, 2*numLoop);
+  munit_assert_int(numFaces, ==, 2);
+  munit_assert_int(faceSizes[0], ==, numLoop);
+  munit_assert_float(planes[0]*planes[4] + planes[1]*planes[5] + planes[2]*planes[6], <, -.99f);
+
+  // collinear points have no hull
+  for (int i = 0; i < NUM_POINTS*4; i += 4) {
+    verts[i+1] = verts[i];
+    verts[i+2] = verts[i];
+  }
+  munit_assert_int(generateHullTrianglesLegacy(outIndices, verts, NUM_POINTS*4, 4), ==, -2);
+  munit_assert_int(generateHullTriangles(outIndices, verts, NUM_POINTS*4, 4), ==, -2);
+  munit_assert_int(generateHullTrianglesWithContext(ctx, outIndices, verts, NUM_POINTS*4, 4), ==, -2);
+
+  hullContextDestroy(ctx);
+  free(verts);
+  free(outIndices);
+  free(quickIndices);
+  free(faceSizes);
+  free(planes);
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_hullContext(const MunitParameter params[], void* data) {
+  const float verts[] = {-1.f,-1.f,-1.f, -1.f,-1.f,1.f, -1.f,1.f,-1.f, -1.f,1.f,1.f, 1.f,-1.f,-1.f, 1.f,-1.f,1.f, 1.f,1.f,-1.f, 1.f,1.f,1.f};
+  const int numVerts = sizeof(verts)/sizeof(float);
+  const int NUM_POINTS = 500;
+  float* verts2 = malloc(NUM_POINTS*3*sizeof(float));
+  int* outIndices = malloc((2*NUM_POINTS - 4)*3*sizeof(int));
+
+  HullContext* ctx = hullContextCreate(0, 0);
+  munit_assert_not_null(ctx);
+  munit_assert_int(hullContextHighWaterFaces(ctx), ==, 0);
+
+  munit_assert_int(generateHullTrianglesWithContext(ctx, outIndices, verts, 9, 3), ==, -1);
+  munit_assert_int(generateHullTrianglesWithContext(ctx, outIndices, verts, numVerts, 3), ==, 36);
+  munit_assert_int(generateHullTrianglesWithContext(ctx, outIndices, verts, numVerts, 3), ==, 36);
+  munit_assert_int(hullContextHighWaterPoints(ctx), ==, 8);
+
+  // points on a sphere need more faces than the initial capacity
+  for (int i = 0; i < NUM_POINTS*3; i += 3) {
+    const float y = 1.f - (i/3 + .5f)*2.f/NUM_POINTS;
+    const float r = sqrtf(1.f - y*y);
+    const float theta = (i/3)*2.39996323f;
+    verts2[i] = r*cosf(theta);
+    verts2[i+1] = y;
+    verts2[i+2] = r*sinf(theta);
+  }
+
+  munit_assert_int(generateHullTrianglesWithContext(ctx, outIndices, verts2, NUM_POINTS*3, 3), ==, (2*NUM_POINTS - 4)*3);
+  munit_assert_int(hullContextHighWaterFaces(ctx), >=, 2*NUM_POINTS - 4);
+  munit_assert_int(hullContextHighWaterPoints(ctx), ==, NUM_POINTS);
+  munit_assert_int(hullContextHighWaterBytes(ctx), >, 0);
+
+  hullContextReset(ctx);
+  munit_assert_int(hullContextHighWaterFaces(ctx), ==, 0);
+  munit_assert_int(generateHullTrianglesWithContext(ctx, outIndices, verts, numVerts, 3), ==, 36);
+  munit_assert_int(hullContextHighWaterFaces(ctx), <, 2*NUM_POINTS - 4);
+
+  hullContextDestroy(ctx);
+  free(verts2);
+  free(outIndices);
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_hullContextGetStats(const MunitParameter params[], void* data) {
+  const int NUM_POINTS = 2000;
+  float* verts = malloc(NUM_POINTS*3*sizeof(float));
+  int* outIndices = malloc((2*NUM_POINTS - 4)*3*sizeof(int));
+  float square[] = {0,0,0, 1,0,0, 0,1,0, 1,1,0, .5f,.5f,0};
+
+  for (int i = 0; i < NUM_POINTS*3; i += 3) {
+    do {
+      verts[i] = munit_rand_double()*2.f - 1.f;
+      verts[i+1] = munit_rand_double()*2.f - 1.f;
+      verts[i+2] = munit_rand_double()*2.f - 1.f;
+    } while (dot(verts + i, verts + i) > 1.f);
+  }
+
+  HullContext* ctx = hullContextCreate(0, 0);
+  const HullStats* stats = hullContextGetStats(ctx);
+
+  // counts only, every point other than the simplex is either added to the hull or dropped
+  const int numIndices = generateHullTrianglesWithContext(ctx, outIndices, verts, NUM_POINTS*3, 3);
+  munit_assert_double(stats->numPoints, ==, NUM_POINTS);
+  munit_assert_double(stats->numCulledPoints, ==, 0.);
+  munit_assert_double(stats->numExpansions + stats->numDroppedPoints, ==, NUM_POINTS - 4);
+  munit_assert_double(stats->numFacesCreated - stats->numFacesDestroyed, ==, numIndices/3);
+  munit_assert_double(stats->peakLiveFaces, >=, numIndices/3);
+  munit_assert_double(stats->numHorizonEdges, >=, 3.*stats->numExpansions);
+  munit_assert_double(stats->maxHorizonEdges, >=, 3.);
+  munit_assert_double(stats->numVisibleFaces, >=, stats->numExpansions);
+  munit_assert_double(stats->extremesSeconds + stats->seedSeconds + stats->visibilitySeconds + stats->horizonSeconds + stats->rebuildSeconds, ==, 0.);
+
+  // timed, and with culling
+  hullContextSetFlags(ctx, HULL_COLLECT_STATS | HULL_CULL_INTERIOR);
+  munit_assert_int(generateHullTrianglesWithContext(ctx, outIndices, verts, NUM_POINTS*3, 3), ==, numIndices);
+  munit_assert_double(stats->numCulledPoints, >, 0.);
+  munit_assert_double(stats->numExpansions + stats->numDroppedPoints + stats->numCulledPoints, ==, NUM_POINTS - 4);
+  munit_assert_double(stats->extremesSeconds, >=, 0.);
+  munit_assert_double(stats->seedSeconds, >=, 0.);
+  munit_assert_double(stats->visibilitySeconds + stats->horizonSeconds + stats->rebuildSeconds, >, 0.);
+
+  // a planar hull is built without expanding
+  munit_assert_int(generateHullTrianglesWithContext(ctx, outIndices, square, 5*3, 3), ==, 4*3);
+  munit_assert_double(stats->numPoints, ==, 5.);
+  munit_assert_double(stats->numExpansions, ==, 0.);
+  munit_assert_double(stats->numFacesCreated, ==, 4.);
+
+  hullContextDestroy(ctx);
+  free(verts);
+  free(outIndices);
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_calcKDopExtremes(const MunitParameter params[], void* data) {
+  const float verts[] = {-1.f,-1.f,-1.f, -1.f,-1.f,1.f, -1.f,1.f,-1.f, -1.f,1.f,1.f, 1.f,-1.f,-1.f, 1.f,-1.f,1.f, 1.f,1.f,-1.f, 1.f,1.f,1.f, 0.f,0.f,0.f};
+  int out[26];
+
+  munit_assert_int( calcKDopExtremes(out, NULL, 0, 3), ==, 0 );
+  munit_assert_int( calcKDopExtremes(out, verts, sizeof(verts)/sizeof(float), 3), ==, 8 );
+  munit_assert_int( indexOfInt(out, 8, 24), ==, -1 );
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_cullInterior(const MunitParameter params[], void* data) {
+  const int NUM_POINTS = 2000;
+  float* verts = malloc(NUM_POINTS*3*sizeof(float));
+  int* outIndices = malloc((2*NUM_POINTS - 4)*3*sizeof(int));
+  int* outIndices2 = malloc((2*NUM_POINTS - 4)*3*sizeof(int));
+
+  // a dense ball, where most points are inside the k-DOP polytope
+  for (int i = 0; i < NUM_POINTS*3; i += 3) {
+    do {
+      verts[i] = munit_rand_double()*2.f - 1.f;
+      verts[i+1] = munit_rand_double()*2.f - 1.f;
+      verts[i+2] = munit_rand_double()*2.f - 1.f;
+    } while (dot(verts + i, verts + i) > 1.f);
+  }
+
+  HullContext* ctx = hullContextCreate(0, 0);
+  const int numIndices1 = generateHullTrianglesWithContext(ctx, outIndices, verts, NUM_POINTS*3, 3);
+
+  hullContextSetFlags(ctx, HULL_CULL_INTERIOR);
+  munit_assert_int(hullContextGetFlags(ctx), ==, HULL_CULL_INTERIOR);
+  const int numIndices2 = generateHullTrianglesWithContext(ctx, outIndices2, verts, NUM_POINTS*3, 3);
+
+  // culled points are strictly inside the hull, so the result is the same hull
+  munit_assert_int(numIndices1, >, 0);
+  munit_assert_int(numIndices2, ==, numIndices1);
+  for (int i = 0; i < numIndices2; i++) {
+    munit_assert_int(indexOfInt(outIndices, numIndices1, outIndices2[i]), !=, -1);
+  }
+
+  hullContextDestroy(ctx);
+  free(verts);
+  free(outIndices);
+  free(outIndices2);
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_generateHullTrianglesParallel(const MunitParameter params[], void* data) {
+  const int NUM_POINTS = 20000;
+  float* verts = malloc(NUM_POINTS*3*sizeof(float));
+  int* outIndices = malloc((2*NUM_POINTS - 4)*3*sizeof(int));
+  int* outIndices2 = malloc((2*NUM_POINTS - 4)*3*sizeof(int));
+
+  for (int i = 0; i < NUM_POINTS*3; i += 3) {
+    do {
+      verts[i] = munit_rand_double()*2.f - 1.f;
+      verts[i+1] = munit_rand_double()*2.f - 1.f;
+      verts[i+2] = munit_rand_double()*2.f - 1.f;
+    } while (dot(verts + i, verts + i) > 1.f);
+  }
+
+  HullThreadPool* pool = hullThreadPoolCreate(4);
+  HullContext* ctx = hullContextCreate(0, 0);
+  munit_assert_not_null(pool);
+  munit_assert_int(hullThreadPoolSize(pool), >=, 1);
+
+  const int numIndices1 = generateHullTrianglesWithContext(ctx, outIndices, verts, NUM_POINTS*3, 3);
+  const int numIndices2 = generateHullTrianglesParallel(pool, ctx, outIndices2, verts, NUM_POINTS*3, 3);
+
+  // same hull, but the triangles may be in a different order
+  munit_assert_int(numIndices1, >, 0);
+  munit_assert_int(numIndices2, ==, numIndices1);
+  for (int i = 0; i < numIndices2; i++) {
+    munit_assert_int(indexOfInt(outIndices, numIndices1, outIndices2[i]), !=, -1);
+  }
+
+  // points on a grid in a ball, with many duplicates and many points on the faces of the hull. The vertices are
+  // the same points as the serial build's, though they may be different duplicates
+  for (int i = 0; i < NUM_POINTS*3; i += 3) {
+    do {
+      verts[i] = munit_rand_int_range(-8, 8)/8.f;
+      verts[i+1] = munit_rand_int_range(-8, 8)/8.f;
+      verts[i+2] = munit_rand_int_range(-8, 8)/8.f;
+    } while (dot(verts + i, verts + i) > 1.f);
+  }
+
+  const int numGridIndices = generateHullTrianglesWithContext(ctx, outIndices, verts, NUM_POINTS*3, 3);
+  munit_assert_int(numGridIndices, >, 0);
+  munit_assert_int(generateHullTrianglesParallel(pool, ctx, outIndices2, verts, NUM_POINTS*3, 3), ==, numGridIndices);
+  for (int i = 0; i < numGridIndices; i++) {
+    const float* p = verts + outIndices2[i];
+    bool isSerialVertex = false;
+    for (int j = 0; j < numGridIndices && !isSerialVertex; j++) {
+      const float* q = verts + outIndices[j];
+      isSerialVertex = p[0] == q[0] && p[1] == q[1] && p[2] == q[2];
+    }
+    munit_assert_true(isSerialVertex);
+  }
+
+  // small inputs are built serially
+  munit_assert_int(generateHullTrianglesParallel(pool, ctx, outIndices2, verts, 100*3, 3), ==, generateHullTrianglesWithContext(ctx, outIndices, verts, 100*3, 3));
+  munit_assert_int(generateHullTrianglesParallel(pool, ctx, outIndices2, verts, 3*3, 3), ==, -1);
+
+  hullContextDestroy(ctx);
+  hullThreadPoolDestroy(pool);
+  free(verts);
+  free(outIndices);
+  free(outIndices2);
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_generateHullTrianglesBatch(const MunitParameter params[], void* data) {
+  const int NUM_MESHES = 6;
+  const int NUM_POINTS = 200;
+  int meshTable[NUM_MESHES*2];
+  int results[NUM_MESHES*2];
+  float* verts = malloc(NUM_MESHES*NUM_POINTS*3*sizeof(float));
+  int numVertices = 0;
+
+  for (int mesh = 0; mesh < NUM_MESHES; mesh++) {
+    // mesh 1 is coplanar (a planar hull) and mesh 3 has too few points
+    const int numPoints = mesh == 3 ? 3 : NUM_POINTS - mesh*10;
+    meshTable[mesh*2] = numVertices;
+    meshTable[mesh*2 + 1] = numPoints*3;
+
+    for (int i = 0; i < numPoints; i++, numVertices += 3) {
+      verts[numVertices] = munit_rand_double()*2.f - 1.f + mesh*4.f;
+      verts[numVertices + 1] = munit_rand_double()*2.f - 1.f;
+      verts[numVertices + 2] = mesh == 1 ? 0.f : munit_rand_double()*2.f - 1.f;
+    }
+  }
+
+  const int capacity = calcBatchIndexCapacity(meshTable, NUM_MESHES, 3);
+  int* outIndices = malloc(capacity*sizeof(int));
+  int* expected = malloc(capacity*sizeof(int));
+  HullThreadPool* pool = hullThreadPoolCreate(3);
+  HullContext* ctx = hullContextCreate(0, 0);
+
+  const int numIndices = generateHullTrianglesBatch(pool, outIndices, results, verts, meshTable, NUM_MESHES, 3, 0);
+
+  // the same as building each mesh on its own, packed together
+  int firstIndex = 0;
+  for (int mesh = 0; mesh < NUM_MESHES; mesh++) {
+    const int numExpected = generateHullTrianglesWithContext(ctx, expected, verts + meshTable[mesh*2], meshTable[mesh*2 + 1], 3);
+    munit_assert_int(results[mesh*2], ==, firstIndex);
+    munit_assert_int(results[mesh*2 + 1], ==, numExpected);
+    if (numExpected > 0) {
+      munit_assert_memory_equal(numExpected*sizeof(int), outIndices + firstIndex, expected);
+      firstIndex += numExpected;
+    }
+  }
+
+  munit_assert_int(results[1*2 + 1], >, 0);
+  munit_assert_int(results[3*2 + 1], ==, -1);
+  munit_assert_int(numIndices, ==, firstIndex);
+
+  hullContextDestroy(ctx);
+  hullThreadPoolDestroy(pool);
+  free(verts);
+  free(outIndices);
+  free(expected);
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_hullInsertPoints(const MunitParameter params[], void* data) {
+  const int NUM_POINTS = 2000;
+  const int CHUNK = 100;
+  float* verts = malloc(NUM_POINTS*3*sizeof(float));
+  int* outIndices = malloc((2*NUM_POINTS - 4)*3*sizeof(int));
+  int* outIndices2 = malloc((2*NUM_POINTS - 4)*3*sizeof(int));
+  float flat[] = {0,0,0, 1,0,0, 0,1,0, 1,1,0, .5f,-1,0};
+
+  for (int i = 0; i < NUM_POINTS*3; i += 3) {
+    do {
+      verts[i] = munit_rand_double()*2.f - 1.f;
+      verts[i+1] = munit_rand_double()*2.f - 1.f;
+      verts[i+2] = munit_rand_double()*2.f - 1.f;
+    } while (dot(verts + i, verts + i) > 1.f);
+  }
+
+  Hull* hull = hullCreate(0);
+  HullContext* ctx = hullContextCreate(0, 0);
+
+  // no hull until there are enough points, then a planar hull which grows in its plane
+  munit_assert_int(hullInsertPoints(hull, flat, 2*3, 3), ==, -1);
+  munit_assert_int(hullNumIndices(hull), ==, 0);
+  munit_assert_int(hullInsertPoints(hull, flat + 2*3, 2*3, 3), ==, 4);
+  munit_assert_int(hullInsertPoints(hull, flat + 4*3, 3, 3), ==, 6);
+  munit_assert_int(hullGetTriangles(hull, outIndices), ==, 18);
+  munit_assert_int(indexOfInt(outIndices, 18, 4*3), !=, -1);
+
+  // each insert gives the same hull as building from all of the points so far
+  for (int i = 0; i < NUM_POINTS; i += CHUNK) {
+    const int numTriangles = hullInsertPoints(hull, verts + i*3, CHUNK*3, 3);
+    const int numIndices1 = generateHullTrianglesWithContext(ctx, outIndices, hullGetVertices(hull), hullNumVertices(hull), 3);
+    const int numIndices2 = hullGetTriangles(hull, outIndices2);
+
+    munit_assert_int(numTriangles*3, ==, hullNumIndices(hull));
+    munit_assert_int(numIndices2, ==, hullNumIndices(hull));
+    munit_assert_int(numIndices2, ==, numIndices1);
+    for (int j = 0; j < numIndices2; j++) {
+      munit_assert_int(indexOfInt(outIndices, numIndices1, outIndices2[j]), !=, -1);
+    }
+  }
+
+  munit_assert_int(hullNumVertices(hull), ==, (NUM_POINTS + 5)*3);
+
+  // compacting after each insert keeps just the hull vertices, and ends with the same hull
+  const int numIndices = generateHullTrianglesWithContext(ctx, outIndices, verts, NUM_POINTS*3, 3);
+  Hull* stream = hullCreate(0);
+  float line[] = {0,0,1, 0,0,3, 0,0,2, 0,0,-1, 0,0,0};
+
+  munit_assert_int(hullInsertPoints(stream, line, 5*3, 3), ==, -2);
+  munit_assert_int(hullCompact(stream), ==, 2);
+  munit_assert_int(hullInsertPoints(stream, flat + 3, 3*3, 3), ==, 6);
+  munit_assert_int(hullCompact(stream), ==, 5);
+  munit_assert_int(hullInsertPoints(stream, flat, 3, 3), ==, 6);
+  munit_assert_int(hullCompact(stream), ==, 5);
+  hullDestroy(stream);
+
+  stream = hullCreate(0);
+  for (int i = 0; i < NUM_POINTS; i += CHUNK) {
+    const int numTriangles = hullInsertPoints(stream, verts + i*3, CHUNK*3, 3);
+    const int numKept = hullCompact(stream);
+    const int numIndices2 = hullGetTriangles(stream, outIndices2);
+
+    munit_assert_int(numTriangles, >, 0);
+    munit_assert_int(numKept*3, ==, hullNumVertices(stream));
+    munit_assert_int(numIndices2, ==, numTriangles*3);
+    munit_assert_int(2*numKept - 4, ==, numTriangles);
+  }
+
+  munit_assert_int(hullGetTriangles(stream, outIndices2), ==, numIndices);
+  for (int i = 0; i < numIndices; i++) {
+    const float* p = hullGetVertices(stream) + outIndices2[i];
+    bool isHullVertex = false;
+    for (int j = 0; j < numIndices && !isHullVertex; j++) {
+      const float* q = verts + outIndices[j];
+      isHullVertex = p[0] == q[0] && p[1] == q[1] && p[2] == q[2];
+    }
+    munit_assert_true(isHullVertex);
+  }
+
+  hullDestroy(stream);
+
+  // points on a grid in a box, where most of the points are on a face of the hull, with the corners of the box
+  // spread through the stream. The compacted stream and the whole set both give just the box
+  for (int i = 0; i < NUM_POINTS*3; i++) {
+    verts[i] = munit_rand_int_range(-16, 16)/8.f;
+  }
+
+  for (int i = 0; i < 8; i++) {
+    float* corner = verts + (i*NUM_POINTS/8 + CHUNK/2)*3;
+    corner[0] = i & 1 ? 2.f : -2.f;
+    corner[1] = i & 2 ? 2.f : -2.f;
+    corner[2] = i & 4 ? 2.f : -2.f;
+  }
+
+  munit_assert_int(generateHullTrianglesWithContext(ctx, outIndices, verts, NUM_POINTS*3, 3), ==, 36);
+
+  stream = hullCreate(HULL_CULL_INTERIOR);
+  for (int i = 0; i < NUM_POINTS; i += CHUNK) {
+    const int numTriangles = hullInsertPoints(stream, verts + i*3, CHUNK*3, 3);
+    munit_assert_int(2*hullCompact(stream) - 4, ==, numTriangles);
+  }
+
+  munit_assert_int(hullNumVertices(stream), ==, 8*3);
+  munit_assert_int(hullGetTriangles(stream, outIndices2), ==, 36);
+  assertVerticesAreCorners(outIndices2, 36, hullGetVertices(stream));
+
+  hullDestroy(stream);
+  hullContextDestroy(ctx);
+  hullDestroy(hull);
+  free(verts);
+  free(outIndices);
+  free(outIndices2);
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_generateHullTrianglesWarm(const MunitParameter params[], void* data) {
+  const int GRID = 16;
+  const int MAX_POINTS = GRID*GRID*GRID;
+  float* verts = malloc(MAX_POINTS*3*sizeof(float));
+  int* outIndices = malloc((2*MAX_POINTS - 4)*3*sizeof(int));
+  int* prevIndices = malloc((2*MAX_POINTS - 4)*3*sizeof(int));
+  int numPoints = 0;
+
+  // jittered grid points inside a ball, in grid order so neighbouring points are close together
+  for (int i = 0; i < MAX_POINTS; i++) {
+    float* v = verts + numPoints*3;
+    v[0] = ((i % GRID) + munit_rand_double())*2.f/GRID - 1.f;
+    v[1] = ((i/GRID % GRID) + munit_rand_double())*2.f/GRID - 1.f;
+    v[2] = ((i/GRID/GRID) + munit_rand_double())*2.f/GRID - 1.f;
+    numPoints += dot(v, v) <= 1.f ? 1 : 0;
+  }
+
+  HullContext* ctx = hullContextCreate(0, 0);
+  int numPrevIndices = generateHullTrianglesWithContext(ctx, prevIndices, verts, numPoints*3, 3);
+
+  // each frame squashes the points a little more, and the warm start gives the same hull as a normal build
+  for (int frame = 1; frame < 10; frame++) {
+    for (int i = 0; i < numPoints*3; i += 3) {
+      verts[i] *= 1.f + 0.02f*verts[i + 1];
+    }
+
+    const int numIndices1 = generateHullTrianglesWithContext(ctx, outIndices, verts, numPoints*3, 3);
+    const int numIndices2 = generateHullTrianglesWarm(ctx, prevIndices, verts, numPoints*3, 3, prevIndices, numPrevIndices);
+
+    munit_assert_int(numIndices1, >, 0);
+    munit_assert_int(numIndices2, ==, numIndices1);
+    for (int j = 0; j < numIndices2; j++) {
+      munit_assert_int(indexOfInt(outIndices, numIndices1, prevIndices[j]), !=, -1);
+    }
+
+    numPrevIndices = numIndices2;
+  }
+
+  // bad seeds are ignored, and with too few seeds it is a normal build
+  const int badSeeds[] = {-3, 1, numPoints*3, 0, 0, 0};
+  const int numIndices1 = generateHullTrianglesWithContext(ctx, outIndices, verts, numPoints*3, 3);
+  munit_assert_int(generateHullTrianglesWarm(ctx, prevIndices, verts, numPoints*3, 3, badSeeds, 6), ==, numIndices1);
+  munit_assert_int(generateHullTrianglesWarm(ctx, prevIndices, verts, numPoints*3, 3, NULL, 0), ==, numIndices1);
+  munit_assert_int(generateHullTrianglesWarm(ctx, prevIndices, verts, 2*3, 3, badSeeds, 6), ==, -1);
+
+  hullContextDestroy(ctx);
+  free(verts);
+  free(outIndices);
+  free(prevIndices);
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_generateCompactHull(const MunitParameter params[], void* data) {
+  const int NUM_POINTS = 500;
+  float* verts = malloc(NUM_POINTS*4*sizeof(float));
+  int* outIndices = malloc((2*NUM_POINTS - 4)*3*sizeof(int));
+  int* compactIndices = malloc((2*NUM_POINTS - 4)*3*sizeof(int));
+  float* positions = malloc(NUM_POINTS*4*sizeof(float));
+  int numHullVertices = 0;
+
+  // stride of 4, points on a sphere so every point is on the hull
+  for (int i = 0; i < NUM_POINTS*4; i += 4) {
+    do {
+      verts[i] = munit_rand_double()*2.f - 1.f;
+      verts[i+1] = munit_rand_double()*2.f - 1.f;
+      verts[i+2] = munit_rand_double()*2.f - 1.f;
+    } while (dot(verts + i, verts + i) > 1.f || dot(verts + i, verts + i) < .01f);
+    multiplyScalar(verts + i, verts + i, 1.f/sqrtf(dot(verts + i, verts + i)));
+    verts[i+3] = -1.f;
+  }
+
+  HullContext* ctx = hullContextCreate(0, 0);
+  const int numIndices1 = generateHullTrianglesWithContext(ctx, outIndices, verts, NUM_POINTS*4, 4);
+  const int numIndices2 = generateCompactHull(ctx, positions, compactIndices, &numHullVertices, verts, NUM_POINTS*4, 4);
+
+  // same triangles, with uint16_t indices into the compact positions
+  munit_assert_int(numIndices2, ==, numIndices1);
+  munit_assert_int(numHullVertices, ==, NUM_POINTS);
+
+  const uint16_t* indices16 = (const uint16_t*)compactIndices;
+  for (int i = 0; i < numIndices2; i++) {
+    munit_assert_int(indices16[i], <, numHullVertices);
+    munit_assert_memory_equal(3*sizeof(float), positions + indices16[i]*3, verts + outIndices[i]);
+  }
+
+  // no hull, no vertices
+  munit_assert_int(generateCompactHull(ctx, positions, compactIndices, &numHullVertices, verts, 2*4, 4), ==, -1);
+  munit_assert_int(numHullVertices, ==, 0);
+
+  hullContextDestroy(ctx);
+  free(verts);
+  free(outIndices);
+  free(compactIndices);
+  free(positions);
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_generateHullTrianglesBudget(const MunitParameter params[], void* data) {
+  const int NUM_POINTS = 2000;
+  float* verts = malloc(NUM_POINTS*3*sizeof(float));
+  int* outIndices = malloc((2*NUM_POINTS - 4)*3*sizeof(int));
+  int* hullVertices = malloc(NUM_POINTS*sizeof(int));
+  float maxDistance = -1.f;
+  float prevMaxDistance = FLT_MAX;
+
+  // points inside a ball
+  for (int i = 0; i < NUM_POINTS*3; i += 3) {
+    do {
+      verts[i] = munit_rand_double()*2.f - 1.f;
+      verts[i+1] = munit_rand_double()*2.f - 1.f;
+      verts[i+2] = munit_rand_double()*2.f - 1.f;
+    } while (dot(verts + i, verts + i) > 1.f);
+  }
+
+  HullContext* ctx = hullContextCreate(0, 0);
+  const int numFullIndices = generateHullTrianglesWithContext(ctx, outIndices, verts, NUM_POINTS*3, 3);
+
+  // fewer vertices, and the points missed are never further in front of the hull than maxDistance
+  const int budgets[] = {4, 8, 16, 32, 64};
+  for (int b = 0; b < 5; b++) {
+    const int numIndices = generateHullTrianglesBudget(ctx, outIndices, &maxDistance, verts, NUM_POINTS*3, 3, budgets[b], 0);
+    munit_assert_int(numIndices, >, 0);
+    munit_assert_int(writeHullVertices(ctx, hullVertices), <=, budgets[b]);
+    munit_assert_float(maxDistance, >, 0.f);
+    munit_assert_float(maxDistance, <, prevMaxDistance);
+
+    for (int i = 0; i < numIndices; i += 3) {
+      float normal[3] = {0.f,0.f,0.f};
+      setFromCoplanarPoints(normal, verts + outIndices[i], verts + outIndices[i+1], verts + outIndices[i+2]);
+      const float d = dot(normal, verts + outIndices[i]);
+      for (int j = 0; j < NUM_POINTS*3; j += 3) {
+        munit_assert_float(dot(normal, verts + j) - d, <=, maxDistance + 1e-5f);
+      }
+    }
+
+    prevMaxDistance = maxDistance;
+  }
+
+  // the face budget is 2*maxVertices - 4
+  munit_assert_int(generateHullTrianglesBudget(ctx, outIndices, &maxDistance, verts, NUM_POINTS*3, 3, 0, 21), <=, 20*3);
+  munit_assert_int(generateHullTrianglesBudget(ctx, outIndices, &maxDistance, verts, NUM_POINTS*3, 3, 10, 100), <=, 16*3);
+
+  // a large budget, or no budget, is the full hull
+  munit_assert_int(generateHullTrianglesBudget(ctx, outIndices, &maxDistance, verts, NUM_POINTS*3, 3, NUM_POINTS, 0), ==, numFullIndices);
+  munit_assert_float(maxDistance, ==, 0.f);
+  munit_assert_int(generateHullTrianglesBudget(ctx, outIndices, &maxDistance, verts, NUM_POINTS*3, 3, 0, 0), ==, numFullIndices);
+  munit_assert_float(maxDistance, ==, 0.f);
+
+  munit_assert_int(generateHullTrianglesBudget(ctx, outIndices, &maxDistance, verts, 2*3, 3, 16, 0), ==, -1);
+
+  // points in a disk on the plane z = x + 2y, with coordinates in eighths so they are exactly coplanar. The
+  // polygon keeps to the budget too, and the points are no further outside it than maxDistance
+  for (int i = 0; i < NUM_POINTS*3; i += 3) {
+    do {
+      verts[i] = munit_rand_int_range(-32, 32)/8.f;
+      verts[i+1] = munit_rand_int_range(-32, 32)/8.f;
+    } while (verts[i]*verts[i] + verts[i+1]*verts[i+1] > 16.f);
+    verts[i+2] = verts[i] + 2.f*verts[i+1];
+  }
+
+  const float planeNormal[] = { 1.f, 2.f, -1.f };
+  const int numPlanarIndices = generateHullTrianglesWithContext(ctx, outIndices, verts, NUM_POINTS*3, 3);
+  const int numCorners = numPlanarIndices/6 + 2;
+  munit_assert_int(numCorners, >, 16);
+  prevMaxDistance = FLT_MAX;
+
+  const int planarBudgets[] = {4, 8, 16};
+  for (int b = 0; b < 3; b++) {
+    const int numIndices = generateHullTrianglesBudget(ctx, outIndices, &maxDistance, verts, NUM_POINTS*3, 3, planarBudgets[b], 0);
+    const int numLoop = numIndices/6 + 2;
+    munit_assert_int(numLoop, ==, planarBudgets[b]);
+    munit_assert_int(writeHullVertices(ctx, hullVertices), ==, planarBudgets[b]);
+    munit_assert_float(maxDistance, >, 0.f);
+    munit_assert_float(maxDistance, <, prevMaxDistance);
+
+    // the corners of the front fan, and the distance outside each side of the polygon, in the plane
+    int loop[16];
+    loop[0] = outIndices[0];
+    for (int i = 0; i < numLoop - 2; i++) {
+      loop[i + 1] = outIndices[i*3 + 1];
+      loop[i + 2] = outIndices[i*3 + 2];
+    }
+
+    for (int i = 0; i < numLoop; i++) {
+      const float* a = verts + loop[i];
+      const float* c = verts + loop[(i + 2) % numLoop];
+      float side[3], outward[3], offset[3];
+      normalize(outward, cross(outward, sub(side, verts + loop[(i + 1) % numLoop], a), planeNormal));
+      if (dot(sub(offset, c, a), outward) > 0.f) {
+        multiplyScalar(outward, outward, -1.f);
+      }
+
+      for (int j = 0; j < NUM_POINTS*3; j += 3) {
+        munit_assert_float(dot(sub(offset, verts + j, a), outward), <=, maxDistance + 1e-5f);
+      }
+    }
+
+    prevMaxDistance = maxDistance;
+  }
+
+  munit_assert_int(generateHullTrianglesBudget(ctx, outIndices, &maxDistance, verts, NUM_POINTS*3, 3, 0, 0), ==, numPlanarIndices);
+  munit_assert_float(maxDistance, ==, 0.f);
+  munit_assert_int(generateHullTrianglesBudget(ctx, outIndices, &maxDistance, verts, NUM_POINTS*3, 3, 0, 12), ==, 12*3);
+
+  hullContextDestroy(ctx);
+  free(verts);
+  free(outIndices);
+  free(hullVertices);
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_hullCache(const MunitParameter params[], void* data) {
+  const int NUM_POINTS = 500;
+  const int NUM_MESHES = 3;
+  float* verts = malloc(NUM_MESHES*NUM_POINTS*3*sizeof(float));
+  int* expected = malloc(NUM_MESHES*(2*NUM_POINTS - 4)*3*sizeof(int));
+  int* outIndices = malloc((2*NUM_POINTS - 4)*3*sizeof(int));
+  int numExpected[3];
+  float line[] = {0,0,0, 1,1,1, 2,2,2, 3,3,3};
+
+  // the reference XXH64 values, serialized caches depend on them
+  munit_assert_true(xxh64("", 0, 0) == 0xEF46DB3751D8E999ull);
+  munit_assert_true(xxh64("abc", 3, 0) == 0x44BC2CF5AD770999ull);
+  munit_assert_true(xxh64("Nobody inspects the spammish repetition", 39, 0) == 0xFBCEA83C8A378BF1ull);
+
+  for (int i = 0; i < NUM_MESHES*NUM_POINTS*3; i++) {
+    verts[i] = munit_rand_double()*2.f - 1.f;
+  }
+
+  HullContext* ctx = hullContextCreate(0, 0);
+  for (int m = 0; m < NUM_MESHES; m++) {
+    numExpected[m] = generateHullTrianglesWithContext(ctx, expected + m*(2*NUM_POINTS - 4)*3, verts + m*NUM_POINTS*3, NUM_POINTS*3, 3);
+  }
+
+  #define ASSERT_CACHED(mesh, numHits, numMisses) do { \
+    munit_assert_int(generateHullTrianglesCached(cache, ctx, outIndices, verts + (mesh)*NUM_POINTS*3, NUM_POINTS*3, 3), ==, numExpected[mesh]); \
+    munit_assert_memory_equal(numExpected[mesh]*sizeof(int), outIndices, expected + (mesh)*(2*NUM_POINTS - 4)*3); \
+    munit_assert_int(hullCacheHits(cache), ==, numHits); \
+    munit_assert_int(hullCacheMisses(cache), ==, numMisses); \
+  } while (0)
+
+  // repeats are hits, and different vertices, strides or flags are misses
+  HullCache* cache = hullCacheCreate(1 << 20);
+  ASSERT_CACHED(0, 0, 1);
+  ASSERT_CACHED(0, 1, 1);
+  ASSERT_CACHED(1, 1, 2);
+  ASSERT_CACHED(1, 2, 2);
+  munit_assert_int(generateHullTrianglesCached(cache, ctx, outIndices, line, 12, 3), ==, -2);
+  munit_assert_int(generateHullTrianglesCached(cache, ctx, outIndices, line, 12, 3), ==, -2);
+  munit_assert_int(generateHullTrianglesCached(cache, ctx, outIndices, verts, NUM_POINTS*3, 6), >, 0);
+  hullContextSetFlags(ctx, HULL_CULL_INTERIOR);
+  munit_assert_int(generateHullTrianglesCached(cache, ctx, outIndices, verts, NUM_POINTS*3, 3), ==, numExpected[0]);
+  hullContextSetFlags(ctx, 0);
+  munit_assert_int(hullCacheHits(cache), ==, 3);
+  munit_assert_int(hullCacheMisses(cache), ==, 5);
+  munit_assert_int(hullCacheNumEntries(cache), ==, 5);
+
+  // a serialized cache gives the same hits, in the same order of use
+  const int numBytes = hullCacheSerializedBytes(cache);
+  uint8_t* bytes = malloc(numBytes);
+  munit_assert_int(hullCacheSerialize(cache, bytes), ==, numBytes);
+
+  HullCache* loaded = hullCacheCreate(1 << 20);
+  munit_assert_int(hullCacheDeserialize(loaded, bytes, numBytes), ==, 5);
+  munit_assert_int(hullCacheDeserialize(loaded, bytes, numBytes), ==, 0);
+  munit_assert_int(hullCacheBytes(loaded), ==, hullCacheBytes(cache));
+  munit_assert_int(hullCacheDeserialize(loaded, bytes, numBytes - 4), ==, -1);
+  bytes[0] ^= 1;
+  munit_assert_int(hullCacheDeserialize(loaded, bytes, numBytes), ==, -1);
+  bytes[0] ^= 1;
+
+  // entries which no build could give are skipped: an index past the vertices, one between them, and more
+  // indices than a hull of the vertices can have
+  const int firstIndex = (HULL_CACHE_HEADER_INTS + HULL_CACHE_ENTRY_INTS)*4;
+  const int32_t badIndices[] = { NUM_POINTS*3, 1 };
+  for (int i = 0; i < 2; i++) {
+    HullCache* corrupt = hullCacheCreate(1 << 20);
+    uint8_t* p = bytes + firstIndex;
+    writeInt32(&p, badIndices[i]);
+    munit_assert_int(hullCacheDeserialize(corrupt, bytes, numBytes), ==, 4);
+    hullCacheDestroy(corrupt);
+  }
+  munit_assert_int(hullCacheSerialize(cache, bytes), ==, numBytes);
+
+  uint8_t tooMany[(HULL_CACHE_HEADER_INTS + HULL_CACHE_ENTRY_INTS + 15)*4] = {0};
+  uint8_t* p = tooMany;
+  const int32_t header[] = { HULL_CACHE_MAGIC, HULL_CACHE_VERSION, 1, 7, 0, 12, 3, 0, 15 };
+  for (int i = 0; i < 9; i++) {
+    writeInt32(&p, header[i]);
+  }
+  HullCache* corrupt = hullCacheCreate(1 << 20);
+  munit_assert_int(hullCacheDeserialize(corrupt, tooMany, sizeof(tooMany)), ==, 0);
+  munit_assert_int(hullCacheNumEntries(corrupt), ==, 0);
+  hullCacheDestroy(corrupt);
+
+  hullCacheDestroy(cache);
+  cache = loaded;
+  ASSERT_CACHED(1, 1, 0);
+  ASSERT_CACHED(0, 2, 0);
+
+  // collecting stats doesn't change the triangles, so it still hits
+  hullContextSetFlags(ctx, HULL_COLLECT_STATS);
+  ASSERT_CACHED(1, 3, 0);
+  hullContextSetFlags(ctx, 0);
+
+  // with room for any two meshes but not all three, the least recently used is dropped
+  hullCacheDestroy(cache);
+  const int smallest = numExpected[0] < numExpected[1] ? (numExpected[0] < numExpected[2] ? 0 : 2) : (numExpected[1] < numExpected[2] ? 1 : 2);
+  const int maxBytes = (numExpected[0] + numExpected[1] + numExpected[2] - numExpected[smallest] + 64)*sizeof(int) + 2*sizeof(HullCacheEntry);
+  cache = hullCacheCreate(maxBytes);
+  ASSERT_CACHED(0, 0, 1);
+  ASSERT_CACHED(1, 0, 2);
+  ASSERT_CACHED(0, 1, 2);
+  ASSERT_CACHED(2, 1, 3);
+  munit_assert_int(hullCacheNumEntries(cache), ==, 2);
+  munit_assert_int(hullCacheBytes(cache), <=, maxBytes);
+  ASSERT_CACHED(0, 2, 3);
+  ASSERT_CACHED(1, 2, 4);
+
+  // dropping an entry moves another into its place, which keeps its place in the order of use
+  ASSERT_CACHED(2, 2, 5);
+  ASSERT_CACHED(1, 3, 5);
+  ASSERT_CACHED(0, 3, 6);
+  ASSERT_CACHED(1, 4, 6);
+  munit_assert_int(hullCacheNumEntries(cache), ==, 2);
+
+  #undef ASSERT_CACHED
+
+  hullCacheDestroy(cache);
+  hullContextDestroy(ctx);
+  free(bytes);
+  free(verts);
+  free(expected);
+  free(outIndices);
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_weldPoints(const MunitParameter params[], void* data) {
+  const int NUM_CELLS = 300;
+  const int COPIES = 5;
+  const int NUM_POINTS = NUM_CELLS*COPIES;
+  const float CELL = .01f;
+  float* verts = malloc(NUM_POINTS*4*sizeof(float));
+  int* kept = malloc(NUM_POINTS*sizeof(int));
+  int* outIndices = malloc((2*NUM_POINTS - 4)*3*sizeof(int));
+  int* expected = malloc((2*NUM_POINTS - 4)*3*sizeof(int));
+  int cells[300*3];
+
+  // stride of 4, copies of points near the centers of different cells, each jittered by less than half a cell
+  for (int i = 0; i < NUM_CELLS; i++) {
+    cells[i*3] = i - NUM_CELLS/2;
+    cells[i*3+1] = munit_rand_int_range(-100, 100);
+    cells[i*3+2] = munit_rand_int_range(-100, 100);
+  }
+
+  for (int i = 0; i < NUM_POINTS; i++) {
+    const int* cell = cells + (i % NUM_CELLS)*3;
+    for (int axis = 0; axis < 3; axis++) {
+      const float jitter = i < NUM_CELLS ? 0.f : (munit_rand_double() - .5f)*.8f;
+      verts[i*4 + axis] = (cell[axis] + .5f + jitter)*CELL;
+    }
+    verts[i*4 + 3] = -1.f;
+  }
+
+  HullContext* ctx = hullContextCreate(0, 0);
+
+  // the first point in each cell is kept
+  munit_assert_int(weldPoints(ctx, kept, verts, NUM_POINTS*4, 4, CELL), ==, NUM_CELLS);
+  for (int i = 0; i < NUM_CELLS; i++) {
+    munit_assert_int(kept[i], ==, i*4);
+  }
+
+  // without a cell size only identical points are welded, and 0 is the same as -0
+  munit_assert_int(weldPoints(ctx, kept, verts, NUM_POINTS*4, 4, 0.f), ==, NUM_POINTS);
+  memcpy(verts + NUM_CELLS*4, verts, NUM_CELLS*4*sizeof(float));
+  verts[0] = verts[1] = verts[2] = 0.f;
+  verts[NUM_CELLS*4] = verts[NUM_CELLS*4 + 1] = verts[NUM_CELLS*4 + 2] = -0.f;
+  munit_assert_int(weldPoints(ctx, kept, verts, NUM_POINTS*4, 4, 0.f), ==, NUM_POINTS - NUM_CELLS);
+
+  // the welded hull is the hull of the kept points, with offsets into the original vertices
+  const int numKept = weldPoints(ctx, kept, verts, NUM_POINTS*4, 4, CELL);
+  float* keptVerts = malloc(numKept*3*sizeof(float));
+  for (int i = 0; i < numKept; i++) {
+    memcpy(keptVerts + i*3, verts + kept[i], 3*sizeof(float));
+  }
+
+  const int numExpected = generateHullTrianglesWithContext(ctx, expected, keptVerts, numKept*3, 3);
+  const int numIndices = generateHullTrianglesWelded(ctx, outIndices, verts, NUM_POINTS*4, 4, CELL);
+  munit_assert_int(numIndices, >, 0);
+  munit_assert_int(numIndices, ==, numExpected);
+  for (int i = 0; i < numIndices; i++) {
+    munit_assert_int(outIndices[i], ==, kept[expected[i]/3]);
+  }
+
+  munit_assert_int(generateHullTrianglesWelded(ctx, outIndices, verts, 2*4, 4, CELL), ==, -1);
+
+  hullContextDestroy(ctx);
+  free(verts);
+  free(kept);
+  free(keptVerts);
+  free(outIndices);
+  free(expected);
+
+  return MUNIT_OK;
+}
+
+// every polygon is convex and counter-clockwise when seen from outside, and every point is behind every plane
+static void assertConvexPolygons(const int* indices, const int* faceSizes, const float* planes, const int numFaces, const float* verts, const int numVerts, const int stride) {
+  for (int face = 0, first = 0; face < numFaces; first += faceSizes[face++]) {
+    const int n = faceSizes[face];
+    const float* plane = planes + face*4;
+    float uv[] = {0.f,0.f,0.f};
+    float vw[] = {0.f,0.f,0.f};
+    float turn[] = {0.f,0.f,0.f};
+
+    munit_assert_int(n, >=, 3);
+    for (int i = 0; i < n; i++) {
+      sub(uv, verts + indices[first + (i + 1) % n], verts + indices[first + i]);
+      sub(vw, verts + indices[first + (i + 2) % n], verts + indices[first + (i + 1) % n]);
+      munit_assert_float( dot(cross(turn, uv, vw), plane), >, -1e-5f );
+    }
+
+    for (int j = 0; j < numVerts; j += stride) {
+      munit_assert_float( dot(plane, verts + j) - plane[3], <, 1e-5f );
+    }
+  }
+}
+
+static MunitResult
+test_generateHullPolygons(const MunitParameter params[], void* data) {
+  const float cube[] = {-1.f,-1.f,-1.f, -1.f,-1.f,1.f, -1.f,1.f,-1.f, -1.f,1.f,1.f, 1.f,-1.f,-1.f, 1.f,-1.f,1.f, 1.f,1.f,-1.f, 1.f,1.f,1.f};
+  const int NUM_POINTS = 500;
+  float* verts = malloc(NUM_POINTS*3*sizeof(float));
+  int* outIndices = malloc((2*NUM_POINTS - 4)*3*sizeof(int));
+  int* faceSizes = malloc((2*NUM_POINTS - 4)*sizeof(int));
+  float* planes = malloc((2*NUM_POINTS - 4)*4*sizeof(float));
+  int numFaces = 0;
+
+  // a cube with points inside, and a lattice with points on every face, both have 6 square faces
+  for (int i = 0; i < 100*3; i++) {
+    verts[i] = munit_rand_double()*2.f - 1.f;
+  }
+  memcpy(verts + 100*3, cube, sizeof(cube));
+
+  for (int i = 0; i < 5*5*5; i++) {
+    verts[108*3 + i*3] = (float)(i % 5)*.1f;
+    verts[108*3 + i*3+1] = (float)(i/5 % 5)*.1f;
+    verts[108*3 + i*3+2] = (float)(i/25)*.1f;
+  }
+
+  HullContext* ctx = hullContextCreate(0, 0);
+
+  for (int test = 0; test < 2; test++) {
+    const float* points = test == 0 ? verts : verts + 108*3;
+    const int numVerts = test == 0 ? 108*3 : 5*5*5*3;
+
+    munit_assert_int(generateHullPolygons(ctx, outIndices, faceSizes, planes, &numFaces, points, numVerts, 3, 0.f), ==, 6*4);
+    munit_assert_int(numFaces, ==, 6);
+    assertConvexPolygons(outIndices, faceSizes, planes, numFaces, points, numVerts, 3);
+
+    for (int face = 0; face < numFaces; face++) {
+      munit_assert_int(faceSizes[face], ==, 4);
+      munit_assert_float(fabsf(planes[face*4]) + fabsf(planes[face*4+1]) + fabsf(planes[face*4+2]), ==, 1.f);
+    }
+  }
+
+  // no coplanar points on a sphere, so nothing is merged unless there is an angle
+  for (int i = 0; i < NUM_POINTS*3; i += 3) {
+    do {
+      verts[i] = munit_rand_double()*2.f - 1.f;
+      verts[i+1] = munit_rand_double()*2.f - 1.f;
+      verts[i+2] = munit_rand_double()*2.f - 1.f;
+    } while (dot(verts + i, verts + i) > 1.f || dot(verts + i, verts + i) < .01f);
+    multiplyScalar(verts + i, verts + i, 1.f/sqrtf(dot(verts + i, verts + i)));
+  }
+
+  const int numIndices1 = generateHullPolygons(ctx, outIndices, faceSizes, planes, &numFaces, verts, NUM_POINTS*3, 3, 0.f);
+  munit_assert_int(numIndices1, ==, (2*NUM_POINTS - 4)*3);
+  munit_assert_int(numFaces, ==, 2*NUM_POINTS - 4);
+
+  const int numIndices2 = generateHullPolygons(ctx, outIndices, faceSizes, planes, &numFaces, verts, NUM_POINTS*3, 3, .3f);
+  munit_assert_int(numFaces, <, 2*NUM_POINTS - 4);
+  assertConvexPolygons(outIndices, faceSizes, planes, numFaces, verts, NUM_POINTS*3, 3);
+
+  int numFaceIndices = 0;
+  for (int face = 0; face < numFaces; face++) {
+    numFaceIndices += faceSizes[face];
+  }
+  munit_assert_int(numFaceIndices, ==, numIndices2);
+
+  munit_assert_int(generateHullPolygons(ctx, outIndices, faceSizes, planes, &numFaces, verts, 2*3, 3, 0.f), ==, -1);
+  munit_assert_int(numFaces, ==, 0);
+
+  hullContextDestroy(ctx);
+  free(verts);
+  free(outIndices);
+  free(faceSizes);
+  free(planes);
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_hullContainsPoints(const MunitParameter params[], void* data) {
+  const float cube[] = {-1.f,-1.f,-1.f, -1.f,-1.f,1.f, -1.f,1.f,-1.f, -1.f,1.f,1.f, 1.f,-1.f,-1.f, 1.f,-1.f,1.f, 1.f,1.f,-1.f, 1.f,1.f,1.f};
+  const int NUM_POINTS = 300;
+  const int NUM_TESTS = 1000;
+  float* verts = malloc(NUM_POINTS*3*sizeof(float));
+  float* tests = malloc(NUM_TESTS*3*sizeof(float));
+  int* outIndices = malloc((2*NUM_POINTS - 4)*3*sizeof(int));
+  uint8_t* mask = malloc(NUM_TESTS);
+
+  HullContext* ctx = hullContextCreate(0, 0);
+
+  // one plane per side of the cube, and points on the boundary are inside
+  HullQuery* query = generateHullQuery(ctx, cube, sizeof(cube)/sizeof(float), 3);
+  munit_assert_not_null(query);
+  munit_assert_int(hullQueryNumPlanes(query), ==, 6);
+
+  const float points[] = {0.f,0.f,0.f, .99f,-.99f,.5f, 1.f,1.f,1.f, 1.01f,0.f,0.f, 0.f,-2.f,0.f, 5.f,5.f,5.f};
+  const uint8_t expected[] = {1, 1, 1, 0, 0, 0};
+  munit_assert_int(hullContainsPoints(query, points, 6, mask), ==, 3);
+  munit_assert_memory_equal(sizeof(expected), mask, expected);
+  hullQueryDestroy(query);
+
+  // the same answers as testing against every triangle, for a random hull with more planes than a vector
+  for (int i = 0; i < NUM_POINTS*3; i++) {
+    verts[i] = munit_rand_double()*2.f - 1.f;
+  }
+  for (int i = 0; i < NUM_TESTS*3; i++) {
+    tests[i] = munit_rand_double()*2.4f - 1.2f;
+  }
+
+  const int numIndices = generateHullTrianglesWithContext(ctx, outIndices, verts, NUM_POINTS*3, 3);
+  query = generateHullQuery(ctx, verts, NUM_POINTS*3, 3);
+  munit_assert_not_null(query);
+  munit_assert_int(hullQueryNumPlanes(query), >, HULL_SIMD_WIDTH);
+  const int numInside = hullContainsPoints(query, tests, NUM_TESTS, mask);
+  int count = 0;
+
+  for (int i = 0; i < NUM_TESTS; i++) {
+    float minDistance = FLT_MAX;
+    bool isInside = true;
+    for (int j = 0; j < numIndices; j += 3) {
+      float normal[3];
+      const float* a = verts + outIndices[j];
+      setFromCoplanarPoints(normal, a, verts + outIndices[j+1], verts + outIndices[j+2]);
+      float offset[3];
+      const float distance = dot(normal, sub(offset, tests + i*3, a));
+      isInside = isInside && distance <= 0.f;
+      minDistance = fminf(minDistance, fabsf(distance));
+    }
+
+    // points within rounding of a face may go either way
+    if (minDistance > 1e-5f) {
+      munit_assert_int(mask[i], ==, isInside);
+    }
+    count += mask[i];
+  }
+
+  munit_assert_int(numInside, ==, count);
+  munit_assert_int(numInside, >, 0);
+  munit_assert_int(numInside, <, NUM_TESTS);
+
+  // empty planes, and no hull
+  munit_assert_null(hullQueryCreate(cube, 0));
+  munit_assert_null(generateHullQuery(ctx, cube, 3*3, 3));
+
+  hullQueryDestroy(query);
+  hullQueryDestroy(NULL);
+  hullContextDestroy(ctx);
+  free(verts);
+  free(tests);
+  free(outIndices);
+  free(mask);
+
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_hullRaycast(const MunitParameter params[], void* data) {
+  // unit normals and distances for the sides of a box from -1 to 1, with x from -2 to 2
+  const float planes[] = {1.f,0.f,0.f,2.f, -1.f,0.f,0.f,2.f, 0.f,1.f,0.f,1.f, 0.f,-1.f,0.f,1.f, 0.f,0.f,1.f,1.f, 0.f,0.f,-1.f,1.f};
+  const float rays[] = {
+    -5.f,0.f,0.f, 1.f,0.f,0.f, // enters the -x side at x = -2
+    0.f,5.f,.5f, 0.f,-2.f,0.f, // enters the +y side, t is in lengths of the direction
+    0.f,0.f,0.f, 0.f,0.f,1.f, // starts inside
+    -5.f,0.f,0.f, -1.f,0.f,0.f, // pointing away
+    -5.f,3.f,0.f, 1.f,0.f,0.f, // parallel to the +y side, outside
+    -5.f,0.f,3.f, 1.f,0.f,-2.f, // crosses the z slab before reaching the x slab
+    -3.f,-3.f,0.f, 1.f,1.f,0.f, // through the -x,-y edge
+  };
+  const float expectedT[] = {3.f, 2.f, 0.f, -1.f, -1.f, -1.f, 2.f};
+  const int expectedFaces[] = {1, 2, -1, -1, -1, -1, 3};
+  float t[7];
+  int faces[7];
+
+  HullQuery* query = hullQueryCreate(planes, 6);
+  munit_assert_not_null(query);
+  munit_assert_int(hullRaycast(query, rays, 7, t, faces), ==, 4);
+
+  for (int i = 0; i < 7; i++) {
+    munit_assert_float(fabsf(t[i] - expectedT[i]), <, 1e-6f);
+    if (i != 6) {
+      munit_assert_int(faces[i], ==, expectedFaces[i]);
+    }
+  }
+
+  // along the edge both planes give the same t
+  munit_assert_true(faces[6] == 1 || faces[6] == 3);
+
+  hullQueryDestroy(query);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_calcHullOrientedBox(const MunitParameter params[], void* data) {
+  const int NUM_POINTS = 500;
+  float* verts = malloc(NUM_POINTS*3*sizeof(float));
+  int* outIndices = malloc(calcMaxHullIndices(NUM_POINTS*3, 3)*sizeof(int));
+  float box[15];
+
+  // a 4x2x1 box, turned about z then x and moved, with the corners among random points inside it
+  const float c = cosf(.5f), s = sinf(.5f), c2 = cosf(.9f), s2 = sinf(.9f);
+  const float axes[9] = { c, s*c2, s*s2, -s, c*c2, c*s2, 0.f, -s2, c2 };
+  const float center[] = { 5.f, -3.f, 2.f };
+  const float halfExtents[] = { 2.f, 1.f, .5f };
+
+  for (int i = 0; i < NUM_POINTS; i++) {
+    float* p = verts + i*3;
+    memcpy(p, center, sizeof(center));
+    for (int k = 0; k < 3; k++) {
+      const float t = i < 8 ? ((i >> k & 1) ? 1.f : -1.f) : munit_rand_double()*2.f - 1.f;
+      scaleAndAdd(p, p, axes + k*3, t*halfExtents[k]);
+    }
+  }
+
+  const int numIndices = generateHullTriangles(outIndices, verts, NUM_POINTS*3, 3);
+  munit_assert_int(calcHullOrientedBox(box, verts, outIndices, numIndices), ==, 0);
+  munit_assert_float(fabsf(8.f*box[12]*box[13]*box[14] - 8.f), <, 1e-3f);
+
+  float cornerAxis[3];
+  munit_assert_float(fabsf(dot(cross(cornerAxis, box + 3, box + 6), box + 9) - 1.f), <, 1e-5f);
+  for (int k = 0; k < 3; k++) {
+    munit_assert_float(fabsf(box[k] - center[k]), <, 1e-4f);
+    munit_assert_float(fabsf(dot(box + 3 + k*3, box + 3 + k*3) - 1.f), <, 1e-5f);
+  }
+
+  // every point is inside
+  for (int i = 0; i < NUM_POINTS; i++) {
+    float offset[3];
+    sub(offset, verts + i*3, box);
+    for (int k = 0; k < 3; k++) {
+      munit_assert_float(fabsf(dot(offset, box + 3 + k*3)), <=, box[12 + k] + 1e-5f);
+    }
+  }
+
+  // an axis aligned box stays axis aligned
+  const float aligned[] = { 0.f,0.f,0.f, 3.f,0.f,0.f, 0.f,2.f,0.f, 3.f,2.f,0.f, 0.f,0.f,1.f, 3.f,0.f,1.f, 0.f,2.f,1.f, 3.f,2.f,1.f };
+  const int numAlignedIndices = generateHullTriangles(outIndices, aligned, 24, 3);
+  munit_assert_int(calcHullOrientedBox(box, aligned, outIndices, numAlignedIndices), ==, 0);
+  munit_assert_float(fabsf(box[0] - 1.5f), <, 1e-5f);
+  munit_assert_float(fabsf(box[1] - 1.f), <, 1e-5f);
+  munit_assert_float(fabsf(box[2] - .5f), <, 1e-5f);
+  munit_assert_float(fabsf(8.f*box[12]*box[13]*box[14] - 6.f), <, 1e-4f);
+
+  // a planar hull of a turned square gives a flat box around the square
+  const float square[] = { 0.f,0.f,0.f, c,s,0.f, c - s,s + c,0.f, -s,c,0.f };
+  const int numSquareIndices = generateHullTriangles(outIndices, square, 12, 3);
+  munit_assert_int(numSquareIndices, >, 0);
+  munit_assert_int(calcHullOrientedBox(box, square, outIndices, numSquareIndices), ==, 0);
+  munit_assert_float(box[14], <, 1e-5f);
+  munit_assert_float(fabsf(4.f*box[12]*box[13] - 1.f), <, 1e-4f);
+
+  // a 4x2 rectangle with near copies of two corners, as projected from the box above when its corners are
+  // rounded differently, still gives the 4x2 rectangle
+  PlanarPoint polygon[] = {
+    { -2.13460922f, -3.72426081f, 0 }, { -.216907263f, -7.23459148f, 1 }, { -.216907129f, -7.23459148f, 2 },
+    { 1.53825796f, -6.27574062f, 3 }, { -.379444271f, -2.76540995f, 4 }, { -.379444391f, -2.76540995f, 5 }
+  };
+  float side[2], size[2];
+  const int numCorners = mergeCloseCorners(polygon, 6);
+  munit_assert_int(numCorners, ==, 4);
+  munit_assert_float(fabsf(calcMinAreaRectangle(side, size, polygon, numCorners) - 8.f), <, 1e-4f);
+
+  munit_assert_int(calcHullOrientedBox(box, verts, outIndices, 0), ==, -1);
+
+  free(verts);
+  free(outIndices);
+  return MUNIT_OK;
+}
+
+static MunitResult
+test_calcHullBoundingSphere(const MunitParameter params[], void* data) {
+  const int NUM_POINTS = 2000;
+  float* verts = malloc(NUM_POINTS*3*sizeof(float));
+  int* outIndices = malloc(calcMaxHullIndices(NUM_POINTS*3, 3)*sizeof(int));
+  float sphere[4];
+
+  // points on a sphere of radius 3 around (1, 2, 3)
+  const float center[] = { 1.f, 2.f, 3.f };
+  for (int i = 0; i < NUM_POINTS; i++) {
+    float direction[3] = { munit_rand_double() - .5f, munit_rand_double() - .5f, munit_rand_double() - .5f };
+    normalize(direction, direction);
+    scaleAndAdd(verts + i*3, center, direction, 3.f);
+  }
+
+  int numIndices = generateHullTriangles(outIndices, verts, NUM_POINTS*3, 3);
+  munit_assert_int(calcHullBoundingSphere(sphere, verts, outIndices, numIndices), ==, 0);
+  munit_assert_float(fabsf(sphere[3] - 3.f), <, 1e-3f);
+  for (int k = 0; k < 3; k++) {
+    munit_assert_float(fabsf(sphere[k] - center[k]), <, 1e-3f);
+  }
+
+  // random points in a box, every point is inside, and the sphere touches at least 2 of them
+  for (int i = 0; i < NUM_POINTS*3; i++) {
+    verts[i] = munit_rand_double()*(i % 3 + 1.f);
+  }
+
+  numIndices = generateHullTriangles(outIndices, verts, NUM_POINTS*3, 3);
+  munit_assert_int(calcHullBoundingSphere(sphere, verts, outIndices, numIndices), ==, 0);
+  int numTouching = 0;
+  for (int i = 0; i < NUM_POINTS; i++) {
+    float offset[3];
+    const float distance = sqrtf(dot(sub(offset, verts + i*3, sphere), sub(offset, verts + i*3, sphere)));
+    munit_assert_float(distance, <=, sphere[3]);
+    numTouching += distance > sphere[3] - 1e-4f;
+  }
+  munit_assert_int(numTouching, >=, 2);
+
+  // the corners of a box are all on the sphere, which is coplanar in fours
+  const float cube[] = { -1.f,-1.f,-1.f, 1.f,-1.f,-1.f, -1.f,1.f,-1.f, 1.f,1.f,-1.f, -1.f,-1.f,1.f, 1.f,-1.f,1.f, -1.f,1.f,1.f, 1.f,1.f,1.f };
+  numIndices = generateHullTriangles(outIndices, cube, 24, 3);
+  munit_assert_int(calcHullBoundingSphere(sphere, cube, outIndices, numIndices), ==, 0);
+  munit_assert_float(fabsf(sphere[3] - sqrtf(3.f)), <, 1e-5f);
+  munit_assert_float(fabsf(sphere[0]) + fabsf(sphere[1]) + fabsf(sphere[2]), <, 1e-5f);
+
+  // an obtuse triangle of a planar hull is enclosed by its longest side
+  const float triangle[] = { -2.f,0.f,0.f, 2.f,0.f,0.f, 0.f,1.f,0.f, 0.f,.5f,0.f };
+  numIndices = generateHullTriangles(outIndices, triangle, 12, 3);
+  munit_assert_int(calcHullBoundingSphere(sphere, triangle, outIndices, numIndices), ==, 0);
+  munit_assert_float(fabsf(sphere[3] - 2.f), <, 1e-5f);
+
+  munit_assert_int(calcHullBoundingSphere(sphere, verts, outIndices, 0), ==, -1);
+
+  free(verts);
+  free(outIndices);
+  return MUNIT_OK;
+}
+
 static MunitResult
 test_ENDED(const MunitParameter params[], void* data) {
   return MUNIT_OK;
@@ -344,12 +1870,35 @@ static MunitTest test_suite_tests[] = {
   {(char*)"cross", test_cross, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
   {(char*)"setFromCoplanarPoints", test_setFromCoplanarPoints, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
   {(char*)"areCoplanar", test_areCoplanar, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"orient3d", test_orient3d, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
   {(char*)"centroidFromIndices", test_centroidFromIndices, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
   {(char*)"calcExtremes", test_calcExtremes, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
   {(char*)"calcOutsideEdges", test_calcOutsideEdges, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
   {(char*)"buildFaces", test_buildFaces, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
   {(char*)"calcFacingFaces", test_calcFacingFaces, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"planeKernels", test_planeKernels, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"generateHullTrianglesLegacy", test_generateHullTrianglesLegacy, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
   {(char*)"generateHullTriangles", test_generateHullTriangles, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"degenerateHulls", test_degenerateHulls, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"planarHulls", test_planarHulls, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"hullContext", test_hullContext, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"hullContextGetStats", test_hullContextGetStats, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"calcKDopExtremes", test_calcKDopExtremes, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"cullInterior", test_cullInterior, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"generateHullTrianglesParallel", test_generateHullTrianglesParallel, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"generateHullTrianglesBatch", test_generateHullTrianglesBatch, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"hullInsertPoints", test_hullInsertPoints, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"generateHullTrianglesWarm", test_generateHullTrianglesWarm, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"generateCompactHull", test_generateCompactHull, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"generateHullTrianglesBudget", test_generateHullTrianglesBudget, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"hullCache", test_hullCache, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"weldPoints", test_weldPoints, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"generateHullPolygons", test_generateHullPolygons, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"hullContainsPoints", test_hullContainsPoints, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"hullRaycast", test_hullRaycast, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"calcHullOrientedBox", test_calcHullOrientedBox, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  {(char*)"calcHullBoundingSphere", test_calcHullBoundingSphere, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+  { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
 
   // There are some weird out of memory exceptions from wasm when there are an even number of test cases, so add this dummy test as necessary
   // {(char*)"ENDED", test_ENDED, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL }
@@ -3,13 +3,276 @@ import * as hull from "../src/hull.js"
 
 const ascendingFn = (a,b) => a - b
 
-// empscripten version
-// test("hull.generateHullTriangles2", (t) => {
-//   let vertices = [-1,-1,-1, -1,-1,1, -1,1,-1, -1,1,1, 1,-1,-1, 1,-1,1, 1,1,-1, 1,1,1]
-//   t.deepEquals(hull.generateHullTriangles2(vertices), [0,6,12,0,12,3,0,3,6,9,3,15,6,3,9,3,12,15,12,6,18,6,9,18,15,12,18,9,15,21,15,18,21,18,9,21], "cube")
+// a stand-in for the wasm module, which builds the hull with the js version and grows the heap on every malloc
+function createFakeModule() {
+  const c = { HEAPU8: new Uint8Array(64), top: 8, numMallocs: 0 }
 
-//   t.end()
-// })
+  c._malloc = (numBytes) => {
+    numBytes = Math.ceil(numBytes/8)*8 // keep every allocation aligned
+    const ptr = c.top
+    const heap = new Uint8Array(c.HEAPU8.length + numBytes)
+    heap.set(c.HEAPU8)
+    c.HEAPU8 = heap
+    c.top += numBytes
+    c.numMallocs++
+    return ptr
+  }
+  c._free = () => {}
+  c._hullContextCreate = () => 1
+  c._hullContextDestroy = () => {}
+  c.flags = 0
+  c._hullContextSetFlags = (ctx, flags) => c.flags = flags
+  c._hullContextGetFlags = () => c.flags
+  c._hullContextGetStats = () => {
+    c.statsPtr = c.statsPtr || c._malloc(15*8)
+    new Float64Array(c.HEAPU8.buffer, c.statsPtr, 15).set([1,2,3,4,5, 6,7,8,9,10,11,12,13,14,15])
+    return c.statsPtr
+  }
+  c._generateHullTrianglesWithContext = (ctx, outPtr, verticesPtr, numVertices, stride) => {
+    const indices = hull.generateHullTriangles(new Float32Array(c.HEAPU8.buffer, verticesPtr, numVertices), stride)
+    if (!indices) {
+      return -2
+    }
+    new Int32Array(c.HEAPU8.buffer, outPtr, indices.length).set(indices)
+    return indices.length
+  }
+  c._generateCompactHull = (ctx, positionsPtr, outPtr, numHullVerticesPtr, verticesPtr, numVertices, stride) => {
+    const indices = hull.generateHullTriangles(new Float32Array(c.HEAPU8.buffer, verticesPtr, numVertices), stride)
+    if (!indices) {
+      return -2
+    }
+    const compact = hull.compactHullTriangles(new Float32Array(c.HEAPU8.buffer, verticesPtr, numVertices), indices, stride)
+    new Float32Array(c.HEAPU8.buffer, positionsPtr, compact.positions.length).set(compact.positions)
+    new Uint16Array(c.HEAPU8.buffer, outPtr, compact.indices.length).set(compact.indices)
+    new Int32Array(c.HEAPU8.buffer, numHullVerticesPtr, 1)[0] = compact.positions.length/3
+    return indices.length
+  }
+
+  // the cache is a Map from the vertices to the indices, and serializes as JSON
+  c.cache = new Map()
+  c.hits = c.misses = 0
+  c._hullCacheCreate = () => 2
+  c._hullCacheDestroy = () => {}
+  c._hullCacheHits = () => c.hits
+  c._hullCacheMisses = () => c.misses
+  c._hullCacheBytes = () => Array.from(c.cache.values()).reduce((sum, indices) => sum + indices.length*4, 0)
+  c._hullCacheNumEntries = () => c.cache.size
+  c._generateHullTrianglesCached = (cache, ctx, outPtr, verticesPtr, numVertices, stride) => {
+    const key = Array.from(new Float32Array(c.HEAPU8.buffer, verticesPtr, numVertices)).join(",") + "/" + stride
+    const indices = c.cache.get(key)
+    if (!indices) {
+      c.misses++
+      const numIndices = c._generateHullTrianglesWithContext(ctx, outPtr, verticesPtr, numVertices, stride)
+      c.cache.set(key, Array.from(new Int32Array(c.HEAPU8.buffer, outPtr, Math.max(numIndices, 0))))
+      return numIndices
+    }
+    c.hits++
+    new Int32Array(c.HEAPU8.buffer, outPtr, indices.length).set(indices)
+    return indices.length
+  }
+  c._hullCacheSerializedBytes = () => new TextEncoder().encode(JSON.stringify(Array.from(c.cache))).length
+  c._hullCacheSerialize = (cache, outPtr) => {
+    const bytes = new TextEncoder().encode(JSON.stringify(Array.from(c.cache)))
+    c.HEAPU8.set(bytes, outPtr)
+    return bytes.length
+  }
+  c._hullCacheDeserialize = (cache, ptr, numBytes) => {
+    try {
+      const entries = JSON.parse(new TextDecoder().decode(c.HEAPU8.slice(ptr, ptr + numBytes)))
+      entries.forEach(([key, indices]) => c.cache.set(key, indices))
+      return entries.length
+    } catch (e) {
+      return -1
+    }
+  }
+
+  // the bounds are the axis aligned box, and the sphere around it
+  c._calcHullOrientedBox = (outPtr, verticesPtr, indicesPtr, numIndices) => {
+    const vertices = new Float32Array(c.HEAPU8.buffer, verticesPtr)
+    const offsets = new Int32Array(c.HEAPU8.buffer, indicesPtr, numIndices)
+    const min = [0,1,2].map(k => Math.min(...Array.from(offsets, i => vertices[i + k])))
+    const max = [0,1,2].map(k => Math.max(...Array.from(offsets, i => vertices[i + k])))
+    new Float32Array(c.HEAPU8.buffer, outPtr, 15).set([...min.map((x, k) => (x + max[k])/2), 1,0,0, 0,1,0, 0,0,1, ...min.map((x, k) => (max[k] - x)/2)])
+    return 0
+  }
+  c._calcHullBoundingSphere = (outPtr, verticesPtr, indicesPtr, numIndices) => {
+    const box = new Float32Array(15)
+    c._calcHullOrientedBox(outPtr, verticesPtr, indicesPtr, numIndices)
+    box.set(new Float32Array(c.HEAPU8.buffer, outPtr, 15))
+    new Float32Array(c.HEAPU8.buffer, outPtr, 4).set([...box.slice(0, 3), Math.hypot(...box.slice(12, 15))])
+    return 0
+  }
+
+  // a query is one plane per triangle of the js hull, nx, ny, nz, d
+  c.queries = []
+  c._generateHullQuery = (ctx, verticesPtr, numVertices, stride) => {
+    const vertices = new Float32Array(c.HEAPU8.buffer, verticesPtr, numVertices)
+    const indices = hull.generateHullTriangles(vertices, stride)
+    if (!indices) {
+      return 0
+    }
+
+    const planes = []
+    for (let i = 0; i < indices.length; i += 3) {
+      const [a, b, d] = [indices[i], indices[i+1], indices[i+2]].map(j => Array.from(vertices.slice(j, j + 3)))
+      const u = [b[0] - a[0], b[1] - a[1], b[2] - a[2]]
+      const v = [d[0] - a[0], d[1] - a[1], d[2] - a[2]]
+      const n = [u[1]*v[2] - u[2]*v[1], u[2]*v[0] - u[0]*v[2], u[0]*v[1] - u[1]*v[0]]
+      const length = Math.hypot(...n)
+      const normal = n.map(x => x/length)
+      planes.push([...normal, normal[0]*a[0] + normal[1]*a[1] + normal[2]*a[2]])
+    }
+
+    c.queries.push(planes)
+    return c.queries.length
+  }
+  c._hullQueryDestroy = () => {}
+  c._hullQueryNumPlanes = (query) => c.queries[query - 1].length
+  c._hullContainsPoints = (query, pointsPtr, numPoints, outPtr) => {
+    const points = new Float32Array(c.HEAPU8.buffer, pointsPtr, numPoints*3)
+    const mask = new Uint8Array(c.HEAPU8.buffer, outPtr, numPoints)
+    for (let i = 0; i < numPoints; i++) {
+      mask[i] = c.queries[query - 1].every(([nx, ny, nz, d]) => nx*points[i*3] + ny*points[i*3+1] + nz*points[i*3+2] - d <= 0) ? 1 : 0
+    }
+    return mask.reduce((sum, x) => sum + x, 0)
+  }
+  c._hullRaycast = (query, raysPtr, numRays, outTPtr, outFacePtr) => {
+    const rays = new Float32Array(c.HEAPU8.buffer, raysPtr, numRays*6)
+    const outT = new Float32Array(c.HEAPU8.buffer, outTPtr, numRays)
+    const outFaces = new Int32Array(c.HEAPU8.buffer, outFacePtr, numRays)
+    for (let r = 0; r < numRays; r++) {
+      const [ox, oy, oz, dx, dy, dz] = rays.slice(r*6, r*6 + 6)
+      let enter = 0, exit = Infinity, face = -1
+      c.queries[query - 1].forEach(([nx, ny, nz, d], i) => {
+        const distance = nx*ox + ny*oy + nz*oz - d
+        const dot = nx*dx + ny*dy + nz*dz
+        if (dot < 0 && -distance/dot > enter) {
+          enter = -distance/dot, face = i
+        } else if (dot > 0) {
+          exit = Math.min(exit, -distance/dot)
+        } else if (dot === 0 && distance > 0) {
+          exit = -Infinity
+        }
+      })
+      outT[r] = enter <= exit ? enter : -1
+      outFaces[r] = enter <= exit ? face : -1
+    }
+  }
+
+  return c
+}
+
+test("hull.createHullBinding", (t) => {
+  const c = createFakeModule()
+  const binding = hull.createHullBinding(c)
+  const box = [-1,-1,-1, -1,-1,1, -1,1,1, -1,1,-1, 1,-1,-1, 1,-1,1, 1,1,1, 1,1,-1]
+
+  binding.setVertices(box)
+  const indices = binding.generateHullTriangles(box.length)
+  t.ok(indices instanceof Int32Array && indices.buffer === c.HEAPU8.buffer, "view into the heap")
+  t.deepEquals(Array.from(indices), hull.generateHullTriangles(box), "box hull")
+
+  const copy = binding.generateHullTriangles(box.length, 3, true)
+  t.ok(copy.buffer !== c.HEAPU8.buffer, "copy has its own buffer")
+  t.deepEquals(Array.from(copy), Array.from(indices), "copy matches")
+
+  const numMallocs = c.numMallocs
+  const view = binding.getVertices(box.length)
+  view.set(box)
+  binding.generateHullTriangles(box.length)
+  t.equals(c.numMallocs, numMallocs, "no allocations once the buffers are big enough")
+
+  const vertices = Array.from({length: 3000}, () => Math.random()*2 - 1)
+  const view2 = binding.getVertices(vertices.length)
+  t.ok(view2.buffer === c.HEAPU8.buffer, "view refreshed after the heap grows")
+  view2.set(vertices)
+  t.deepEquals(Array.from(binding.generateHullTriangles(vertices.length)), hull.generateHullTriangles(Float32Array.from(vertices)), "larger hull")
+
+  binding.setVertices(box)
+  const compact = binding.generateCompactHull(box.length)
+  t.ok(compact.indices instanceof Uint16Array && compact.positions.length === 24, "compact box")
+  t.deepEquals(Array.from(compact.indices), Array.from(hull.compactHullTriangles(box, indices).indices), "compact indices")
+
+  binding.setVertices(box)
+  const query = binding.createQuery(box.length)
+  t.ok(query.numPlanes > 0, "query planes")
+  const mask = query.containsPoints(Float32Array.from([0,0,0, .5,-.5,1, 2,0,0, 0,-1.5,0]))
+  t.ok(mask instanceof Uint8Array && mask.buffer === c.HEAPU8.buffer, "mask is a view into the heap")
+  t.deepEquals(Array.from(mask), [1,1,0,0], "points in the box")
+  const hits = query.raycast(Float32Array.from([-5,0,0, 1,0,0, 0,0,0, 0,1,0, -5,0,0, 0,1,0, 0,0,3, 0,0,-2]))
+  t.deepEquals(Array.from(hits.t), [4,0,-1,1], "ray t")
+  t.deepEquals(Array.from(hits.faces).map(face => face >= 0), [true,false,false,true], "ray faces")
+  query.destroy()
+
+  binding.setVertices(box.map((x, i) => i % 3 === 0 ? x*2 + 1 : x))
+  const bounds = binding.calcBounds(box.length)
+  t.deepEquals(Array.from(bounds.box.center), [1,0,0], "box center")
+  t.deepEquals(Array.from(bounds.box.axes), [1,0,0, 0,1,0, 0,0,1], "box axes")
+  t.deepEquals(Array.from(bounds.box.halfExtents), [2,1,1], "box half extents")
+  t.ok(bounds.box.center.buffer !== c.HEAPU8.buffer, "bounds are copies")
+  t.deepEquals(Array.from(bounds.sphere.center), [1,0,0], "sphere center")
+  t.ok(Math.abs(bounds.sphere.radius - Math.sqrt(6)) < 1e-6, "sphere radius")
+
+  binding.setVertices([0,0,0, 1,0,0, 0,1,0, 1,1,0])
+  t.equals(binding.generateHullTriangles(12), undefined, "a plane")
+  t.equals(binding.createQuery(12), undefined, "no query for a plane")
+  t.equals(binding.calcBounds(12), undefined, "no bounds for a plane")
+
+  c.flags = 1
+  binding.setCollectStats(true)
+  t.equals(c.flags, 3, "stats flag added")
+  binding.setCollectStats(false)
+  t.equals(c.flags, 1, "stats flag removed")
+  const stats = binding.getStats()
+  t.equals(stats.extremesSeconds, 1, "first stat")
+  t.equals(stats.numPoints, 6, "first count")
+  t.equals(stats.maxHorizonEdges, 15, "last stat")
+
+  binding.destroy()
+  t.end()
+})
+
+test("hull.createHullBinding cache", (t) => {
+  const c = createFakeModule()
+  const binding = hull.createHullBinding(c, 1 << 20)
+  const box = [-1,-1,-1, -1,-1,1, -1,1,1, -1,1,-1, 1,-1,-1, 1,-1,1, 1,1,1, 1,1,-1]
+
+  binding.setVertices(box)
+  const indices = binding.generateHullTriangles(box.length, 3, true)
+  t.deepEquals(Array.from(binding.generateHullTriangles(box.length)), Array.from(indices), "cached box")
+  t.deepEquals(binding.getCacheStats(), { hits: 1, misses: 1, bytes: indices.length*4, entries: 1 }, "one hit, one miss")
+
+  const saved = binding.saveCache()
+  t.ok(saved instanceof Uint8Array && saved.buffer !== c.HEAPU8.buffer, "saved cache has its own buffer")
+
+  const c2 = createFakeModule()
+  const binding2 = hull.createHullBinding(c2, 1 << 20)
+  t.equals(binding2.loadCache(saved), 1, "loaded one hull")
+  binding2.setVertices(box)
+  t.deepEquals(Array.from(binding2.generateHullTriangles(box.length)), Array.from(indices), "box from the loaded cache")
+  t.equals(binding2.getCacheStats().hits, 1, "hit after loading")
+  t.throws(() => binding2.loadCache(new Uint8Array([1,2,3])), /not a hull cache/, "bad cache")
+
+  const uncached = hull.createHullBinding(c)
+  t.deepEquals(uncached.getCacheStats(), { hits: 0, misses: 0, bytes: 0, entries: 0 }, "no cache")
+  t.throws(() => uncached.saveCache(), /no hull cache/, "nothing to save")
+
+  binding.destroy()
+  binding2.destroy()
+  uncached.destroy()
+  t.end()
+})
+
+test("hull.compactHullTriangles", (t) => {
+  const vertices = [9,9,9, 0,0,0, 1,0,0, 0,1,0, 0,0,1]
+  const compact = hull.compactHullTriangles(vertices, [6,3,9, 3,6,12, 12,9,3, 9,12,6])
+
+  t.deepEquals(Array.from(compact.positions), [1,0,0, 0,0,0, 0,1,0, 0,0,1], "positions in order of first use")
+  t.ok(compact.indices instanceof Uint16Array, "16 bit indices")
+  t.deepEquals(Array.from(compact.indices), [0,1,2, 1,0,3, 3,2,1, 2,3,0], "remapped indices")
+
+  t.end()
+})
 
 test("hull.generateTriangles", (t) => {
   const unique = (x,i,list) => i === 0 || list[i-1] !== x
@@ -0,0 +1,289 @@
+// hulls a binary point file a chunk at a time and writes the hull as OBJ, so files larger than memory can be
+// hulled. After each chunk the points inside the hull are dropped, so memory grows with the hull, not the file
+// usage: hull-stream [--format raw|ply] [--chunk N] input [output.obj]
+//   raw is packed little-endian float32 x, y, z. ply is a binary PLY whose first element is the vertex element,
+//   with float or double x, y and z properties. The format defaults to ply for .ply files, and raw otherwise
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "../src/hull.c"
+
+#define MAX_PLY_LINE (1024)
+
+static double now() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+static long peakRSSKiB() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return usage.ru_maxrss/1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+typedef enum { RAW, PLY } Format;
+
+typedef struct {
+  FILE* file;
+  bool isBigEndian;
+  long long numPoints; // points left to read, -1 for the rest of the file
+  int recordSize; // bytes per point
+  int offsets[3]; // of x, y and z in a record
+  int sizes[3]; // 4 for float, 8 for double
+} PointReader;
+
+static bool isLittleEndianHost() {
+  const uint16_t one = 1;
+  return *(const uint8_t*)&one == 1;
+}
+
+static int plyTypeSize(const char* type) {
+  static const char* TYPES[] = { "char", "uchar", "short", "ushort", "int", "uint", "float", "double",
+    "int8", "uint8", "int16", "uint16", "int32", "uint32", "float32", "float64" };
+  static const int SIZES[] = { 1, 1, 2, 2, 4, 4, 4, 8, 1, 1, 2, 2, 4, 4, 4, 8 };
+
+  for (int i = 0; i < (int)(sizeof(SIZES)/sizeof(SIZES[0])); i++) {
+    if (strcmp(type, TYPES[i]) == 0) {
+      return SIZES[i];
+    }
+  }
+
+  return 0;
+}
+
+// reads the header up to end_header. Returns an error message, or NULL
+static const char* readPlyHeader(PointReader* reader) {
+  char line[MAX_PLY_LINE];
+  char word[3][64];
+  int numElements = 0;
+  bool isVertexElement = false;
+  bool hasFormat = false;
+
+  reader->numPoints = 0;
+  reader->recordSize = 0;
+  reader->sizes[0] = reader->sizes[1] = reader->sizes[2] = 0;
+
+  if (fgets(line, sizeof(line), reader->file) == NULL || strncmp(line, "ply", 3) != 0) {
+    return "not a PLY file";
+  }
+
+  while (fgets(line, sizeof(line), reader->file)) {
+    const int numWords = sscanf(line, "%63s %63s %63s", word[0], word[1], word[2]);
+
+    if (numWords >= 1 && strcmp(word[0], "end_header") == 0) {
+      break;
+    } else if (numWords == 3 && strcmp(word[0], "format") == 0) {
+      if (strcmp(word[1], "binary_little_endian") != 0 && strcmp(word[1], "binary_big_endian") != 0) {
+        return "only binary PLY files are supported";
+      }
+      reader->isBigEndian = strcmp(word[1], "binary_big_endian") == 0;
+      hasFormat = true;
+    } else if (numWords == 3 && strcmp(word[0], "element") == 0) {
+      isVertexElement = numElements++ == 0 && strcmp(word[1], "vertex") == 0;
+      if (isVertexElement) {
+        reader->numPoints = atoll(word[2]);
+      }
+    } else if (numWords >= 3 && strcmp(word[0], "property") == 0 && isVertexElement) {
+      const int size = plyTypeSize(word[1]);
+      if (size == 0) {
+        return "unsupported vertex property type, list properties are not supported";
+      }
+
+      for (int axis = 0; axis < 3; axis++) {
+        if (strcmp(word[2], (const char*[]){ "x", "y", "z" }[axis]) == 0) {
+          if (strcmp(word[1], "float") != 0 && strcmp(word[1], "float32") != 0 && strcmp(word[1], "double") != 0 && strcmp(word[1], "float64") != 0) {
+            return "x, y and z must be float or double";
+          }
+          reader->offsets[axis] = reader->recordSize;
+          reader->sizes[axis] = size;
+        }
+      }
+
+      reader->recordSize += size;
+    }
+  }
+
+  if (!hasFormat) {
+    return "missing PLY format";
+  } else if (reader->sizes[0] == 0 || reader->sizes[1] == 0 || reader->sizes[2] == 0) {
+    return "the first PLY element must be the vertices, with x, y and z";
+  }
+
+  return NULL;
+}
+
+static void openRawReader(PointReader* reader) {
+  reader->isBigEndian = false;
+  reader->numPoints = -1;
+  reader->recordSize = 3*sizeof(float);
+
+  for (int axis = 0; axis < 3; axis++) {
+    reader->offsets[axis] = axis*sizeof(float);
+    reader->sizes[axis] = sizeof(float);
+  }
+}
+
+static float readCoord(const uint8_t* bytes, const int size, const bool swap) {
+  uint8_t value[8];
+  for (int i = 0; i < size; i++) {
+    value[i] = swap ? bytes[size - 1 - i] : bytes[i];
+  }
+
+  if (size == sizeof(double)) {
+    double d;
+    memcpy(&d, value, sizeof(d));
+    return (float)d;
+  }
+
+  float f;
+  memcpy(&f, value, sizeof(f));
+  return f;
+}
+
+// reads up to maxPoints into outPoints as packed x, y, z floats. Returns the number read, or -1 if the file
+// ends part way through a point
+static int readPoints(PointReader* reader, float* outPoints, uint8_t* buffer, int maxPoints) {
+  if (reader->numPoints >= 0 && reader->numPoints < maxPoints) {
+    maxPoints = (int)reader->numPoints;
+  }
+
+  const size_t numBytes = fread(buffer, 1, (size_t)maxPoints*reader->recordSize, reader->file);
+  const int numPoints = (int)(numBytes/reader->recordSize);
+  const bool swap = reader->isBigEndian == isLittleEndianHost();
+
+  if (numBytes % reader->recordSize != 0 || (numPoints < maxPoints && reader->numPoints > 0)) {
+    return -1;
+  }
+
+  for (int i = 0; i < numPoints; i++) {
+    const uint8_t* record = buffer + (size_t)i*reader->recordSize;
+    for (int axis = 0; axis < 3; axis++) {
+      outPoints[i*3 + axis] = readCoord(record + reader->offsets[axis], reader->sizes[axis], swap);
+    }
+  }
+
+  if (reader->numPoints > 0) {
+    reader->numPoints -= numPoints;
+  }
+
+  return numPoints;
+}
+
+static void writeObj(FILE* file, const Hull* hull, const int* indices, const int numIndices) {
+  const float* vertices = hullGetVertices(hull);
+
+  for (int i = 0; i < hullNumVertices(hull); i += FLOATS_PER_VERTEX) {
+    fprintf(file, "v %.9g %.9g %.9g\n", vertices[i], vertices[i+1], vertices[i+2]);
+  }
+
+  for (int i = 0; i < numIndices; i += 3) {
+    fprintf(file, "f %d %d %d\n", indices[i]/FLOATS_PER_VERTEX + 1, indices[i+1]/FLOATS_PER_VERTEX + 1, indices[i+2]/FLOATS_PER_VERTEX + 1);
+  }
+}
+
+int main(int argc, char** argv) {
+  const char* inputName = NULL;
+  const char* outputName = NULL;
+  int chunkPoints = 1 << 20;
+  int format = -1;
+
+  for (int i = 1; i < argc; i++) {
+    const char* value = i + 1 < argc ? argv[i + 1] : "";
+    if (strcmp(argv[i], "--chunk") == 0) chunkPoints = atoi(value), i++;
+    else if (strcmp(argv[i], "--format") == 0) format = strcmp(value, "ply") == 0 ? PLY : strcmp(value, "raw") == 0 ? RAW : -2, i++;
+    else if (inputName == NULL) inputName = argv[i];
+    else if (outputName == NULL) outputName = argv[i];
+    else format = -2;
+  }
+
+  if (inputName == NULL || format == -2 || chunkPoints < 4) {
+    fprintf(stderr, "usage: hull-stream [--format raw|ply] [--chunk N] input [output.obj]\n");
+    return 1;
+  }
+
+  if (format == -1) {
+    const size_t length = strlen(inputName);
+    format = length > 4 && strcmp(inputName + length - 4, ".ply") == 0 ? PLY : RAW;
+  }
+
+  PointReader reader = { .file = fopen(inputName, "rb") };
+  if (reader.file == NULL) {
+    fprintf(stderr, "unable to open %s\n", inputName);
+    return 1;
+  }
+
+  if (format == RAW) {
+    openRawReader(&reader);
+  } else {
+    const char* error = readPlyHeader(&reader);
+    if (error) {
+      fprintf(stderr, "%s: %s\n", inputName, error);
+      fclose(reader.file);
+      return 1;
+    }
+  }
+
+  float* points = malloc((size_t)chunkPoints*3*sizeof(float));
+  uint8_t* buffer = malloc((size_t)chunkPoints*reader.recordSize);
+  Hull* hull = hullCreate(HULL_CULL_INTERIOR);
+  if (points == NULL || buffer == NULL || hull == NULL) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+
+  const double start = now();
+  long long totalPoints = 0;
+  int result = -1;
+  int numPoints = 0;
+
+  while ((numPoints = readPoints(&reader, points, buffer, chunkPoints)) > 0) {
+    totalPoints += numPoints;
+    result = hullInsertPoints(hull, points, numPoints*3, 3);
+    if (result == -3) {
+      break;
+    }
+    hullCompact(hull);
+  }
+
+  fclose(reader.file);
+  free(points);
+  free(buffer);
+
+  const int numIndices = hullNumIndices(hull);
+  int* indices = malloc(numIndices*sizeof(int));
+  FILE* output = NULL;
+  int status = 1;
+
+  if (numPoints < 0) {
+    fprintf(stderr, "%s: the file ends part way through a point\n", inputName);
+  } else if (result < 0) {
+    fprintf(stderr, "%s: %s\n", inputName, result == -1 ? "not enough points" : result == -2 ? "the points are collinear" : "out of memory");
+  } else if (indices == NULL) {
+    fprintf(stderr, "out of memory\n");
+  } else if ((output = outputName ? fopen(outputName, "w") : stdout) == NULL) {
+    fprintf(stderr, "unable to open %s\n", outputName);
+  } else {
+    hullGetTriangles(hull, indices);
+    writeObj(output, hull, indices, numIndices);
+    status = 0;
+
+    fprintf(stderr, "%lld points, %d hull vertices, %d triangles, %.3f seconds, peak RSS %ld KiB\n",
+      totalPoints, hullNumVertices(hull)/FLOATS_PER_VERTEX, numIndices/3, now() - start, peakRSSKiB());
+  }
+
+  if (output != NULL && output != stdout) {
+    fclose(output);
+  }
+
+  free(indices);
+  hullDestroy(hull);
+  return status;
+}